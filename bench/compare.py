@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Compares two tsmath_bench --json reports and flags performance regressions.
+
+    compare.py BASELINE CURRENT [--threshold 0.10] [--min-ms 0.05] [--metric best_ms|median_ms]
+
+A benchmark regresses when its time grew by more than the threshold (a fraction, 10% by default)
+over the baseline. The best time is compared by default, being the least disturbed by other load on
+the machine. Timings below --min-ms in both reports are too noisy to judge and are only listed.
+Exits with 1 when anything regressed, 2 on unusable input.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    try:
+        with open(path) as f:
+            report = json.load(f)
+    except (OSError, ValueError) as error:
+        sys.exit("compare.py: cannot read %s: %s" % (path, error))
+    if report.get("schema") != 1:
+        sys.exit("compare.py: %s has an unknown schema" % path)
+    return report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10)
+    parser.add_argument("--min-ms", type=float, default=0.05)
+    parser.add_argument("--metric", choices=("best_ms", "median_ms"), default="best_ms")
+    args = parser.parse_args()
+
+    baseline, current = load(args.baseline), load(args.current)
+    for key in ("build_type", "isa", "threads"):
+        if baseline.get(key) != current.get(key):
+            print("warning: %s differs (baseline %s, current %s), timings may not be comparable"
+                  % (key, baseline.get(key), current.get(key)))
+
+    reference = {(r["name"], r["size"]): r for r in baseline["results"]}
+    regressions = improvements = 0
+    print("%-22s %8s %12s %12s %8s" % ("benchmark", "size", "base[ms]", "now[ms]", "change"))
+    for result in current["results"]:
+        key = (result["name"], result["size"])
+        before = reference.pop(key, None)
+        if before is None:
+            print("%-22s %8d %12s %12.4f %8s" % (key[0], key[1], "-", result[args.metric], "new"))
+            continue
+        old, new = before[args.metric], result[args.metric]
+        change = new / old - 1.0 if old > 0 else 0.0
+        verdict = ""
+        if max(old, new) < args.min_ms:
+            verdict = "(noise)"
+        elif change > args.threshold:
+            verdict = "REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            verdict = "faster"
+            improvements += 1
+        print("%-22s %8d %12.4f %12.4f %+7.1f%% %s" % (key[0], key[1], old, new, 100.0 * change, verdict))
+    for name, size in sorted(reference):
+        print("%-22s %8d %12s %12s %8s" % (name, size, "", "-", "missing"))
+
+    print("%d regression(s), %d improvement(s) beyond %.0f%%" % (regressions, improvements, 100.0 * args.threshold))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,86 @@
+// Compares the contiguous MATRIX storage against the previous
+// std::vector<std::vector<double>> layout for construction, copy and operator*.
+#include "../include/matrix.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    // The previous storage layout, one heap allocation per row.
+    using Nested = std::vector<std::vector<double>>;
+
+    Nested nested_multiply(const Nested &A, const Nested &B)
+    {
+        size_t n = A.size(), m = B.size(), p = B.empty() ? 0 : B[0].size();
+        Nested C(n, std::vector<double>(p, 0.0));
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t k = 0; k < m; k++)
+            {
+                const double a_ik = A[i][k];
+                for (size_t j = 0; j < p; j++)
+                {
+                    C[i][j] += a_ik * B[k][j];
+                }
+            }
+        }
+        return C;
+    }
+
+    template <typename F>
+    double best_of(int repeats, F &&body)
+    {
+        double best = 1e300;
+        for (int r = 0; r < repeats; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            best = elapsed.count() < best ? elapsed.count() : best;
+        }
+        return best;
+    }
+
+    // Keeps results observable so the timed work is not optimised away.
+    volatile double sink;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<size_t> sizes = {64, 256, 512, 1000};
+    if (argc > 1)
+    {
+        sizes.assign(1, std::strtoul(argv[1], nullptr, 10));
+    }
+
+    std::printf("%6s %-10s %12s %12s %8s\n", "n", "op", "nested[ms]", "MATRIX[ms]", "speedup");
+    for (size_t n : sizes)
+    {
+        int repeats = n <= 256 ? 10 : 3;
+
+        Nested nested(n, std::vector<double>(n));
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < n; j++)
+            {
+                nested[i][j] = double((i * 31 + j * 17) % 97) / 97.0;
+            }
+        }
+        MATRIX contiguous(nested);
+
+        double t_old = best_of(repeats, [&] { Nested x(n, std::vector<double>(n, 0.0)); sink = x[n - 1][n - 1]; });
+        double t_new = best_of(repeats, [&] { MATRIX x(n, n); sink = x(n - 1, n - 1); });
+        std::printf("%6zu %-10s %12.3f %12.3f %7.2fx\n", n, "construct", t_old, t_new, t_old / t_new);
+
+        t_old = best_of(repeats, [&] { Nested x(nested); sink = x[n - 1][n - 1]; });
+        t_new = best_of(repeats, [&] { MATRIX x(contiguous); sink = x(n - 1, n - 1); });
+        std::printf("%6zu %-10s %12.3f %12.3f %7.2fx\n", n, "copy", t_old, t_new, t_old / t_new);
+
+        t_old = best_of(repeats, [&] { Nested x = nested_multiply(nested, nested); sink = x[n - 1][n - 1]; });
+        t_new = best_of(repeats, [&] { MATRIX x = contiguous * contiguous; sink = x(n - 1, n - 1); });
+        std::printf("%6zu %-10s %12.3f %12.3f %7.2fx\n", n, "multiply", t_old, t_new, t_old / t_new);
+    }
+    return 0;
+}
@@ -0,0 +1,424 @@
+// Throughput of the main tsmath kernels over a sweep of sizes: Vector operations, MATRIX::operator*,
+// transposes, the TSA polynomial routines and the lin_alg.h factorizations and solvers.
+// Prints a table and optionally writes JSON for bench/compare.py:
+//   tsmath_bench [--json FILE] [--filter SUBSTRING] [--quick] [--repeats N]
+#include "../include/blas.h"
+#include "../include/lin_alg.h"
+#include "../include/matrix.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include "../include/vector.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef TSMATH_BENCH_BUILD_TYPE
+#define TSMATH_BENCH_BUILD_TYPE "unknown"
+#endif
+
+namespace
+{
+    // Timed runs stop after this many milliseconds once the minimum number of runs is reached.
+    constexpr double TIME_BUDGET_MS = 1000.0;
+    constexpr int MIN_RUNS = 3;
+
+    struct Settings
+    {
+        const char *json = nullptr;
+        const char *filter = nullptr;
+        bool quick = false;
+        int repeats = 9;
+    };
+
+    struct Result
+    {
+        std::string name;
+        size_t size;
+        int runs;
+        double best_ms, median_ms;
+
+        // Operation and memory traffic counts per run, 0 when not meaningful.
+        double flops, bytes;
+    };
+
+    Settings settings;
+    std::vector<Result> results;
+
+    // Keeps results observable so the timed work is not optimised away.
+    volatile double sink;
+
+    bool wanted(const char *name)
+    {
+        return settings.filter == nullptr || std::strstr(name, settings.filter) != nullptr;
+    }
+
+    std::vector<size_t> sweep(std::vector<size_t> sizes, size_t quick_limit)
+    {
+        if (settings.quick)
+        {
+            sizes.erase(std::remove_if(sizes.begin(), sizes.end(), [=](size_t n) { return n > quick_limit; }),
+                        sizes.end());
+        }
+        return sizes;
+    }
+
+    // Times run() after prepare(), which is not timed, over a warm-up run plus up to settings.repeats
+    // runs, and records the best and median times. flops and bytes are the nominal counts of one run.
+    void measure(const char *name, size_t size, double flops, double bytes, const std::function<void()> &prepare,
+                 const std::function<void()> &run)
+    {
+        prepare();
+        run();
+        std::vector<double> times;
+        double total = 0.0;
+        while (times.size() < static_cast<size_t>(settings.repeats) &&
+               (times.size() < MIN_RUNS || total < TIME_BUDGET_MS))
+        {
+            prepare();
+            auto start = std::chrono::steady_clock::now();
+            run();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            times.push_back(elapsed.count());
+            total += elapsed.count();
+        }
+        std::sort(times.begin(), times.end());
+        Result result{name, size, static_cast<int>(times.size()), times.front(), times[times.size() / 2], flops, bytes};
+        results.push_back(result);
+
+        std::printf("%-22s %8zu %11.4f %11.4f", name, size, result.median_ms, result.best_ms);
+        if (flops > 0.0)
+        {
+            std::printf(" %9.2f", flops / (result.median_ms * 1e6));
+        }
+        else
+        {
+            std::printf(" %9s", "-");
+        }
+        if (bytes > 0.0)
+        {
+            std::printf(" %9.2f", bytes / (result.median_ms * 1e6));
+        }
+        else
+        {
+            std::printf(" %9s", "-");
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    void measure(const char *name, size_t size, double flops, double bytes, const std::function<void()> &run)
+    {
+        measure(name, size, flops, bytes, [] {}, run);
+    }
+
+    // Deterministic, well-conditioned test data.
+    MATRIX filled(size_t rows, size_t columns)
+    {
+        MATRIX A(rows, columns);
+        for (size_t i = 0; i < rows; i++)
+        {
+            for (size_t j = 0; j < columns; j++)
+            {
+                A(i, j) = double((i * 31 + j * 17) % 97) / 97.0 - 0.5;
+            }
+        }
+        return A;
+    }
+
+    Vector filled(size_t n)
+    {
+        Vector v(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            v[i] = double((i * 37) % 101) / 101.0 - 0.5;
+        }
+        return v;
+    }
+
+    // Diagonally dominant and symmetric positive definite inputs, so every solver sees a well-conditioned system.
+    MATRIX dominant(size_t n)
+    {
+        MATRIX A = filled(n, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            A(i, i) += double(n);
+        }
+        return A;
+    }
+
+    MATRIX spd(size_t n)
+    {
+        MATRIX A = filled(n, n);
+        MATRIX S = A.transpose() * A;
+        for (size_t i = 0; i < n; i++)
+        {
+            S(i, i) += double(n);
+        }
+        return S;
+    }
+
+    void vector_benchmarks()
+    {
+        for (size_t n : sweep({1 << 10, 1 << 16, 1 << 20}, 1 << 16))
+        {
+            const double d = double(n);
+            Vector x = filled(n), y = filled(n), z(n);
+            if (wanted("vector_add"))
+            {
+                measure("vector_add", n, d, 24 * d, [&] { z = x + y; sink = z[0]; });
+            }
+            if (wanted("vector_axpy"))
+            {
+                measure("vector_axpy", n, 2 * d, 24 * d, [&] { y += x * 1e-9; sink = y[0]; });
+            }
+            if (wanted("vector_dot"))
+            {
+                measure("vector_dot", n, 2 * d, 16 * d, [&] { sink = x * y; });
+            }
+        }
+    }
+
+    void matrix_benchmarks()
+    {
+        for (size_t n : sweep({64, 256, 512, 1024}, 256))
+        {
+            const double d = double(n);
+            MATRIX A = filled(n, n), B = filled(n, n);
+            if (wanted("matrix_multiply"))
+            {
+                measure("matrix_multiply", n, 2 * d * d * d, 24 * d * d, [&] {
+                    MATRIX C = A * B;
+                    sink = C(0, 0);
+                });
+            }
+            if (wanted("matrix_add"))
+            {
+                MATRIX C(n, n);
+                measure("matrix_add", n, d * d, 24 * d * d, [&] { C = A + B; sink = C(0, 0); });
+            }
+        }
+        for (size_t n : sweep({256, 1024, 4096}, 1024))
+        {
+            const double d = double(n);
+            MATRIX A = filled(n, n);
+            if (wanted("transpose"))
+            {
+                measure("transpose", n, 0.0, 16 * d * d, [&] {
+                    MATRIX T = A.transpose();
+                    sink = T(0, 0);
+                });
+            }
+            if (wanted("transpose_in_place"))
+            {
+                measure("transpose_in_place", n, 0.0, 16 * d * d, [&] {
+                    A.transpose_in_place();
+                    sink = A(0, 0);
+                });
+            }
+        }
+    }
+
+    void polynomial_benchmarks()
+    {
+        for (size_t n : sweep({64, 1024, 16384, 262144}, 16384))
+        {
+            const double d = double(n);
+            Vector u = filled(n), v = filled(n);
+            if (wanted("convolution"))
+            {
+                measure("convolution", n, 0.0, 8 * 4 * d, [&] {
+                    Vector w = TSA::convolution(u, v);
+                    sink = w[0];
+                });
+            }
+            if (wanted("polynomial_division"))
+            {
+                // Degree 2n by degree n, with a leading coefficient well away from zero
+                Vector p = filled(2 * n);
+                v[0] = 1.0;
+                measure("polynomial_division", n, 0.0, 8 * 4 * d, [&] {
+                    Vector q = TSA::polynomial_division(p, v);
+                    sink = q[0];
+                });
+            }
+        }
+    }
+
+    // Nominal LAPACK operation counts of the dense algorithms, whatever the path actually taken.
+    void solver_benchmarks()
+    {
+        for (size_t n : sweep({64, 128, 256, 512}, 128))
+        {
+            const double d = double(n), cube = d * d * d, matrix_bytes = 8 * d * d;
+            MATRIX A = dominant(n), S = spd(n);
+            Vector b = filled(n);
+            if (wanted("lu"))
+            {
+                measure("lu", n, 2 * cube / 3, matrix_bytes, [&] {
+                    factorization::LU lu(A);
+                    sink = lu.packed()(0, 0);
+                });
+            }
+            if (wanted("lu_solve"))
+            {
+                factorization::LU lu(A);
+                measure("lu_solve", n, 2 * d * d, matrix_bytes, [&] {
+                    Vector x = lu.solve(b);
+                    sink = x[0];
+                });
+            }
+            if (wanted("cholesky"))
+            {
+                measure("cholesky", n, cube / 3, matrix_bytes, [&] {
+                    factorization::Cholesky cholesky(S);
+                    sink = cholesky.upper()(0, 0);
+                });
+            }
+            if (wanted("gpp"))
+            {
+                measure("gpp", n, 2 * cube / 3, matrix_bytes, [&] {
+                    Vector x = lin_systems::gpp(A, b);
+                    sink = x[0];
+                });
+            }
+            if (wanted("inverse"))
+            {
+                measure("inverse", n, 2 * cube, 2 * matrix_bytes, [&] {
+                    MATRIX X = lin_systems::inverse(A);
+                    sink = X(0, 0);
+                });
+            }
+            if (wanted("qr"))
+            {
+                measure("qr", n, 4 * cube / 3, 3 * matrix_bytes, [&] {
+                    auto qr = factorization::qr(A);
+                    sink = qr.second(0, 0);
+                });
+            }
+            if (wanted("symmetric_eigenvalues"))
+            {
+                measure("symmetric_eigenvalues", n, 4 * cube / 3, matrix_bytes, [&] {
+                    Vector values = eigen::eigen_values(S);
+                    sink = values[0];
+                });
+            }
+            if (wanted("singular_values"))
+            {
+                measure("singular_values", n, 8 * cube / 3, matrix_bytes, [&] {
+                    Vector values = svd::singular_values(A);
+                    sink = values[0];
+                });
+            }
+        }
+    }
+
+    const char *isa_name(simd::isa target)
+    {
+        switch (target)
+        {
+        case simd::isa::avx512:
+            return "avx512";
+        case simd::isa::avx2:
+            return "avx2";
+        default:
+            return "scalar";
+        }
+    }
+
+    void write_number(std::FILE *out, double value)
+    {
+        if (std::isfinite(value) && value > 0.0)
+        {
+            std::fprintf(out, "%.6g", value);
+        }
+        else
+        {
+            std::fprintf(out, "null");
+        }
+    }
+
+    bool write_json(const char *path)
+    {
+        std::FILE *out = std::fopen(path, "w");
+        if (out == nullptr)
+        {
+            std::fprintf(stderr, "tsmath_bench: cannot write %s\n", path);
+            return false;
+        }
+        std::fprintf(out, "{\n  \"schema\": 1,\n  \"build_type\": \"%s\",\n  \"isa\": \"%s\",\n  \"threads\": %zu,\n",
+                     TSMATH_BENCH_BUILD_TYPE, isa_name(simd::active_isa()), parallel::thread_count());
+        std::fprintf(out, "  \"results\": [\n");
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result &r = results[i];
+            std::fprintf(out, "    {\"name\": \"%s\", \"size\": %zu, \"runs\": %d, \"median_ms\": %.6g, \"best_ms\": %.6g, ",
+                         r.name.c_str(), r.size, r.runs, r.median_ms, r.best_ms);
+            std::fprintf(out, "\"gflops\": ");
+            write_number(out, r.flops / (r.median_ms * 1e6));
+            std::fprintf(out, ", \"gbytes_per_s\": ");
+            write_number(out, r.bytes / (r.median_ms * 1e6));
+            std::fprintf(out, "}%s\n", i + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(out, "  ]\n}\n");
+        return std::fclose(out) == 0;
+    }
+
+    bool parse(int argc, char **argv)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const bool has_value = i + 1 < argc;
+            if (std::strcmp(argv[i], "--json") == 0 && has_value)
+            {
+                settings.json = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--filter") == 0 && has_value)
+            {
+                settings.filter = argv[++i];
+            }
+            else if (std::strcmp(argv[i], "--repeats") == 0 && has_value)
+            {
+                settings.repeats = std::max(MIN_RUNS, std::atoi(argv[++i]));
+            }
+            else if (std::strcmp(argv[i], "--quick") == 0)
+            {
+                settings.quick = true;
+            }
+            else
+            {
+                std::fprintf(stderr, "usage: %s [--json FILE] [--filter SUBSTRING] [--quick] [--repeats N]\n",
+                             argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse(argc, argv))
+    {
+        return 2;
+    }
+
+    std::printf("tsmath_bench: %s build, %s kernels, %zu threads\n", TSMATH_BENCH_BUILD_TYPE,
+                isa_name(simd::active_isa()), parallel::thread_count());
+    std::printf("%-22s %8s %11s %11s %9s %9s\n", "benchmark", "size", "median[ms]", "best[ms]", "GFLOP/s", "GB/s");
+    vector_benchmarks();
+    matrix_benchmarks();
+    polynomial_benchmarks();
+    solver_benchmarks();
+
+    if (settings.json != nullptr && !write_json(settings.json))
+    {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Owning, cache-line aligned, zero-initialised block of T (float or double), taken from a memory
+// resource (see arena.h). It is the single backing allocation of BasicMatrix<T>; the float version
+// also holds the float32 copies of the mixed-precision solvers.
+template <typename T>
+class BasicAlignedBuffer
+{
+public:
+  // Alignment in bytes of every buffer (one cache line, one AVX-512 register).
+  static constexpr size_t alignment = 64;
+
+  // Creates an empty buffer that owns no memory, later allocations come from the heap.
+  BasicAlignedBuffer() noexcept;
+
+  // Allocates room for count elements, all set to zero, from the calling thread's current resource.
+  explicit BasicAlignedBuffer(size_t count);
+
+  // Allocates room for count elements, all set to zero, from the given resource.
+  BasicAlignedBuffer(size_t count, std::pmr::memory_resource *resource);
+
+  // Takes ownership of count elements at block, which 'resource' handed out (or otherwise knows how to
+  // release) with this class's alignment. The contents are kept as they are.
+  BasicAlignedBuffer(T *block, size_t count, std::pmr::memory_resource *resource) noexcept;
+
+  // Copy constructor that allocates a new block from the current resource and copies the contents.
+  BasicAlignedBuffer(const BasicAlignedBuffer &other);
+
+  // Move constructor that steals the block of a temporary buffer, together with its resource.
+  BasicAlignedBuffer(BasicAlignedBuffer &&other) noexcept;
+
+  // Copy assignment, reuses the current block when the sizes match, else reallocates from this
+  // buffer's resource.
+  BasicAlignedBuffer &operator=(const BasicAlignedBuffer &other);
+
+  // Move assignment, releases the current block and steals the other one with its resource.
+  BasicAlignedBuffer &operator=(BasicAlignedBuffer &&other) noexcept;
+
+  // Releases the block.
+  ~BasicAlignedBuffer();
+
+  // Pointer to the first element (nullptr when empty).
+  T *data() noexcept;
+  const T *data() const noexcept;
+
+  // Number of elements in the block.
+  size_t size() const noexcept;
+
+  // Resource the block was taken from.
+  std::pmr::memory_resource *resource() const noexcept;
+
+private:
+  T *m_data;
+  size_t m_size;
+  std::pmr::memory_resource *m_resource;
+};
+
+using AlignedBuffer = BasicAlignedBuffer<double>;
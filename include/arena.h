@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <memory_resource>
+#include <vector>
+
+// Namespace for the memory resources that Vector, MATRIX and AlignedBuffer allocate from.
+// Every new object takes the calling thread's current resource, the heap unless a ScopedResource or
+// ScopedArena is active, and keeps it for its lifetime. Copies are allocated from the current resource
+// of the copying thread, copy assignment reuses or reallocates from the target's own resource. Move
+// construction takes the block along with its resource, move assignment only between equal resources
+// (else it copies, so an arena temporary moved into an older object stays valid past the scope).
+namespace memory {
+  // Global new/delete, with the alignment each request asks for.
+  std::pmr::memory_resource *heap() noexcept;
+
+  // Resource new objects of the calling thread allocate from.
+  std::pmr::memory_resource *current_resource() noexcept;
+
+  // Makes 'resource' the calling thread's current resource until destruction, then restores the
+  // previous one. Any std::pmr resource works, e.g. a synchronized_pool_resource as a size-class pool;
+  // parallel_for chunks allocate from it on pool threads as well, so it has to be thread-safe.
+  class ScopedResource {
+  public:
+    explicit ScopedResource(std::pmr::memory_resource *resource) noexcept;
+    ~ScopedResource();
+    ScopedResource(const ScopedResource &) = delete;
+    ScopedResource &operator=(const ScopedResource &) = delete;
+
+  private:
+    std::pmr::memory_resource *m_previous;
+  };
+
+  // Bump allocator over a list of chunks taken from an upstream resource. Allocation is a pointer
+  // increment, deallocation is free (only the latest block is actually given back), and rewinding
+  // releases everything allocated since a mark at once while keeping the chunks for reuse.
+  // Allocation and deallocation take a spin lock, as the chunks of a parallel_for allocate from the
+  // caller's arena on pool threads too; mark, rewind, reset and release belong to the owning thread.
+  class Arena : public std::pmr::memory_resource {
+  public:
+    // Position of the bump pointer, see mark() and rewind().
+    struct Mark {
+      size_t chunk;
+      size_t offset;
+    };
+
+    explicit Arena(size_t chunk_bytes = 1 << 20, std::pmr::memory_resource *upstream = heap());
+    ~Arena() override;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    Mark mark() const noexcept;
+
+    // Frees every block allocated after 'position' was marked.
+    void rewind(Mark position) noexcept;
+
+    // Frees every block, keeping the chunks.
+    void reset() noexcept;
+
+    // Frees every block and returns the chunks upstream.
+    void release() noexcept;
+
+    // Bytes handed out since the last reset (alignment padding included) and bytes held in chunks.
+    size_t used() const noexcept;
+    size_t capacity() const noexcept;
+
+  private:
+    struct Chunk {
+      char *data;
+      size_t size, alignment;
+    };
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *block, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    size_t m_chunk_bytes;
+    std::pmr::memory_resource *m_upstream;
+    std::vector<Chunk> m_chunks;
+    size_t m_current = 0, m_offset = 0;
+    std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+  };
+
+  // Arena owned by the calling thread, for ScopedArena's default.
+  Arena &thread_arena();
+
+  // Routes the calling thread's new Vector and MATRIX objects to an arena until destruction, then
+  // rewinds it, freeing all of them at once. Typical use is one scope per solver iteration:
+  //   for (...) { memory::ScopedArena scope; MATRIX r = A * x - b; ... }
+  // Nothing allocated inside the scope may outlive it: copy results out to objects created before it.
+  class ScopedArena {
+  public:
+    explicit ScopedArena(Arena &arena = thread_arena()) noexcept;
+    ~ScopedArena();
+    ScopedArena(const ScopedArena &) = delete;
+    ScopedArena &operator=(const ScopedArena &) = delete;
+
+  private:
+    Arena &m_arena;
+    Arena::Mark m_mark;
+    ScopedResource m_resource;
+  };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "aligned_buffer.h"
+#include "matrix.h"
+
+// Namespace for running one small dense operation over thousands of independent matrices
+namespace batch {
+  // count matrices of identical shape, stored interleaved: element (i, j) of 'lanes' consecutive
+  // matrices sits in one contiguous group, so every kernel runs one matrix per SIMD lane.
+  class MatrixBatch {
+  public:
+    // Matrices per interleaved group, one AVX-512 register of doubles.
+    static constexpr size_t lanes = 8;
+
+    // count zero matrices of the given shape.
+    MatrixBatch(size_t count, size_t row_count, size_t column_count);
+
+    // Number of matrices and their shape.
+    size_t size() const noexcept;
+    size_t getRowCount() const noexcept;
+    size_t getColumnCount() const noexcept;
+
+    // Element (row, column) of matrix 'index', unchecked.
+    double& operator()(size_t index, size_t row, size_t column) noexcept;
+    const double& operator()(size_t index, size_t row, size_t column) const noexcept;
+
+    // Copies a matrix into / out of slot 'index'.
+    void set(size_t index, ConstMatrixView value);
+    MATRIX get(size_t index) const;
+
+    // Interleaved storage: group g, element (i, j), lane l is at ((g * rows + i) * columns + j) * lanes + l.
+    double* data() noexcept;
+    const double* data() const noexcept;
+
+    // Number of interleaved groups (size rounded up to whole groups).
+    size_t groups() const noexcept;
+
+  private:
+    AlignedBuffer m_buffer;
+    size_t m_count, m_row_count, m_column_count;
+  };
+
+  // C[k] = alpha * A[k] * B[k] + beta * C[k] for every k. When beta is 0, C is overwritten.
+  void gemm(double alpha, const MatrixBatch& A, const MatrixBatch& B, double beta, MatrixBatch& C);
+
+  // Solves A[k] X[k] = B[k] for every k by Gaussian elimination with partial pivoting (lin_systems::gpp
+  // semantics), overwriting B with X. Returns the indices of the singular systems, whose results are unusable.
+  std::vector<size_t> gpp(const MatrixBatch& A, MatrixBatch& B);
+
+  // Inverts every matrix of A into result. Returns the indices of the singular matrices.
+  std::vector<size_t> inverse(const MatrixBatch& A, MatrixBatch& result);
+}
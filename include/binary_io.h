@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stddef.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "aligned_buffer.h"
+#include "view.h"
+
+// Namespace for the tsmath binary matrix format, which MATRIX can map straight into memory.
+// Version 1: a 64-byte Header, then rows x stride float64 elements in native byte order, row-major,
+// each row zero-padded to 'stride' (as in MATRIX, a whole number of 64-byte lines unless the row is
+// narrower than one line, then exactly 'columns'). The elements
+// start data_offset bytes into the file, a multiple of 64, so a mapping of the file holds them
+// aligned like an AlignedBuffer. A Vector is stored as a single row. Layout::tiled files (see
+// TiledMatrix) hold stride x stride tiles instead, one after another in row-major tile order, each
+// tile row-major and zero beyond the matrix edges.
+namespace binary {
+  constexpr std::uint32_t VERSION = 1;
+
+  // Written as 0x01020304 in the producer's byte order, files of the other order are rejected.
+  constexpr std::uint32_t ORDER_MARK = 0x01020304;
+
+  enum class DType : std::uint32_t { float64 = 1 };
+  enum class Layout : std::uint32_t { row_major = 0, tiled = 1 };
+
+  struct Header {
+    char magic[8];  // "TSMATHB" and a zero
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    DType dtype;
+    Layout layout;
+    std::uint32_t alignment;  // of the element block within the file, in bytes
+    std::uint32_t reserved;
+    std::uint64_t rows, columns, stride, data_offset;
+  };
+  static_assert(sizeof(Header) == 64, "the header is one cache line");
+
+  // Header of a rows x columns matrix as save() and Writer produce it.
+  Header make_header(size_t rows, size_t columns) noexcept;
+
+  // Reads and validates the header of a file. Throws std::runtime_error when the file cannot be read,
+  // is not in this format, has an unsupported version, dtype or byte order, or is shorter than its header
+  // announces.
+  Header read_header(const std::string &path);
+
+  // How a file is mapped.
+  enum class Access {
+    read_only,     // pages are mapped read-only, writing to the elements is a segmentation fault
+    copy_on_write  // pages are private: writes copy the touched pages and never reach the file
+  };
+
+  // Mapping of a whole row-major file, validated as by read_header. Pages are read in on first touch, so opening
+  // a multi-GB file costs no I/O until the elements are used. Needs a POSIX system (mmap).
+  class MappedFile {
+  public:
+    explicit MappedFile(const std::string &path, Access access = Access::read_only);
+    ~MappedFile();
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const Header &header() const noexcept;
+    Access access() const noexcept;
+
+    // The elements, valid while the mapping lives. The writable view needs Access::copy_on_write.
+    ConstMatrixView matrix() const noexcept;
+    MatrixView writable_matrix();
+
+    // The elements of a single-row or single-column file, throws std::invalid_argument otherwise.
+    ConstVectorView vector() const;
+
+    // Hands the element block over to an AlignedBuffer, which unmaps the file when it releases the
+    // block (allocations the buffer makes later come from the heap). The file is left empty. Needs
+    // Access::copy_on_write (the buffer's elements are writable), data_offset to be a multiple of
+    // AlignedBuffer::alignment and at least one element.
+    friend AlignedBuffer adopt(MappedFile &&file);
+
+  private:
+    void unmap() noexcept;
+
+    void *m_base = nullptr;
+    size_t m_length = 0;
+    Header m_header{};
+    Access m_access = Access::read_only;
+  };
+
+  AlignedBuffer adopt(MappedFile &&file);
+
+  // Streams a rows x columns matrix to a file front to back: the header, then rows as they are
+  // appended, staged through a large buffer so that the whole file is one sequential write. A 20 GB
+  // checkpoint never needs a second copy of the matrix in memory.
+  class Writer {
+  public:
+    // Creates (or truncates) 'path' and writes the header. Throws std::runtime_error on failure.
+    Writer(const std::string &path, size_t rows, size_t columns);
+
+    // Closes the file without the checks of close(): an incomplete file is left shorter than its
+    // header announces, which read_header rejects.
+    ~Writer();
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    // Appends the rows of a block (any stride) or a single row. Throws std::invalid_argument when the
+    // column count differs or the matrix would exceed its row count, std::runtime_error on I/O errors.
+    void write(ConstMatrixView rows);
+    void write(ConstVectorView row);
+
+    size_t rows_written() const noexcept;
+
+    // Flushes and closes the file. Throws std::runtime_error when rows are missing or a write failed.
+    void close();
+
+  private:
+    void flush();
+
+    std::ofstream m_out;
+    std::string m_path;
+    Header m_header;
+    size_t m_rows_written = 0;
+    std::vector<double> m_staging;
+    size_t m_staged = 0;
+  };
+
+  // Writes a matrix or a vector (as one row) to 'path' through a Writer.
+  void save(const std::string &path, ConstMatrixView A);
+  void save(const std::string &path, ConstVectorView v);
+}
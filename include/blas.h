@@ -0,0 +1,68 @@
+#pragma once
+
+#include "matrix.h"
+
+// Namespace for dense BLAS-style kernels working on MATRIX storage
+namespace blas {
+  // Selects whether an operand is used as stored or transposed.
+  enum class Op { none, transpose };
+
+  // C = alpha * op(A) * op(B) + beta * C on row-major storage.
+  // op(A) is m x k, op(B) is k x n, C is m x n; lda/ldb/ldc are row strides in elements.
+  // When beta is 0, C is overwritten and its previous contents are never read.
+  void gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, double alpha,
+            const double *A, size_t lda, const double *B, size_t ldb,
+            double beta, double *C, size_t ldc);
+
+  // gemm with the rows of C split across the thread pool once the product is large enough to pay for it,
+  // every panel of op(B) being packed once and shared by the threads.
+  void parallel_gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, double alpha,
+                     const double *A, size_t lda, const double *B, size_t ldb,
+                     double beta, double *C, size_t ldc);
+
+  // float32 versions of the two above (SGEMM): twice the elements per register and per cache line,
+  // used by the mixed-precision solvers of lin_alg.h.
+  void gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, float alpha,
+            const float *A, size_t lda, const float *B, size_t ldb,
+            float beta, float *C, size_t ldc);
+  void parallel_gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, float alpha,
+                     const float *A, size_t lda, const float *B, size_t ldb,
+                     float beta, float *C, size_t ldc);
+
+  // C = alpha * A * B + beta * C, accumulating into an existing MATRIX (or block view) without allocating it.
+  void gemm(double alpha, ConstMatrixView A, ConstMatrixView B, double beta, MatrixView C);
+
+  // C = alpha * op(A) * op(B) + beta * C, accumulating into an existing MATRIX (or block view).
+  void gemm(Op op_a, Op op_b, double alpha, ConstMatrixView A, ConstMatrixView B, double beta, MatrixView C);
+
+  // BLAS-1 updates in place, on contiguous SIMD kernels when the strides allow and split over the pool by
+  // rows for large matrices. Throw std::invalid_argument when the shapes differ.
+  // y += alpha * x
+  void axpy(double alpha, ConstVectorView x, VectorView y);
+  void axpy(double alpha, ConstMatrixView X, MatrixView Y);
+
+  // x *= alpha
+  void scal(double alpha, VectorView x);
+  void scal(double alpha, MatrixView X);
+
+  // y = alpha * x + beta * y
+  void axpby(double alpha, ConstVectorView x, double beta, VectorView y);
+  void axpby(double alpha, ConstMatrixView X, double beta, MatrixView Y);
+
+  // B = A^T for the m x n matrix A (B is n x m), A and B not overlapping. Cache-oblivious: the larger
+  // dimension is halved down to L1-sized tiles, which are transposed in SIMD registers. Row bands of A
+  // are split across the thread pool for large matrices.
+  void transpose(size_t m, size_t n, const double *A, size_t lda, double *B, size_t ldb);
+
+  // Transposes the n x n matrix A in place, swapping tile pairs across the diagonal.
+  void transpose_in_place(size_t n, double *A, size_t lda);
+
+  // Transposes the contiguous m x n matrix A (row stride n) in place into n x m (row stride m) by
+  // following the cycles of the permutation, with one bit of scratch per element.
+  void transpose_in_place(size_t m, size_t n, double *A);
+
+  // float32 versions of the three above, used by BasicMatrix<float>.
+  void transpose(size_t m, size_t n, const float *A, size_t lda, float *B, size_t ldb);
+  void transpose_in_place(size_t n, float *A, size_t lda);
+  void transpose_in_place(size_t m, size_t n, float *A);
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdexcept>
+#include "instrument.h"
+#include "thread_pool.h"
+
+// Namespace for the lazy element-wise expression layer over Vector and MATRIX (and their float
+// versions). Operators build a tree of nodes at compile time; assigning the tree to a vector or
+// matrix evaluates it in one fused loop without temporaries. Nodes compute in double, the result is
+// rounded once to the element type of the target.
+namespace expr {
+  // Base of every vector-shaped node. E provides dimension() and coeff(i).
+  template <typename E>
+  struct VectorExpression {
+    const E &self() const noexcept { return static_cast<const E &>(*this); }
+  };
+
+  // Base of every matrix-shaped node. E provides getRowCount(), getColumnCount() and coeff(i, j).
+  template <typename E>
+  struct MatrixExpression {
+    const E &self() const noexcept { return static_cast<const E &>(*this); }
+  };
+
+  // How a node stores an operand: sub-expressions by value, Vector/MATRIX leaves by const reference.
+  template <typename E>
+  struct operand {
+    using type = const E;
+  };
+
+  // Element-wise binary operations.
+  struct plus {
+    static double apply(double a, double b) noexcept { return a + b; }
+  };
+
+  struct minus {
+    static double apply(double a, double b) noexcept { return a - b; }
+  };
+
+  // Element-wise combination of two vector expressions of equal dimension.
+  template <typename L, typename R, typename Op>
+  class VectorBinary : public VectorExpression<VectorBinary<L, R, Op>> {
+  public:
+    VectorBinary(const L &lhs, const R &rhs) : m_lhs(lhs), m_rhs(rhs) {
+      if (lhs.dimension() != rhs.dimension()) {
+        throw std::invalid_argument("Vectors must have the same dimension for element-wise operations");
+      }
+    }
+
+    size_t dimension() const noexcept { return m_lhs.dimension(); }
+    double coeff(size_t i) const noexcept { return Op::apply(m_lhs.coeff(i), m_rhs.coeff(i)); }
+
+    const L &lhs() const noexcept { return m_lhs; }
+    const R &rhs() const noexcept { return m_rhs; }
+
+  private:
+    typename operand<L>::type m_lhs;
+    typename operand<R>::type m_rhs;
+  };
+
+  // A vector expression multiplied by a scalar.
+  template <typename E>
+  class VectorScaled : public VectorExpression<VectorScaled<E>> {
+  public:
+    VectorScaled(const E &operand, double scalar) noexcept : m_operand(operand), m_scalar(scalar) {}
+
+    size_t dimension() const noexcept { return m_operand.dimension(); }
+    double coeff(size_t i) const noexcept { return m_operand.coeff(i) * m_scalar; }
+
+    const E &operand_expression() const noexcept { return m_operand; }
+    double scalar() const noexcept { return m_scalar; }
+
+  private:
+    typename operand<E>::type m_operand;
+    double m_scalar;
+  };
+
+  // Element-wise combination of two matrix expressions of equal shape.
+  template <typename L, typename R, typename Op>
+  class MatrixBinary : public MatrixExpression<MatrixBinary<L, R, Op>> {
+  public:
+    MatrixBinary(const L &lhs, const R &rhs) : m_lhs(lhs), m_rhs(rhs) {
+      if (lhs.getRowCount() != rhs.getRowCount() || lhs.getColumnCount() != rhs.getColumnCount()) {
+        throw -1;
+      }
+    }
+
+    size_t getRowCount() const noexcept { return m_lhs.getRowCount(); }
+    size_t getColumnCount() const noexcept { return m_lhs.getColumnCount(); }
+    double coeff(size_t i, size_t j) const noexcept { return Op::apply(m_lhs.coeff(i, j), m_rhs.coeff(i, j)); }
+
+    const L &lhs() const noexcept { return m_lhs; }
+    const R &rhs() const noexcept { return m_rhs; }
+
+  private:
+    typename operand<L>::type m_lhs;
+    typename operand<R>::type m_rhs;
+  };
+
+  // A matrix expression multiplied by a scalar.
+  template <typename E>
+  class MatrixScaled : public MatrixExpression<MatrixScaled<E>> {
+  public:
+    MatrixScaled(const E &operand, double scalar) noexcept : m_operand(operand), m_scalar(scalar) {}
+
+    size_t getRowCount() const noexcept { return m_operand.getRowCount(); }
+    size_t getColumnCount() const noexcept { return m_operand.getColumnCount(); }
+    double coeff(size_t i, size_t j) const noexcept { return m_operand.coeff(i, j) * m_scalar; }
+
+    const E &operand_expression() const noexcept { return m_operand; }
+    double scalar() const noexcept { return m_scalar; }
+
+  private:
+    typename operand<E>::type m_operand;
+    double m_scalar;
+  };
+
+  // Writes a vector expression into out[0, dimension) in one pass.
+  template <typename T, typename E>
+  void evaluate(T *out, const VectorExpression<E> &e) noexcept {
+    const E &node = e.self();
+    const size_t n = node.dimension();
+    // Nominal counts: one FLOP and one stored element per element, the operand reads depend on the tree
+    TSMATH_INSTRUMENT(vector_expression, n, n * sizeof(T));
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = static_cast<T>(node.coeff(i));
+    }
+  }
+
+  // Matrix expressions with fewer elements than this are evaluated on the calling thread
+  // (under parallel::Policy::automatic); larger ones are split into bands of rows.
+  constexpr size_t PARALLEL_ELEMENTS = 1 << 16;
+
+  // Rows per band of a parallel evaluation, at least a few thousand elements.
+  inline size_t row_grain(size_t columns) noexcept {
+    return columns >= 4096 ? 1 : 4096 / (columns + 1) + 1;
+  }
+
+  // Writes a matrix expression row by row into out, whose rows are 'stride' elements apart. 'whole'
+  // promises that out is the entire buffer of a MATRIX of the expression's shape, padding included,
+  // so that the kernels of matrix.h may run over the padded rows in one stretch; a block view of a
+  // wider matrix leaves it false.
+  template <typename T, typename E>
+  void evaluate(T *out, size_t stride, const MatrixExpression<E> &e, bool whole = false) noexcept {
+    static_cast<void>(whole);
+    const E &node = e.self();
+    const size_t rows = node.getRowCount(), columns = node.getColumnCount();
+    TSMATH_INSTRUMENT(matrix_expression, rows * columns, rows * columns * sizeof(T));
+    const auto band = [&node, out, stride, columns](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        T *row = out + i * stride;
+        for (size_t j = 0; j < columns; ++j) {
+          row[j] = static_cast<T>(node.coeff(i, j));
+        }
+      }
+    };
+    if (parallel::worthwhile(rows * columns, PARALLEL_ELEMENTS)) {
+      parallel::parallel_for(rows, row_grain(columns), band);
+    } else {
+      band(0, rows);
+    }
+  }
+
+  // Vector expression operators.
+  template <typename L, typename R>
+  VectorBinary<L, R, plus> operator+(const VectorExpression<L> &lhs, const VectorExpression<R> &rhs) {
+    return VectorBinary<L, R, plus>(lhs.self(), rhs.self());
+  }
+
+  template <typename L, typename R>
+  VectorBinary<L, R, minus> operator-(const VectorExpression<L> &lhs, const VectorExpression<R> &rhs) {
+    return VectorBinary<L, R, minus>(lhs.self(), rhs.self());
+  }
+
+  template <typename E>
+  VectorScaled<E> operator*(const VectorExpression<E> &v, double scalar) noexcept {
+    return VectorScaled<E>(v.self(), scalar);
+  }
+
+  template <typename E>
+  VectorScaled<E> operator*(double scalar, const VectorExpression<E> &v) noexcept {
+    return VectorScaled<E>(v.self(), scalar);
+  }
+
+  template <typename E>
+  VectorScaled<E> operator-(const VectorExpression<E> &v) noexcept {
+    return VectorScaled<E>(v.self(), -1.0);
+  }
+
+  // Fused dot product of two vector expressions, no intermediate is materialised.
+  template <typename L, typename R>
+  double operator*(const VectorExpression<L> &lhs, const VectorExpression<R> &rhs) {
+    const L &l = lhs.self();
+    const R &r = rhs.self();
+    if (l.dimension() != r.dimension()) {
+      throw std::invalid_argument("Vectors must have the same dimension for dot product");
+    }
+    double result = 0.0;
+    for (size_t i = 0, n = l.dimension(); i < n; ++i) {
+      result += l.coeff(i) * r.coeff(i);
+    }
+    return result;
+  }
+
+  // Matrix expression operators. Matrix products are not element-wise and stay eager (see matrix.h).
+  template <typename L, typename R>
+  MatrixBinary<L, R, plus> operator+(const MatrixExpression<L> &lhs, const MatrixExpression<R> &rhs) {
+    return MatrixBinary<L, R, plus>(lhs.self(), rhs.self());
+  }
+
+  template <typename L, typename R>
+  MatrixBinary<L, R, minus> operator-(const MatrixExpression<L> &lhs, const MatrixExpression<R> &rhs) {
+    return MatrixBinary<L, R, minus>(lhs.self(), rhs.self());
+  }
+
+  template <typename E>
+  MatrixScaled<E> operator*(const MatrixExpression<E> &m, double scalar) noexcept {
+    return MatrixScaled<E>(m.self(), scalar);
+  }
+
+  template <typename E>
+  MatrixScaled<E> operator*(double scalar, const MatrixExpression<E> &m) noexcept {
+    return MatrixScaled<E>(m.self(), scalar);
+  }
+
+  template <typename E>
+  MatrixScaled<E> operator-(const MatrixExpression<E> &m) noexcept {
+    return MatrixScaled<E>(m.self(), -1.0);
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+#include <complex>
+#include <vector>
+#include "view.h"
+
+// Namespace for the real-input FFT and the fast convolutions built on it
+namespace fft {
+  // Precomputed bit-reversal order and twiddles for real-input transforms of one power-of-two
+  // length. The transform runs as a complex FFT of half the length plus a split step.
+  class RealPlan {
+  public:
+    // Plan for real sequences of 'length' samples (a power of two, at least 2).
+    explicit RealPlan(size_t length);
+
+    // Number of real samples transformed.
+    size_t length() const noexcept;
+
+    // spectrum[k] = sum_t in[t] e^{-2 pi i k t / length} for k in [0, length / 2].
+    void forward(const double *in, std::complex<double> *spectrum) const noexcept;
+
+    // Inverse of forward, scaled by 1 / length. spectrum is used as workspace and destroyed.
+    void inverse(std::complex<double> *spectrum, double *out) const noexcept;
+
+  private:
+    // In-place complex FFT of length / 2 points; conjugate twiddles when 'inverse' is set.
+    void transform(std::complex<double> *data, bool inverse) const noexcept;
+
+    size_t m_length;
+    std::vector<size_t> m_reversed;
+
+    // e^{-2 pi i k / length} for k in [0, length / 2).
+    std::vector<std::complex<double>> m_twiddles;
+  };
+
+  // Returns the cached plan for 'length', building it on first use. Safe to call from any thread;
+  // plans live until the program exits.
+  const RealPlan& plan(size_t length);
+
+  // True when an n-by-m convolution is expected to run faster through the FFT than directly.
+  // The crossover was measured against the vectorized direct loop.
+  bool prefer_fft(size_t n, size_t m) noexcept;
+
+  // out[t] = sum_i u[i] v[t - i] for t in [0, n + m - 1). Picks the direct or FFT method.
+  void convolve(const double *u, size_t n, const double *v, size_t m, double *out);
+
+  // Streaming convolution of an unbounded signal with a fixed kernel by overlap-add: every call
+  // to process() returns exactly as many output samples as it was given input samples.
+  class OverlapAdd {
+  public:
+    // block_size input samples are transformed at once; 0 picks the cheapest size for the kernel.
+    explicit OverlapAdd(ConstVectorView kernel, size_t block_size = 0);
+
+    // Feeds the next samples of the signal and returns the matching samples of the convolution.
+    Vector process(ConstVectorView chunk);
+
+    // Returns the kernel length - 1 samples still owed after the end of the signal and resets the stream.
+    Vector flush();
+
+  private:
+    size_t m_kernel_length, m_block_size;
+    const RealPlan *m_plan;
+    std::vector<std::complex<double>> m_kernel_spectrum, m_spectrum;
+    std::vector<double> m_block, m_tail;
+  };
+}
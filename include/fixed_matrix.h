@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <stddef.h>
+#include <stdexcept>
+#include <utility>
+#include "view.h"
+
+// Row-major N x M matrix whose size is fixed at compile time. It lives on the stack, never
+// allocates, and its dimension checks happen in the type system instead of at run time.
+// Meant for the 3x3 to 16x16 systems that are too small for MATRIX's heap storage.
+template <size_t N, size_t M>
+class FixedMatrix {
+public:
+  static constexpr size_t rows = N;
+  static constexpr size_t columns = M;
+
+  // Zero matrix.
+  FixedMatrix() noexcept : m_components{} {}
+
+  // Copies an N x M view, throws if the shape differs.
+  explicit FixedMatrix(ConstMatrixView other) {
+    if (other.getRowCount() != N || other.getColumnCount() != M) {
+      throw std::invalid_argument("Matrix shape does not match the fixed size");
+    }
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t j = 0; j < M; ++j) {
+        (*this)(i, j) = other(i, j);
+      }
+    }
+  }
+
+  // Identity matrix (square sizes only).
+  static FixedMatrix identity() noexcept {
+    static_assert(N == M, "identity needs a square matrix");
+    FixedMatrix result;
+    for (size_t i = 0; i < N; ++i) {
+      result(i, i) = 1.0;
+    }
+    return result;
+  }
+
+  double& operator()(size_t row, size_t column) noexcept { return m_components[row * M + column]; }
+  const double& operator()(size_t row, size_t column) const noexcept { return m_components[row * M + column]; }
+
+  double* data() noexcept { return m_components.data(); }
+  const double* data() const noexcept { return m_components.data(); }
+
+  size_t getRowCount() const noexcept { return N; }
+  size_t getColumnCount() const noexcept { return M; }
+
+  // Read-only and writable views, e.g. to pass the matrix to the lin_alg.h routines.
+  ConstMatrixView view() const noexcept { return ConstMatrixView(data(), N, M, M); }
+  MatrixView view() noexcept { return MatrixView(data(), N, M, M); }
+
+  FixedMatrix operator+(const FixedMatrix& other) const noexcept {
+    FixedMatrix result;
+    for (size_t k = 0; k < N * M; ++k) {
+      result.m_components[k] = m_components[k] + other.m_components[k];
+    }
+    return result;
+  }
+
+  FixedMatrix operator-(const FixedMatrix& other) const noexcept {
+    FixedMatrix result;
+    for (size_t k = 0; k < N * M; ++k) {
+      result.m_components[k] = m_components[k] - other.m_components[k];
+    }
+    return result;
+  }
+
+  FixedMatrix operator*(double scalar) const noexcept {
+    FixedMatrix result;
+    for (size_t k = 0; k < N * M; ++k) {
+      result.m_components[k] = m_components[k] * scalar;
+    }
+    return result;
+  }
+
+  template <size_t P>
+  FixedMatrix<N, P> operator*(const FixedMatrix<M, P>& other) const noexcept {
+    FixedMatrix<N, P> result;
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t k = 0; k < M; ++k) {
+        const double a = (*this)(i, k);
+        for (size_t j = 0; j < P; ++j) {
+          result(i, j) += a * other(k, j);
+        }
+      }
+    }
+    return result;
+  }
+
+  FixedMatrix<M, N> transpose() const noexcept {
+    FixedMatrix<M, N> result;
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t j = 0; j < M; ++j) {
+        result(j, i) = (*this)(i, j);
+      }
+    }
+    return result;
+  }
+
+  // Solves this * X = B by Gaussian elimination with partial pivoting (lin_systems::gpp semantics).
+  template <size_t P>
+  FixedMatrix<N, P> solve(FixedMatrix<N, P> B) const {
+    static_assert(N == M, "solve needs a square matrix");
+    FixedMatrix A = *this;
+    for (size_t j = 0; j < N; ++j) {
+      size_t p = j;
+      for (size_t i = j + 1; i < N; ++i) {
+        if (std::abs(A(i, j)) > std::abs(A(p, j))) {
+          p = i;
+        }
+      }
+      if (A(p, j) == 0.0) {
+        throw std::domain_error("Matrix is singular");
+      }
+      if (p != j) {
+        for (size_t c = 0; c < N; ++c) {
+          std::swap(A(j, c), A(p, c));
+        }
+        for (size_t c = 0; c < P; ++c) {
+          std::swap(B(j, c), B(p, c));
+        }
+      }
+      for (size_t i = j + 1; i < N; ++i) {
+        const double l = A(i, j) / A(j, j);
+        for (size_t c = j + 1; c < N; ++c) {
+          A(i, c) -= l * A(j, c);
+        }
+        for (size_t c = 0; c < P; ++c) {
+          B(i, c) -= l * B(j, c);
+        }
+      }
+    }
+    for (size_t i = N; i-- > 0;) {
+      for (size_t k = i + 1; k < N; ++k) {
+        for (size_t c = 0; c < P; ++c) {
+          B(i, c) -= A(i, k) * B(k, c);
+        }
+      }
+      for (size_t c = 0; c < P; ++c) {
+        B(i, c) /= A(i, i);
+      }
+    }
+    return B;
+  }
+
+  // Inverse through the pivoted solve against the identity.
+  FixedMatrix inverse() const {
+    return solve(identity());
+  }
+
+private:
+  std::array<double, N * M> m_components;
+};
+
+// Column vector of fixed dimension N.
+template <size_t N>
+using FixedVector = FixedMatrix<N, 1>;
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stddef.h>
+#include "matrix.h"
+
+// Namespace for the Householder kernels shared by the QR, eigenvalue and SVD reductions.
+// A panel of jb reflectors H_i = I - tau_i v_i v_i^T is kept as the unit lower trapezoidal
+// V = [v_0 ... v_jb-1] and applied at once as the compact WY block I - V T V^T.
+namespace householder {
+  // Turns x (length entries, stride apart) into beta followed by v[1:], returns tau (0 when H = I).
+  double generate(double *x, size_t length, size_t stride);
+
+  // Copies the reflectors stored below the diagonal of 'packed' (first jb columns) into V,
+  // writing the implied ones and zeros.
+  void unpack(ConstMatrixView packed, size_t jb, MATRIX &V);
+
+  // T of a panel: T(i, i) = tau_i, T(0:i, i) = -tau_i T(0:i, 0:i) V(:, 0:i)^T v_i, with V already
+  // unpacked (rows x jb). G is jb x jb scratch; T is written to t with row stride ldt.
+  void form_t(const MATRIX &V, size_t rows, size_t jb, const double *tau, MATRIX &G, double *t, size_t ldt);
+
+  // C = (I - V T^T V^T) C when transposed, else C = (I - V T V^T) C, split by columns over the pool.
+  // W is at least jb x C.getColumnCount() scratch.
+  void apply_block(const MATRIX &V, size_t rows, size_t jb, const double *t, size_t ldt, MatrixView C, MATRIX &W,
+                   bool transposed);
+}
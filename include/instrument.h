@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <cstdint>
+#include <chrono>
+#include <iosfwd>
+#include <vector>
+#include "macros.h"
+
+// Namespace for the built-in hot-path counters. With TSMATH_INSTRUMENTATION defined to 1 (CMake option
+// of the same name) every Vector/MATRIX operator, BLAS kernel and lin_alg.h routine records its calls,
+// wall time, nominal FLOPs and bytes moved in thread-local counters, and every heap allocation made
+// through memory::heap() is charged to the innermost kernel running on the allocating thread. Without
+// it the TSMATH_INSTRUMENT hooks compile to nothing and the queries below return empty results.
+namespace instrument {
+  // Instrumented operations. Times are inclusive: a routine's time contains that of the kernels it
+  // calls (e.g. inverse contains lu and gemm), so rows are compared per kernel, not summed.
+  enum class Kernel {
+    vector_expression, vector_add, vector_scale, vector_axpy, vector_dot,
+    matrix_expression, matrix_add, matrix_scale, matrix_axpy, matrix_multiply, transpose, transpose_in_place,
+    gemm, axpy, scal, axpby, triangular_solve,
+    lu, lu_solve, cholesky, cholesky_solve, inverse, gpp, qr, least_squares, eigen, svd, randomized_svd,
+    convolution, polynomial_division, sparse_multiply, cg, gmres, bicgstab,
+    allocation,
+    count
+  };
+
+  // Totals of one kernel over all threads. allocations and allocated_bytes count the heap allocations
+  // made while the kernel was the innermost one on its thread (exclusive, unlike the times: those of
+  // the kernels it calls are charged to them). Kernel::allocation only holds allocations made outside
+  // every kernel, e.g. by the Vector and MATRIX constructors called from user code, or on pool threads.
+  struct Stats {
+    Kernel kernel;
+    const char *name;
+    std::uint64_t calls, nanoseconds, flops, bytes, allocations, allocated_bytes;
+  };
+
+  // Whether the library was built with the counters.
+  constexpr bool enabled() noexcept { return TSMATH_INSTRUMENTATION != 0; }
+
+  // Name of a kernel as printed by dump().
+  const char *name(Kernel kernel) noexcept;
+
+  // Adds one call to the calling thread's counters. Relaxed single-writer updates, no locking.
+  void record(Kernel kernel, std::uint64_t nanoseconds, std::uint64_t flops, std::uint64_t bytes) noexcept;
+
+  // Makes 'kernel' the calling thread's innermost kernel and returns the previous one (Kernel::count
+  // when none), which Scope restores on exit.
+  Kernel enter(Kernel kernel) noexcept;
+  void leave(Kernel previous) noexcept;
+
+  // Innermost kernel of the calling thread (Kernel::count when none), e.g. for parallel_for to run its
+  // chunks under the caller's kernel on pool threads.
+  Kernel current() noexcept;
+
+  // Charges one heap allocation of the given size to the calling thread's innermost kernel.
+  void record_allocation(std::uint64_t bytes) noexcept;
+
+  // Totals of every kernel called at least once, summed over running and finished threads, in
+  // Kernel order. Counters of other threads are read while they may still be updating.
+  std::vector<Stats> snapshot();
+
+  // Zeroes every counter (those of running threads included).
+  void reset();
+
+  // Prints snapshot() as a table, the most time-consuming kernel first, with GFLOP/s and GB/s.
+  void dump(std::ostream &out);
+
+  // Times its own lifetime and records it for a kernel with the given FLOP and byte counts. The kernel
+  // is the thread's innermost one meanwhile.
+  class Scope {
+  public:
+    Scope(Kernel kernel, std::uint64_t flops, std::uint64_t bytes) noexcept
+        : m_kernel(kernel), m_previous(enter(kernel)), m_flops(flops), m_bytes(bytes),
+          m_start(std::chrono::steady_clock::now()) {}
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Kernel m_kernel, m_previous;
+    std::uint64_t m_flops, m_bytes;
+    std::chrono::steady_clock::time_point m_start;
+  };
+}
+
+// Instruments the rest of the enclosing scope as instrument::Kernel::kernel. The counts are not
+// evaluated when instrumentation is compiled out.
+#if TSMATH_INSTRUMENTATION
+#define TSMATH_INSTRUMENT_NAME2(line) tsmath_instrument_scope_##line
+#define TSMATH_INSTRUMENT_NAME(line) TSMATH_INSTRUMENT_NAME2(line)
+#define TSMATH_INSTRUMENT(kernel, flops, bytes)                                                               \
+  ::instrument::Scope TSMATH_INSTRUMENT_NAME(__LINE__)(::instrument::Kernel::kernel, (flops), (bytes))
+#else
+#define TSMATH_INSTRUMENT(kernel, flops, bytes) static_cast<void>(0)
+#endif
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+#include <vector>
+#include "matrix.h"
+#include "sparse.h"
+#include "view.h"
+
+// Namespace for the iterative Krylov solvers of A x = b, for large sparse or matrix-free systems where
+// the O(n^3) dense elimination of lin_systems::gpp is out of reach. A is only touched through y = A x.
+namespace krylov {
+  // Square linear operator y = A x on contiguous vectors: a dense matrix, a SparseMatrix or a callback.
+  // The dense form only references the matrix, which must outlive the operator.
+  class Operator {
+  public:
+    using Apply = std::function<void(const double *x, double *y)>;
+
+    // Matrix-free operator of the given dimension.
+    Operator(size_t dimension, Apply apply);
+
+    // Row-parallel dense matrix-vector product.
+    Operator(ConstMatrixView A);
+    Operator(const MATRIX &A);
+
+    // SpMV (the sparse arrays are shared, not copied).
+    Operator(const SparseMatrix &A);
+
+    size_t dimension() const noexcept;
+
+    // y = A x, x and y holding dimension() elements and not overlapping.
+    void apply(const double *x, double *y) const;
+
+  private:
+    size_t m_dimension;
+    Apply m_apply;
+  };
+
+  // z = M^-1 r for a preconditioner M ~ A. The default one is the identity.
+  class Preconditioner {
+  public:
+    using Apply = std::function<void(const double *r, double *z)>;
+
+    // Identity (no preconditioning).
+    Preconditioner();
+
+    // User-supplied z = M^-1 r.
+    explicit Preconditioner(Apply apply);
+
+    // M = diag(A). Throws std::domain_error on a zero diagonal entry.
+    static Preconditioner jacobi(const SparseMatrix &A);
+    static Preconditioner jacobi(ConstMatrixView A);
+
+    // Incomplete LU with no fill: L U restricted to the pattern of A, which must store its whole
+    // diagonal. Throws std::domain_error on a zero pivot.
+    static Preconditioner ilu0(const SparseMatrix &A);
+
+    // Incomplete Cholesky with no fill, L L^T on the lower triangle of a symmetric positive definite A.
+    // Throws std::domain_error on a non-positive pivot.
+    static Preconditioner ic0(const SparseMatrix &A);
+
+    // z = M^-1 r over n elements, r and z not overlapping.
+    void apply(const double *r, double *z, size_t n) const;
+
+  private:
+    enum class Kind { identity, custom, jacobi, ilu0, ic0 };
+
+    Kind m_kind;
+    Apply m_apply;
+
+    // Jacobi: inverse diagonal. ILU(0): unit L and U packed on the pattern of A, with the position
+    // of each diagonal entry. IC(0): L on the lower pattern, diagonal last in each row.
+    std::vector<double> m_values;
+    std::vector<size_t> m_offsets, m_indices, m_diagonal;
+  };
+
+  // Stopping criteria, all residual norms relative to ||b||.
+  struct Options {
+    double tolerance = 1e-8;
+    size_t max_iterations = 1000;
+
+    // GMRES basis size between restarts.
+    size_t restart = 30;
+
+    // Keep the residual norm of every iteration in Result::history.
+    bool record_history = true;
+  };
+
+  struct Result {
+    bool converged;
+    size_t iterations;
+
+    // ||b - A x|| / ||b|| as tracked by the solver: the updated residual of the CG recurrence, the
+    // true residual for GMRES (at each restart) and BiCGSTAB (confirmed when it claims convergence).
+    double residual;
+
+    // Relative residual before the first iteration and after each one, when recorded.
+    std::vector<double> history;
+  };
+
+  // Scratch vectors of the solvers. Sized on first use and reused by later solves, so that repeated
+  // solves of one size allocate nothing; the iterations themselves never allocate.
+  class Workspace {
+  public:
+    // At least count doubles, contents unspecified, reallocating only when it has to grow.
+    double *reserve(size_t count);
+
+  private:
+    std::vector<double> m_buffer;
+  };
+
+  // Preconditioned conjugate gradient for symmetric positive definite A (and M). x holds the initial
+  // guess and receives the solution.
+  Result cg(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M, const Options &options,
+            Workspace &workspace);
+  Result cg(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M = Preconditioner(),
+            const Options &options = Options());
+
+  // Restarted GMRES(options.restart) with right preconditioning, for any non-singular A.
+  Result gmres(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M, const Options &options,
+               Workspace &workspace);
+  Result gmres(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M = Preconditioner(),
+               const Options &options = Options());
+
+  // BiCGSTAB with right preconditioning, for non-symmetric A with short recurrences.
+  Result bicgstab(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M,
+                  const Options &options, Workspace &workspace);
+  Result bicgstab(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M = Preconditioner(),
+                  const Options &options = Options());
+}
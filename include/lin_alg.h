@@ -1,81 +1,312 @@
 
 #pragma once
 #include <stdlib.h>
+#include <complex>
+#include <utility>
+#include <vector>
 #include "matrix.h"
+#include "fft.h"
 #include "macros.h"
 
+// Matrix and vector inputs are taken as views, so a MATRIX, a Vector, or a row,
+// column or block of one can be passed without copying.
+
+// Namespace for matrix factorization techniques
+namespace factorization {
+  // Row-pivoting strategy used by the LU factorization.
+  enum class Pivoting { partial, none };
+
+  // What is known about a square matrix: spd (symmetric positive definite) lets the inverse and
+  // determinant routines use Cholesky, at half the cost of LU.
+  enum class Structure { general, spd };
+
+  // Blocked right-looking LU factorization P A = L U, stored in place as packed L\U
+  // (unit lower L below the diagonal, U on and above it) plus a row pivot array.
+  // Factorize once, then solve for any number of right-hand sides.
+  class LU {
+  public:
+    // Factorizes A (any shape). With Pivoting::none a zero pivot that cannot be eliminated throws.
+    explicit LU(ConstMatrixView A, Pivoting pivoting = Pivoting::partial);
+
+    // Number of rows and columns of the factorized matrix.
+    size_t getRowCount() const noexcept;
+    size_t getColumnCount() const noexcept;
+
+    // True if a zero pivot was met, i.e. U (and a square A) is singular.
+    bool is_singular() const noexcept;
+
+    // Packed L\U factors.
+    const MATRIX& packed() const noexcept;
+
+    // At step i, row i was swapped with row pivots()[i].
+    const std::vector<size_t>& pivots() const noexcept;
+
+    // Unit lower triangular factor L (rows x min(rows, columns)).
+    MATRIX lower() const;
+
+    // Upper triangular factor U (min(rows, columns) x columns).
+    MATRIX upper() const;
+
+    // Solves A x = b for a square, non-singular A.
+    Vector solve(ConstVectorView b) const;
+
+    // Solves A X = B in place, each column of B being one right-hand side.
+    void solve_in_place(MatrixView B) const;
+
+    // Determinant of a square A: the product of the pivots with the sign of P, accumulated
+    // without intermediate overflow (the result itself can still over- or underflow).
+    double determinant() const;
+
+    // (sign, log|det A|) of a square A, (0, -inf) when it is singular. Safe for any magnitude.
+    std::pair<double, double> slogdet() const;
+
+    // Inverse of a square, non-singular A from the factors (U inverted, then X L = U^-1 solved).
+    MATRIX inverse() const;
+
+  private:
+    MATRIX m_factors;
+    std::vector<size_t> m_pivots;
+    bool m_singular;
+  };
+
+  // Blocked Cholesky factorization A = U^T U = L L^T of a symmetric positive definite matrix,
+  // stored as the upper triangular U. Only the upper triangle of A is read.
+  class Cholesky {
+  public:
+    // Factorizes A. Throws std::domain_error when A is not (numerically) positive definite.
+    explicit Cholesky(ConstMatrixView A);
+
+    // Number of rows and columns of the factorized matrix.
+    size_t getRowCount() const noexcept;
+    size_t getColumnCount() const noexcept;
+
+    // Upper triangular factor U, zero below the diagonal.
+    const MATRIX& upper() const noexcept;
+
+    // Lower triangular factor L = U^T.
+    MATRIX lower() const;
+
+    // Determinant, the squared product of the diagonal of U.
+    double determinant() const;
+
+    // (1, log det A).
+    std::pair<double, double> slogdet() const;
+
+    // Inverse of A (symmetric, both triangles filled).
+    MATRIX inverse() const;
+
+    // Solves A x = b.
+    Vector solve(ConstVectorView b) const;
+
+    // Solves A X = B in place, each column of B being one right-hand side.
+    void solve_in_place(MatrixView B) const;
+
+  private:
+    MATRIX m_factors;
+  };
+
+  // Performs LU decomposition of a matrix (Doolittle factorization).
+  std::pair<MATRIX, MATRIX> doolittle(ConstMatrixView A);
+
+  // Performs LU decomposition of a matrix (Crout factorization).
+  std::pair<MATRIX, MATRIX> crout(ConstMatrixView A);
+
+  // Blocked Householder QR factorization A = Q R. R is stored in the upper triangle of packed(),
+  // the Householder vectors (unit leading entry implied) below it, with their scalars in tau().
+  // Q is kept implicit in compact WY form (Q = I - V T V^T per panel) and is never formed
+  // unless q() is called.
+  class QR {
+  public:
+    // Factorizes A (any shape).
+    explicit QR(ConstMatrixView A);
+
+    // Number of rows and columns of the factorized matrix.
+    size_t getRowCount() const noexcept;
+    size_t getColumnCount() const noexcept;
+
+    // Packed R and Householder vectors.
+    const MATRIX& packed() const noexcept;
+
+    // Householder scalars, one per reflector.
+    const Vector& tau() const noexcept;
+
+    // Upper triangular factor R (min(rows, columns) x columns).
+    MATRIX r() const;
+
+    // Thin orthonormal factor Q (rows x min(rows, columns)).
+    MATRIX q() const;
+
+    // B = Q^T B in place, B having as many rows as A.
+    void apply_qt(MatrixView B) const;
+
+    // B = Q B in place, B having as many rows as A.
+    void apply_q(MatrixView B) const;
+
+    // Minimises ||A x - b|| for a full column rank A with rows >= columns.
+    Vector solve_least_squares(ConstVectorView b) const;
+
+  private:
+    MATRIX m_factors;
+    Vector m_tau;
+
+    // Triangular T factor of every panel, panel k occupying columns [k, k + width).
+    MATRIX m_t;
+  };
+
+  // Computes the thin QR decomposition of a matrix, returned as (Q, R).
+  std::pair<MATRIX, MATRIX> qr(ConstMatrixView A);
+}
+
 // Namespace for solving linear systems
 namespace lin_systems {
   // Solves a lower triangular linear system using forward substitution.
-  Vector ltris(const MATRIX &A, const Vector &b);
+  Vector ltris(ConstMatrixView A, ConstVectorView b);
 
   // Solves an upper triangular linear system using backward substitution.
-  Vector utris(const MATRIX &A, const Vector &b);
+  Vector utris(ConstMatrixView A, ConstVectorView b);
 
-  // Solves a linear system using Gaussian elimination with partial pivoting.
-  Vector gpp(const MATRIX &A, const Vector &b);
+  // Solves A X = B in place for a lower triangular A, one right-hand side per column of B, with the
+  // blocked kernel of triangular::solve (see triangular.h for unit diagonals and transposes).
+  // Only the lower triangle of A is read. Throws std::domain_error on a zero diagonal entry.
+  void ltris_in_place(ConstMatrixView A, MatrixView B);
 
-  // Computes the inverse of a square matrix (if it exists).
-  MATRIX inverse(const MATRIX& A);
-}
+  // Solves A X = B in place for an upper triangular A, as ltris_in_place.
+  void utris_in_place(ConstMatrixView A, MatrixView B);
 
-// Namespace for matrix factorization techniques
-namespace factorization {
-  // Performs LU decomposition of a matrix (Doolittle factorization).
-  std::pair<MATRIX, MATRIX> doolittle(const MATRIX &A);
+  // Precision of the factorization behind gpp.
+  enum class Precision {
+    float64,  // LU of A in double
+    mixed     // LU of a float32 copy of A, solution refined in double (see gpp)
+  };
 
-  // Performs LU decomposition of a matrix (Crout factorization).
-  std::pair<MATRIX, MATRIX> crout(const MATRIX &A);
+  // Solves a linear system using Gaussian elimination with partial pivoting. With Precision::mixed the
+  // O(n^3) factorization runs in float32, at twice the SIMD width and half the memory traffic, and
+  // the solution is refined with float64 residuals until it is as accurate as a float64 solve. When
+  // A is too ill-conditioned for the refinement to converge (roughly cond(A) > 1e7), or does not fit
+  // the float range, gpp falls back to the float64 factorization by itself.
+  Vector gpp(ConstMatrixView A, ConstVectorView b, Precision precision = Precision::float64);
 
-  // Computes the QR decomposition of a matrix.
-  std::pair<MATRIX, MATRIX> qr(const MATRIX &A);
+  // Computes the inverse of a square matrix, through LU with partial pivoting or, for a matrix
+  // known to be symmetric positive definite, Cholesky. Throws std::domain_error if A is singular
+  // (not positive definite for Structure::spd).
+  MATRIX inverse(ConstMatrixView A, factorization::Structure structure = factorization::Structure::general);
+
+  // Overwrites A with its inverse, factorizing and inverting in place with only O(n) rows of
+  // scratch. With Structure::spd only the upper triangle of A is read.
+  void invert_in_place(MatrixView A, factorization::Structure structure = factorization::Structure::general);
 }
 
 // Namespace for creating Householder and Givens reflectors
 namespace reflectors {
-  // Creates a Householder reflection matrix.
-  MATRIX mk(const MATRIX& A, size_t i, size_t k);
+  // Implicit Householder reflector H = I - tau * v * v^T with v[0] = 1, mapping x onto beta * e_1.
+  struct Householder {
+    Vector v;
+    double tau;
+    double beta;
+  };
+
+  // Builds the reflector that maps x onto beta * e_1 without forming H.
+  Householder make_householder(ConstVectorView x);
 
-  // Constructs a Householder reflector.
-  MATRIX householder(const MATRIX &A, size_t i, size_t k);
+  // Creates the (rows - i) x (rows - i) Householder reflection matrix mapping A[i:, k] onto a multiple of e_1.
+  MATRIX mk(ConstMatrixView A, size_t i, size_t k);
+
+  // Constructs the full rows x rows Householder reflector that zeroes A[i+1:, k] (identity on the first i rows).
+  // Dense, for inspection only: the factorizations apply reflectors implicitly.
+  MATRIX householder(ConstMatrixView A, size_t i, size_t k);
 
   // Constructs a Givens reflector.
-  MATRIX givens(const MATRIX &A, size_t i, size_t k);
+  MATRIX givens(ConstMatrixView A, size_t i, size_t k);
 }
 
 // Namespace for solving least squares problems
 namespace lst_sqr {
   // Solves a least squares problem using the least squares method.
-  Vector lst_sqrs(const MATRIX& A, const Vector& b);
+  Vector lst_sqrs(ConstMatrixView A, ConstVectorView b);
 }
 
-// Namespace for eigenvalue and eigenVector computations
+// Namespace for eigenvalue and eigenVector computations. Symmetric input (up to rounding) takes the
+// tridiagonal path: blocked Householder tridiagonalization, then implicit QL for eigenvalues only or
+// divide and conquer when eigenvectors are wanted; eigenvalues come out in ascending order.
+// Other matrices go through a blocked Hessenberg reduction and Francis double-shift QR.
 namespace eigen {
-  // Performs Schur factorization of a matrix.
-  MATRIX shurr_factorization(const MATRIX& A);
+  // Real Schur decomposition A = Z T Z^T, returned as (Z, T): Z orthogonal, T upper triangular
+  // except for 2x2 diagonal blocks holding complex conjugate eigenvalue pairs.
+  std::pair<MATRIX, MATRIX> schur(ConstMatrixView A);
+
+  // Performs Schur factorization of a matrix, returning the quasi upper triangular T of schur().
+  MATRIX shurr_factorization(ConstMatrixView A);
 
-  // Computes the eigenVectors of a matrix with eigenVectors as columns.
-  MATRIX eigen_Vectors(const MATRIX& A);  
+  // Computes the eigenVectors of a matrix with eigenVectors as columns, normalized to unit length.
+  // Throws std::domain_error for a non-symmetric matrix with complex eigenvalues.
+  MATRIX eigen_Vectors(ConstMatrixView A);  
 
-  // Calculates the eigenvalues of a matrix.
-  Vector eigen_values(const MATRIX& A);
+  // Calculates the eigenvalues of a matrix without forming eigenvectors.
+  // Throws std::domain_error for a non-symmetric matrix with complex eigenvalues.
+  Vector eigen_values(ConstMatrixView A);
+
+  // Eigenvalues of any square matrix, complex conjugate pairs adjacent (positive imaginary part first).
+  std::vector<std::complex<double>> complex_eigen_values(ConstMatrixView A);
   
-  // Computes the determinant of a square matrix by using svd.
-  double determinant(const MATRIX& A);
+  // Computes the determinant of a square matrix from its LU factorization (Cholesky for Structure::spd).
+  double determinant(ConstMatrixView A, factorization::Structure structure = factorization::Structure::general);
+
+  // (sign, log|det A|) of a square matrix, for determinants beyond the range of a double.
+  // (0, -inf) for a singular matrix.
+  std::pair<double, double> slogdet(ConstMatrixView A,
+                                    factorization::Structure structure = factorization::Structure::general);
 }
 
-// Namespace for singular value decomposition (SVD)
+// Namespace for singular value decomposition (SVD). Dense input is reduced to upper bidiagonal form
+// by blocked Householder bidiagonalization (after a QR factorization when it has many more rows than
+// columns), then the bidiagonal is diagonalized by implicit-shift QR. Low-rank matrices can skip the
+// dense path through the randomized range finder.
 namespace svd {
-  // Computes the singular value decomposition (SVD) of a matrix.
-  std::vector<MATRIX> svd(const MATRIX& A);
+  // Thin singular value decomposition A = U diag(s) V^T: with p = min(rows, columns), U is rows x p and
+  // V is columns x p, both with orthonormal columns, and s holds the p singular values in descending order.
+  struct Factors {
+    MATRIX u;
+    Vector s;
+    MATRIX v;
+  };
 
-  // Calculates the pseudo-inverse of a matrix.
-  MATRIX pseudo_inverse(const MATRIX& A);
+  // Computes the singular value decomposition (SVD) of a matrix, returned as {U, S, V} with
+  // A = U S V^T and S the p x p diagonal matrix of the singular values (see Factors).
+  std::vector<MATRIX> svd(ConstMatrixView A);
 
-  
+  // Thin SVD of A.
+  Factors thin(ConstMatrixView A);
+
+  // Singular values of A in descending order, without forming singular vectors.
+  Vector singular_values(ConstMatrixView A);
+
+  // Approximates the leading 'rank' singular triplets in O(rows * columns * rank): A is sampled with
+  // rank + oversampling Gaussian vectors, power_iterations passes of A A^T sharpen the captured range,
+  // and the small projected matrix is decomposed exactly. The same seed gives the same result.
+  Factors randomized(ConstMatrixView A, size_t rank, size_t oversampling = 10, size_t power_iterations = 2,
+                     unsigned long seed = 0);
+
+  // Calculates the Moore-Penrose pseudo-inverse of a matrix. Singular values at or below
+  // tolerance * (largest singular value) are treated as zero; a negative tolerance selects
+  // max(rows, columns) * machine epsilon.
+  MATRIX pseudo_inverse(ConstMatrixView A, double tolerance = -1.0);
+
+  // Pseudo-inverse of the best rank-'rank' approximation of A, built from randomized() and
+  // truncated as in pseudo_inverse.
+  MATRIX low_rank_pseudo_inverse(ConstMatrixView A, size_t rank, double tolerance = -1.0);
 }
 
 namespace TSA {
-  Vector polynomial_division(Vector& p , const Vector& q ,   double tolerance = 1e-7);
-  Vector convolution(const Vector& u , const Vector& v, double tolerance = 1e-7);
+  // Divides p by q (coefficients highest degree first, leading ones below tolerance ignored) and
+  // returns (quotient, remainder), the remainder holding deg(q) coefficients (one for a constant q).
+  // p is not modified. Synthetic division for small degrees, Newton reciprocal with FFT products
+  // past the convolution crossover. Throws std::domain_error when q is zero.
+  std::pair<Vector, Vector> polynomial_divmod(ConstVectorView p , ConstVectorView q , double tolerance = 1e-7);
+
+  // Quotient of polynomial_divmod.
+  Vector polynomial_division(ConstVectorView p , ConstVectorView q , double tolerance = 1e-7);
+
+  // Full convolution of u and v (polynomial product), leading coefficients below tolerance trimmed.
+  // Long inputs go through the FFT; see fft::OverlapAdd to convolve a signal that arrives in chunks.
+  Vector convolution(ConstVectorView u , ConstVectorView v, double tolerance = 1e-7);
 }
\ No newline at end of file
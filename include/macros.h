@@ -4,3 +4,27 @@
 #define EULER_NUMBER 2.71828182846
 #define PI_NUMBER 3.14159265359
 
+// Default for simd::deterministic_reduction(), overridable from the build.
+#ifndef TSMATH_DETERMINISTIC_REDUCTION
+#define TSMATH_DETERMINISTIC_REDUCTION 0
+#endif
+
+// Hot-path counters of instrument.h, compiled out by default. Set from the build for the whole program.
+#ifndef TSMATH_INSTRUMENTATION
+#define TSMATH_INSTRUMENTATION 0
+#endif
+
+// Per-function instruction set selection for the runtime-dispatched kernels.
+// MSVC accepts the intrinsics without it, on non-x86 targets the wide kernels are compiled out.
+#ifndef TSMATH_TARGET
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TSMATH_X86 1
+#else
+#define TSMATH_X86 0
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TSMATH_TARGET(features)
+#else
+#define TSMATH_TARGET(features) __attribute__((target(features), flatten))
+#endif
+#endif
@@ -2,52 +2,137 @@
 #pragma once
 
 #include "vector.h"
+#include "aligned_buffer.h"
+#include "binary_io.h"
+#include "expression.h"
+#include "view.h"
+#include <initializer_list>
 #include <iostream>
 
-class MATRIX
+// Dense row-major matrix of T (float or double) in one aligned allocation, rows padded to whole cache
+// lines. MATRIX, the double version, is the one the rest of the library works on; a float matrix
+// holds float32 data at half the memory, multiplies with the float GEMM and converts from and to any
+// matrix expression, e.g. BasicMatrix<float> F = A; MATRIX B = F * 2.0.
+template <typename T>
+class BasicMatrix : public expr::MatrixExpression<BasicMatrix<T>>
 {
 public:
-  // Constructor that takes a constant reference to a std::vector<float>. (Consider potential type mismatch)
-  MATRIX(const std::vector<std::vector<double>> &buffer);
+  // Constructor that copies the rows of a nested std::vector.
+  BasicMatrix(const std::vector<std::vector<T>> &buffer);
 
-  // Move constructor that efficiently transfers ownership of data from a temporary std::vector<double>.
-  MATRIX(std::vector<std::vector<double>> &&buffer);
+  // Constructor from a temporary nested std::vector, copied like the one above and then released.
+  BasicMatrix(std::vector<std::vector<T>> &&buffer);
+
+  // Constructor from a nested brace list, e.g. MATRIX({{1, 2}, {3, 4}}).
+  BasicMatrix(std::initializer_list<std::initializer_list<T>> rows);
+
+  // Constructor for creating a row_count x column_count matrix filled with a default value.
+  BasicMatrix(size_t row_count, size_t column_count, T initialValue = T(0));
+
+  // Same, with the storage taken from the given memory resource instead of the thread's current one
+  // (see arena.h, every other constructor uses memory::current_resource()).
+  BasicMatrix(size_t row_count, size_t column_count, T initialValue, std::pmr::memory_resource *resource);
+
+  // Loads a file in the binary format of binary_io.h (see binary::save). Files written by binary::save
+  // or binary::Writer are mapped copy-on-write and used in place without a copy: pages are read on first
+  // touch, changes stay private to the process, and the mapping is released with the storage. Files
+  // padded differently, and every file loaded into a float matrix, are copied into fresh storage. For
+  // a read-only mapping use the view of a binary::MappedFile instead.
+  explicit BasicMatrix(const std::string &path);
 
   // Copy constructor that creates a deep copy of the data to avoid unintended side effects.
-  MATRIX(const MATRIX &other);
+  BasicMatrix(const BasicMatrix &other);
+
+  // Move constructor that takes over the storage of a temporary, leaving it 0 x 0.
+  BasicMatrix(BasicMatrix &&other) noexcept;
+
+  // Evaluates a lazy element-wise expression (e.g. A + B * 2.0) in a single fused pass, also
+  // converting between float and double matrices.
+  template <typename E>
+  BasicMatrix(const expr::MatrixExpression<E> &expression);
 
   // Copy assignment operator that performs a deep copy of the data.
-  MATRIX &operator=(MATRIX &other);
+  BasicMatrix &operator=(const BasicMatrix &other);
+
+  // Move assignment, takes over the storage of other when both use the same memory resource (else
+  // copies into this matrix's own storage, see arena.h), leaving other 0 x 0.
+  BasicMatrix &operator=(BasicMatrix &&other);
+
+  // Evaluates a lazy element-wise expression into this matrix, reusing its storage when the shape matches.
+  template <typename E>
+  BasicMatrix &operator=(const expr::MatrixExpression<E> &expression);
+
+  // Destructor deallocates any memory used by the matrix.
+  ~BasicMatrix();
+
+  // Returns a writable view of the row at a specific index (negative indices count from the end).
+  BasicVectorView<T> get_row(int row_index);
+
+  // Returns a read-only view of the row at a specific index.
+  BasicConstVectorView<T> get_row_const(int row_index) const;
+
+  // Matrix multiplication. Performs matrix multiplication with another matrix of the same type.
+  BasicMatrix operator*(const BasicMatrix &other) const;
+
+  // Matrix multiplication with an expression, which is evaluated once before the product.
+  template <typename E>
+  BasicMatrix operator*(const expr::MatrixExpression<E> &other) const;
+
+  // Scalar multiplication, addition and subtraction are lazy, see the operators in expression.h
+
+  // In-place updates, nothing is allocated: A += B, A -= B * s and A *= s go through blas::axpy and
+  // blas::scal (row loops for float), any other expression is evaluated element-wise straight into
+  // this matrix.
+  BasicMatrix &operator+=(const BasicMatrix &other);
+  BasicMatrix &operator-=(const BasicMatrix &other);
+  BasicMatrix &operator+=(const expr::MatrixScaled<BasicMatrix> &other);
+  BasicMatrix &operator-=(const expr::MatrixScaled<BasicMatrix> &other);
+  BasicMatrix &operator*=(double scalar);
+
+  template <typename E>
+  BasicMatrix &operator+=(const expr::MatrixExpression<E> &expression);
+  template <typename E>
+  BasicMatrix &operator-=(const expr::MatrixExpression<E> &expression);
 
-  // Destructor deallocates any memory used by the MATRIX object.
-  ~MATRIX();
+  // Transposes the matrix, swapping rows and columns (see blas::transpose).
+  BasicMatrix transpose() const noexcept;
 
-  // Returns a reference to the row at a specific index (allows modification).
-  Vector& get_row(int row_index);
+  // Transposes the matrix in its own storage, without a second buffer. The allocation only grows when
+  // the padded rows of the transpose need more room than it has, e.g. for a 3 x 8 matrix.
+  void transpose_in_place();
 
-  // Returns a const reference to the row at a specific index (read-only access).
-  const Vector& get_row_const(int row_index) const;
+  // Returns a writable strided view of a specific column (negative indices count from the end).
+  BasicVectorView<T> get_column(int index);
 
-  // Matrix multiplication. Performs matrix multiplication with another MATRIX object.
-  MATRIX operator*(const MATRIX &other) const;
+  // Returns a read-only strided view of a specific column.
+  BasicConstVectorView<T> get_column_const(int index) const;
 
-  // Scalar multiplication. Multiplies all elements of the matrix by a scalar value.
-  MATRIX operator*(double scalar) const noexcept;
+  // Returns a view of the row_count x column_count block whose top-left element is (first_row, first_column).
+  BasicMatrixView<T> block(size_t first_row, size_t first_column, size_t row_count, size_t column_count);
+  BasicConstMatrixView<T> block(size_t first_row, size_t first_column, size_t row_count, size_t column_count) const;
 
-  // Matrix addition. Performs element-wise addition with another MATRIX object.
-  MATRIX operator+(const MATRIX &other) const;
+  // Returns a strided view of the main diagonal.
+  BasicVectorView<T> diagonal() noexcept;
+  BasicConstVectorView<T> diagonal() const noexcept;
 
-  // Matrix subtraction. Performs element-wise subtraction with another MATRIX object.
-  MATRIX operator-(const MATRIX &other) const;
+  // Unchecked element read used by expression evaluation.
+  T coeff(size_t row, size_t column) const noexcept { return m_buffer.data()[row * m_stride + column]; }
 
-  // Transposes the matrix, swapping rows and columns.
-  MATRIX transpose() const noexcept;
+  // Returns a reference to the element at (row, column) without bounds checking.
+  T &operator()(size_t row, size_t column) noexcept;
 
-  // Returns a specific column of the matrix as a VECTOR object.
-  Vector& get_column(int index);
+  // Returns a const reference to the element at (row, column) without bounds checking.
+  const T &operator()(size_t row, size_t column) const noexcept;
 
-  // Returns a specific column of the matrix as a VECTOR object.
-  const Vector& get_column_const(int index) const;
+  // Pointer to the first element of the contiguous row-major storage.
+  T *data() noexcept;
+  const T *data() const noexcept;
+
+  // Distance in elements between the starts of two consecutive rows (>= column count).
+  size_t stride() const noexcept;
+
+  // Memory resource holding the elements.
+  std::pmr::memory_resource *resource() const noexcept;
 
   // Returns the number of columns in the matrix.
   size_t getColumnCount() const noexcept;
@@ -58,9 +143,93 @@ public:
   void print_matrix(std::ostream& buff) const noexcept;
 
 protected:
-  // Internal data storage for the matrix elements.
-  std::vector<std::vector<double>> m_components;
+  // Rounds a column count up to a whole number of cache lines; rows narrower than a line stay tight.
+  static size_t padded_stride(size_t column_count) noexcept;
+
+  // Single aligned row-major allocation holding all elements, rows padded to the stride.
+  BasicAlignedBuffer<T> m_buffer;
 
   // Dimensions of the matrix (number of rows and columns).
   size_t column_count, row_count;
-};
\ No newline at end of file
+
+  // Row pitch of m_buffer in elements.
+  size_t m_stride;
+};
+
+using MATRIX = BasicMatrix<double>;
+
+namespace expr
+{
+  // Matrix leaves are held by reference inside expression trees
+  template <typename T>
+  struct operand<BasicMatrix<T>>
+  {
+    using type = const BasicMatrix<T> &;
+  };
+
+  // A + B and A * s on plain double matrices run the SIMD kernels row by row, or over the whole padded
+  // buffer at once when out is 'whole' (see the generic evaluate)
+  void evaluate(double *out, size_t stride, const MatrixBinary<MATRIX, MATRIX, plus> &e, bool whole = false) noexcept;
+  void evaluate(double *out, size_t stride, const MatrixScaled<MATRIX> &e, bool whole = false) noexcept;
+
+  // A + B * s, e.g. X = X + P * alpha, is one axpy per row (in place when out is A)
+  void evaluate(double *out, size_t stride, const MatrixBinary<MATRIX, MatrixScaled<MATRIX>, plus> &e,
+                bool whole = false) noexcept;
+
+  // Product of two expressions, each side is evaluated once and multiplied with GEMM
+  template <typename L, typename R>
+  MATRIX operator*(const MatrixExpression<L> &lhs, const MatrixExpression<R> &rhs)
+  {
+    return MATRIX(lhs) * MATRIX(rhs);
+  }
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T>::BasicMatrix(const expr::MatrixExpression<E> &expression)
+    : BasicMatrix(expression.self().getRowCount(), expression.self().getColumnCount())
+{
+  expr::evaluate(m_buffer.data(), m_stride, expression.self(), true);
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T> &BasicMatrix<T>::operator=(const expr::MatrixExpression<E> &expression)
+{
+  // Element-wise nodes only read (i, j) before writing (i, j), so aliasing this matrix is safe
+  const E &node = expression.self();
+  if (node.getRowCount() != row_count || node.getColumnCount() != column_count)
+  {
+    // Evaluated aside (the node may read this matrix), then the block is adopted without a copy
+    BasicMatrix resized(node.getRowCount(), node.getColumnCount(), T(0), resource());
+    expr::evaluate(resized.m_buffer.data(), resized.m_stride, node, true);
+    m_buffer = std::move(resized.m_buffer);
+    row_count = resized.row_count;
+    column_count = resized.column_count;
+    m_stride = resized.m_stride;
+    return *this;
+  }
+  expr::evaluate(m_buffer.data(), m_stride, node, true);
+  return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T> &BasicMatrix<T>::operator+=(const expr::MatrixExpression<E> &expression)
+{
+  return *this = *this + expression.self();
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T> &BasicMatrix<T>::operator-=(const expr::MatrixExpression<E> &expression)
+{
+  return *this = *this - expression.self();
+}
+
+template <typename T>
+template <typename E>
+BasicMatrix<T> BasicMatrix<T>::operator*(const expr::MatrixExpression<E> &other) const
+{
+  return *this * BasicMatrix(other);
+}
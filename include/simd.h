@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+
+// Namespace for the runtime-dispatched SIMD kernels behind Vector
+namespace simd {
+  // Instruction sets a kernel can be dispatched to, in increasing order of width.
+  enum class isa { scalar, avx2, avx512 };
+
+  // Returns the widest instruction set supported by this CPU and operating system.
+  isa detected_isa() noexcept;
+
+  // Returns the instruction set currently used by the kernels.
+  isa active_isa() noexcept;
+
+  // Forces the kernels down to the given instruction set (clamped to what the CPU supports).
+  void set_isa(isa target) noexcept;
+
+  // When enabled, dot products and norms use one fixed 8-lane FMA reduction order on every
+  // instruction set, so scalar, AVX2 and AVX-512 results are bit-identical.
+  void set_deterministic_reduction(bool enabled) noexcept;
+
+  // Returns whether deterministic reductions are enabled.
+  bool deterministic_reduction() noexcept;
+
+  // out[i] = x[i] + y[i]
+  void add(const double *x, const double *y, double *out, size_t n) noexcept;
+
+  // out[i] = x[i] * alpha
+  void scale(const double *x, double alpha, double *out, size_t n) noexcept;
+
+  // y[i] += alpha * x[i]
+  void axpy(double alpha, const double *x, double *y, size_t n) noexcept;
+
+  // y[i] = alpha * x[i] + beta * y[i]
+  void axpby(double alpha, const double *x, double beta, double *y, size_t n) noexcept;
+
+  // Returns the sum of x[i] * y[i].
+  double dot(const double *x, const double *y, size_t n) noexcept;
+
+  // Plane rotation of two rows: x[i], y[i] = c * x[i] + s * y[i], c * y[i] - s * x[i]
+  void rotate(double *x, double *y, double c, double s, size_t n) noexcept;
+
+  // Returns the sum of x[i] * x[i].
+  double sum_squares(const double *x, size_t n) noexcept;
+
+  // b[j * ldb + i] = a[i * lda + j] for the rows x columns block at a, in 4 x 4 (AVX2) or 8 x 8
+  // (AVX-512) register tiles. Meant for blocks that fit in L1, a and b must not overlap.
+  void transpose(const double *a, size_t lda, double *b, size_t ldb, size_t rows, size_t columns) noexcept;
+}
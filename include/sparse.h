@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include "matrix.h"
+#include "view.h"
+
+// Compressed sparse matrix in CSR (row-major) or CSC (column-major) form. Only the non-zero
+// pattern is stored: offsets() has one entry per row (CSR) or column (CSC) plus one, and the
+// entries of row/column k are indices()[offsets()[k] .. offsets()[k + 1]) with matching values(),
+// indices sorted and unique. The arrays are shared between copies and transposes, which never
+// copy them: the transpose of a CSR matrix is the CSC view of the same arrays.
+class SparseMatrix {
+public:
+  // Storage order of the compressed arrays.
+  enum class Format { csr, csc };
+
+  // One entry for the triplet constructor.
+  struct Triplet {
+    size_t row;
+    size_t column;
+    double value;
+  };
+
+  // Empty (all zero) row_count x column_count matrix.
+  SparseMatrix(size_t row_count, size_t column_count, Format format = Format::csr);
+
+  // Builds from (row, column, value) triplets in any order; duplicates are summed.
+  // Throws std::out_of_range for an index outside the shape.
+  SparseMatrix(size_t row_count, size_t column_count, const std::vector<Triplet> &triplets,
+               Format format = Format::csr);
+
+  // Keeps the entries of A whose magnitude is above tolerance.
+  explicit SparseMatrix(ConstMatrixView A, Format format = Format::csr, double tolerance = 0.0);
+
+  size_t getRowCount() const noexcept;
+  size_t getColumnCount() const noexcept;
+  Format format() const noexcept;
+
+  // Number of stored entries.
+  size_t nonzeros() const noexcept;
+
+  // Compressed arrays, see the class comment.
+  const std::vector<size_t> &offsets() const noexcept;
+  const std::vector<size_t> &indices() const noexcept;
+  const std::vector<double> &values() const noexcept;
+
+  // Element (row, column), 0 when it is not stored (binary search, bounds checked).
+  double coeff(size_t row, size_t column) const;
+
+  // A^T sharing this matrix's arrays, in the opposite format.
+  SparseMatrix transpose() const noexcept;
+
+  // The same matrix in the given format, converting in O(nonzeros) when it differs.
+  SparseMatrix to_format(Format format) const;
+
+  // Dense copy.
+  MATRIX to_dense() const;
+
+  // y = alpha * A x + beta * y (SpMV). When beta is 0, y is overwritten without being read.
+  void multiply(double alpha, ConstVectorView x, double beta, VectorView y) const;
+
+  // Y = alpha * A X + beta * Y for a dense X with one column per right-hand side (SpMM).
+  void multiply(double alpha, ConstMatrixView X, double beta, MatrixView Y) const;
+
+private:
+  friend SparseMatrix operator*(const SparseMatrix &A, double scalar);
+
+  struct Storage {
+    std::vector<size_t> offsets;
+    std::vector<size_t> indices;
+    std::vector<double> values;
+  };
+
+  SparseMatrix(size_t row_count, size_t column_count, Format format, std::shared_ptr<const Storage> storage) noexcept;
+
+  size_t m_row_count, m_column_count;
+  Format m_format;
+  std::shared_ptr<const Storage> m_storage;
+};
+
+// A x, A X and X A with dense operands, multithreaded once the work pays for it.
+Vector operator*(const SparseMatrix &A, ConstVectorView x);
+MATRIX operator*(const SparseMatrix &A, ConstMatrixView X);
+MATRIX operator*(ConstMatrixView X, const SparseMatrix &A);
+
+// Scaling keeps the sparsity pattern.
+SparseMatrix operator*(const SparseMatrix &A, double scalar);
+SparseMatrix operator*(double scalar, const SparseMatrix &A);
+
+// Sums and differences with a dense matrix are dense.
+MATRIX operator+(const SparseMatrix &A, ConstMatrixView B);
+MATRIX operator+(ConstMatrixView A, const SparseMatrix &B);
+MATRIX operator-(const SparseMatrix &A, ConstMatrixView B);
+MATRIX operator-(ConstMatrixView A, const SparseMatrix &B);
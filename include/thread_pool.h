@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+
+// Namespace for the library-wide thread pool used by the heavy kernels
+namespace parallel {
+  // How the calling thread lets library calls use the pool: automatic splits work once it is
+  // above each kernel's size threshold, serial never splits, parallel splits whatever the size.
+  enum class Policy { automatic, serial, parallel };
+
+  // Policy of the calling thread, automatic unless a ScopedPolicy is active.
+  Policy policy() noexcept;
+
+  // Sets the calling thread's policy until destruction, then restores the previous one.
+  class ScopedPolicy {
+  public:
+    explicit ScopedPolicy(Policy policy) noexcept;
+    ~ScopedPolicy();
+    ScopedPolicy(const ScopedPolicy &) = delete;
+    ScopedPolicy &operator=(const ScopedPolicy &) = delete;
+
+  private:
+    Policy m_previous;
+  };
+
+  // Runs one call under a policy, e.g. with_policy(Policy::serial, [&] { return A * B; }).
+  template <typename F>
+  auto with_policy(Policy policy, F &&call) -> decltype(call()) {
+    ScopedPolicy scope(policy);
+    return call();
+  }
+
+  // Resizes the pool to 'threads' threads, the calling thread included; 0 restores the default
+  // (the TSMATH_NUM_THREADS environment variable, else the hardware concurrency). Calls already in
+  // flight finish on the old workers, which are joined once the last of them returns.
+  void set_thread_count(size_t threads);
+
+  // Pins worker k to CPU k + 1, leaving CPU 0 to the calling thread (Linux only, ignored elsewhere).
+  // Rebuilds the pool, the calls in flight finishing on the old one as for set_thread_count.
+  void set_pinning(bool enabled);
+
+  // Number of threads (the calling thread included) that parallel_for spreads work over;
+  // 1 under Policy::serial.
+  size_t thread_count() noexcept;
+
+  // Whether an operation of 'work' units (elements, multiply-adds) should be split across the pool
+  // under the calling thread's policy, 'threshold' being the kernel's automatic cut-off.
+  bool worthwhile(size_t work, size_t threshold) noexcept;
+
+  // Splits [0, count) into contiguous chunks of at least 'grain' iterations and runs
+  // body(begin, end) on each, the calling thread taking part. There are a few chunks per thread,
+  // claimed in order by the caller and by helper tasks queued on the workers (each worker taking
+  // from its own queue and stealing from the others once it runs dry); the caller never runs
+  // chunks of other calls. On the workers a chunk runs under the caller's policy, memory resource
+  // (see arena.h) and instrumented kernel. Returns when every chunk is done; the first exception
+  // thrown by a chunk is rethrown. Nested calls from a worker and calls under Policy::serial run
+  // serially.
+  void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "matrix.h"
+
+// Matrix larger than memory, kept on disk as square tiles (binary_io.h format, Layout::tiled) and
+// worked on through a bounded LRU cache of tiles. Kernels pin the tiles they work on, a background
+// thread reads the ones they announce next (prefetch), and dirty tiles are written back when they
+// are evicted or flushed. One thread drives a TiledMatrix at a time; the kernels applied to its tiles
+// still use the whole pool. Needs a POSIX system (pread/pwrite).
+class TiledMatrix {
+  struct Entry;
+  struct Cache;
+
+public:
+  // Pin of one tile in the cache: the tile stays loaded, and its view valid, until the pin is destroyed.
+  class Tile {
+  public:
+    Tile(Tile &&other) noexcept;
+    ~Tile();
+    Tile(const Tile &) = delete;
+    Tile &operator=(const Tile &) = delete;
+    Tile &operator=(Tile &&) = delete;
+
+    // The tile's part of the matrix, smaller than tile_size() x tile_size() on the last tile row and
+    // column. Rows are tile_size() elements apart. Only tiles pinned by write_tile may be written.
+    MatrixView view() const noexcept;
+
+  private:
+    friend class TiledMatrix;
+    Tile(Cache *cache, Entry *entry, MatrixView view) noexcept;
+
+    Cache *m_cache;
+    Entry *m_entry;
+    MatrixView m_view;
+  };
+
+  // Default tile edge (2 MiB tiles) and cache budget.
+  static constexpr size_t DEFAULT_TILE = 512;
+  static constexpr size_t DEFAULT_CACHE_BYTES = size_t(256) << 20;
+
+  // Creates a rows x columns matrix of zeros in a new file (sparse on disk until tiles are written).
+  // The tile edge is rounded up to a multiple of 8. The cache holds at least four tiles whatever
+  // cache_bytes says. Throws std::runtime_error when the file cannot be created.
+  static TiledMatrix create(const std::string &path, size_t rows, size_t columns, size_t tile = DEFAULT_TILE,
+                            size_t cache_bytes = DEFAULT_CACHE_BYTES);
+
+  // Opens a file written by a TiledMatrix, validated as by binary::read_header.
+  static TiledMatrix open(const std::string &path, size_t cache_bytes = DEFAULT_CACHE_BYTES);
+
+  TiledMatrix(TiledMatrix &&other) noexcept;
+  TiledMatrix &operator=(TiledMatrix &&other) noexcept;
+
+  // Writes the dirty tiles back and closes the file. Write errors are lost here, call flush() first
+  // to see them.
+  ~TiledMatrix();
+
+  size_t getRowCount() const noexcept;
+  size_t getColumnCount() const noexcept;
+
+  // Tile edge, number of tile rows and columns, and the size of tile row I and tile column J.
+  size_t tile_size() const noexcept;
+  size_t tile_rows() const noexcept;
+  size_t tile_columns() const noexcept;
+  size_t tile_height(size_t I) const noexcept;
+  size_t tile_width(size_t J) const noexcept;
+
+  // Number of tiles the cache holds before it starts evicting (it overshoots only when every cached
+  // tile is pinned): what is left of cache_bytes after the reservations below, at least four tiles.
+  size_t cache_capacity() const noexcept;
+
+  // Charges working memory a kernel keeps outside the cache (e.g. the block column a factorization
+  // holds in memory) to cache_bytes, evicting tiles down to the smaller capacity, until the matching
+  // release_budget. Throws std::runtime_error when writing an evicted tile back fails.
+  void reserve_budget(size_t bytes);
+  void release_budget(size_t bytes) noexcept;
+
+  // Pins tile (I, J), reading it from disk unless cached (waiting for a prefetch in flight). A tile
+  // pinned by write_tile is written back before it leaves the cache.
+  Tile read_tile(size_t I, size_t J) const;
+  Tile write_tile(size_t I, size_t J);
+
+  // Asks the background thread to read tile (I, J) ahead of its use. Only a hint: the request is
+  // dropped when too many are queued, and the tile may be evicted again before it is pinned.
+  void prefetch(size_t I, size_t J) const;
+
+  // Copies the block of the matrix whose top-left element is (row, column) out of or into the tiles,
+  // one tile at a time (e.g. to import a binary::MappedFile, whose pages are read as they are copied).
+  void read_block(size_t row, size_t column, MatrixView block) const;
+  void write_block(size_t row, size_t column, ConstMatrixView block);
+
+  // Writes every dirty tile back. Throws std::runtime_error on I/O errors.
+  void flush();
+
+private:
+  explicit TiledMatrix(std::unique_ptr<Cache> cache) noexcept;
+
+  std::unique_ptr<Cache> m_cache;
+};
+
+// Namespace for the kernels on TiledMatrix. Each keeps a bounded number of tiles (or, for the
+// factorizations, one block column of tiles) in memory, and prefetches the next tile it will need
+// while working on the current one, so that disk reads overlap with the arithmetic. The operands
+// must use the same tile size and be distinct matrices. Memory stays within the cache_bytes of the
+// operands, except where a factorization notes otherwise.
+namespace out_of_core {
+  // C = alpha A B + beta C one tile of C at a time, each tile a blas::parallel_gemm.
+  void gemm(double alpha, const TiledMatrix &A, const TiledMatrix &B, double beta, TiledMatrix &C);
+
+  // B = A^T tile by tile (B is columns x rows).
+  void transpose(const TiledMatrix &A, TiledMatrix &B);
+
+  // Left-looking blocked LU with partial pivoting, P A = L U, overwriting a square n x n A with the
+  // packed L\U factors like factorization::LU. Each block column is loaded once, updated by the tiles
+  // of L to its left, factorized in memory and written back; the row interchanges of later block
+  // columns are applied to L in a final pass. A must outlive the object.
+  // Memory: the block column and its in-memory factorization (2 n tile doubles) are charged to A's
+  // cache budget, so the peak is max(cache_bytes, 2 n tile doubles + 4 tiles): the block column is
+  // never split, and a cache_bytes below that bound only shrinks the cache to four tiles.
+  class LU {
+  public:
+    explicit LU(TiledMatrix &A);
+
+    // True if a zero pivot was met, i.e. A is singular.
+    bool is_singular() const noexcept;
+
+    // Row i was interchanged with row pivots()[i], in order.
+    const std::vector<size_t> &pivots() const noexcept;
+
+    // Solves A x = b streaming the tiles of L and U once each, x in memory.
+    Vector solve(ConstVectorView b) const;
+
+  private:
+    TiledMatrix &m_factors;
+    std::vector<size_t> m_pivots;
+    bool m_singular;
+  };
+
+  // Left-looking blocked Householder QR of a tall m x n A (m >= n), overwritten with R and the
+  // Householder vectors like factorization::QR. Each block column is loaded once, updated by the
+  // reflectors of the block columns to its left (two passes over their tiles, compact WY form),
+  // factorized in memory and written back. A must outlive the object.
+  // Memory: the block column, its in-memory factorization and the T factors kept for Q (about
+  // 3 m tile + n tile doubles) are charged to A's cache budget while factorizing, so the peak is
+  // max(cache_bytes, that + 4 tiles); as for LU the block column is never split. The T factors
+  // (n tile doubles) stay in memory with the object.
+  class QR {
+  public:
+    explicit QR(TiledMatrix &A);
+
+    // Householder scalars, one per column.
+    const Vector &tau() const noexcept;
+
+    // b = Q^T b in place, b having as many entries as A has rows.
+    void apply_qt(VectorView b) const;
+
+    // Minimises ||A x - b|| for a full column rank A, streaming the tiles of Q and R.
+    Vector solve_least_squares(ConstVectorView b) const;
+
+  private:
+    TiledMatrix &m_factors;
+    Vector m_tau;
+
+    // Triangular T factor of every block column.
+    std::vector<MATRIX> m_t;
+  };
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include "blas.h"
+#include "view.h"
+
+// Namespace for the blocked triangular kernels shared by the LU and Cholesky based routines.
+namespace triangular {
+  // Which triangle of the matrix holds the factor; the other one is never read.
+  enum class Uplo { lower, upper };
+
+  // Whether the diagonal is stored or taken as all ones (the packed L of an LU factorization).
+  enum class Diag { non_unit, unit };
+
+  // B = op(T)^-1 B in place (TRSM) for the n x n triangular T at t and the n x nrhs right-hand
+  // sides at b, row strides ldt and ldb. Diagonal blocks are solved by substitution and everything
+  // else is a GEMM update; wide B is split into column strips across the thread pool, narrow B
+  // spreads each update instead. No check is made for a zero on the diagonal.
+  void solve(Uplo uplo, blas::Op op, Diag diag, size_t n, size_t nrhs, const double *t, size_t ldt,
+             double *b, size_t ldb);
+
+  // solve() on a square T and a B with as many rows.
+  void solve(Uplo uplo, blas::Op op, Diag diag, ConstMatrixView T, MatrixView B);
+
+  // Overwrites the upper triangle of the square A (non-unit diagonal, no zero on it) with the
+  // upper triangle of its inverse. The strictly lower part is neither read nor written, so it can
+  // keep the L of a packed LU factorization. Uses O(n) rows of scratch.
+  void invert_upper(MatrixView A);
+}
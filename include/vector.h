@@ -1,65 +1,116 @@
 #pragma once
 
 #include <vector>
+#include <memory_resource>
 #include <cmath>
 #include <stdlib.h>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include "arena.h"
+#include "expression.h"
 
 
-class Vector {
+// Dense vector of T (float or double) in a pmr vector taken from the thread's memory resource (see
+// arena.h). Vector, the double version, is the one the rest of the library works on; a float vector
+// holds float32 data at half the memory and converts from and to any vector expression.
+template <typename T>
+class BasicVector : public expr::VectorExpression<BasicVector<T>> {
 public:
-  // Constructor using a constant reference to a std::vector<double>
-  explicit Vector(const std::vector<double>& data);
+  // Constructor using a constant reference to a std::vector, copied into the thread's memory resource
+  explicit BasicVector(const std::vector<T>& data);
 
-  // Move constructor for efficient data transfer
-  Vector(std::vector<double>&& data);
+  // Constructor from a temporary std::vector, also a copy into the thread's memory resource (the block of
+  // a std::vector cannot be adopted by a memory resource), after which the argument is released
+  BasicVector(std::vector<T>&& data);
 
   // Constructor for creating a vector with a specific dimension and default value
-  Vector(size_t dimension, double initialValue = 0.0);
+  BasicVector(size_t dimension, T initialValue = T(0));
+
+  // Same, with the storage taken from the given memory resource instead of the thread's current one
+  // (see arena.h, every other constructor uses memory::current_resource())
+  BasicVector(size_t dimension, T initialValue, std::pmr::memory_resource* resource);
+
+  // Loads a single-row or single-column file in the binary format of binary_io.h (see binary::save),
+  // copying the mapped elements once into this vector's storage
+  explicit BasicVector(const std::string& path);
 
   // Copy constructor for deep copying the data
-  Vector(const Vector& other);
+  BasicVector(const BasicVector& other);
+
+  // Move constructor that takes over the storage of a temporary, leaving it empty
+  BasicVector(BasicVector&& other) noexcept;
+
+  // Evaluates a lazy element-wise expression (e.g. a + b * 2.0 - c) in a single fused pass, also
+  // converting between float and double vectors
+  template <typename E>
+  BasicVector(const expr::VectorExpression<E>& expression);
 
   // Copy assignment operator for deep copying the data
-  Vector& operator=(const Vector& other);
+  BasicVector& operator=(const BasicVector& other);
+
+  // Move assignment, takes over the storage of other when both use the same memory resource (else copies
+  // into this vector's own storage, see arena.h)
+  BasicVector& operator=(BasicVector&& other);
+
+  // Evaluates a lazy element-wise expression into this vector, reusing its storage when the size matches
+  template <typename E>
+  BasicVector& operator=(const expr::VectorExpression<E>& expression);
 
-  // Destructor to deallocate memory used by the Vector object
-  ~Vector();
+  // Destructor to deallocate memory used by the vector
+  ~BasicVector();
 
   // Calculates and returns a unit vector (magnitude 1) with the same direction
-  Vector unitVector() const noexcept;
+  BasicVector unitVector() const noexcept;
 
-  // Vector addition (element-wise) with another Vector
-  Vector operator+(const Vector& other) const;
+  // Vector addition and subtraction are lazy, see the operators in expression.h
 
-  // Vector subtraction (element-wise) with another Vector
-  Vector operator-(const Vector& other) const;
+  // In-place updates, nothing is allocated: x += y, x -= y * s and x *= s go through the SIMD axpy and
+  // scale kernels (loops the compiler vectorises for float), any other expression is evaluated
+  // element-wise straight into this vector
+  BasicVector& operator+=(const BasicVector& other);
+  BasicVector& operator-=(const BasicVector& other);
+  BasicVector& operator+=(const expr::VectorScaled<BasicVector>& other);
+  BasicVector& operator-=(const expr::VectorScaled<BasicVector>& other);
+  BasicVector& operator*=(double scalar) noexcept;
 
-   
-  // Scalar multiplication (multiply all elements by a scalar)
-  Vector operator*(double scalar) const;
+  template <typename E>
+  BasicVector& operator+=(const expr::VectorExpression<E>& expression);
+  template <typename E>
+  BasicVector& operator-=(const expr::VectorExpression<E>& expression);
 
-  // Dot product (scalar product) with another Vector
-  double operator *(const Vector& other) const;
+  // Scalar multiplication (lazy, multiply all elements by a scalar when assigned)
+  expr::VectorScaled<BasicVector> operator*(double scalar) const noexcept;
+
+  // Dot product (scalar product) with another vector or expression, see expr::operator* below
 
   // Calculates the magnitude (length) of the vector
   double magnitude() const noexcept;
 
   // Returns a reference to the element at a specific index (modification)
-  double& operator[](size_t index);
+  T& operator[](size_t index);
 
   // Returns a const reference to the element at a specific index (read-only)
-  const double& operator[](size_t index) const;
+  const T& operator[](size_t index) const;
 
   // Returns the number of elements (dimension) of the vector
   size_t dimension() const noexcept;
 
+  // Unchecked element read used by expression evaluation
+  T coeff(size_t index) const noexcept { return components[index]; }
+
+  // Pointer to the contiguous element storage
+  T* data() noexcept;
+  const T* data() const noexcept;
+
+  // Memory resource holding the elements
+  std::pmr::memory_resource* resource() const noexcept;
+
   // Inserts a value at the beginning of the vector
-  void pushFront(double value);
+  void pushFront(T value);
 
   // Inserts a value at the end of the vector
-  void pushBack(double value);
+  void pushBack(T value);
 
   // Removes the last element from the vector
   void popBack();
@@ -71,5 +122,54 @@ public:
   void print(std::ostream& out) const noexcept;
 
 private:
-  std::vector<double> components;
+  std::pmr::vector<T> components;
 };
+
+using Vector = BasicVector<double>;
+
+namespace expr {
+  // Vector leaves are held by reference inside expression trees
+  template <typename T>
+  struct operand<BasicVector<T>> {
+    using type = const BasicVector<T>&;
+  };
+
+  // a + b and a * s on plain double vectors go straight to the SIMD kernels
+  void evaluate(double* out, const VectorBinary<Vector, Vector, plus>& e) noexcept;
+  void evaluate(double* out, const VectorScaled<Vector>& e) noexcept;
+
+  // a + b * s, e.g. x = x + p * alpha, is one axpy (in place when out is a)
+  void evaluate(double* out, const VectorBinary<Vector, VectorScaled<Vector>, plus>& e) noexcept;
+
+  // Dot product of two plain vectors, uses the SIMD dot kernel
+  template <>
+  double operator*(const VectorExpression<Vector>& lhs, const VectorExpression<Vector>& rhs);
+}
+
+template <typename T>
+template <typename E>
+BasicVector<T>::BasicVector(const expr::VectorExpression<E>& expression)
+    : components(expression.self().dimension(), memory::current_resource()) {
+  expr::evaluate(components.data(), expression.self());
+}
+
+template <typename T>
+template <typename E>
+BasicVector<T>& BasicVector<T>::operator=(const expr::VectorExpression<E>& expression) {
+  // Element-wise nodes only read index i before writing index i, so aliasing this vector is safe
+  components.resize(expression.self().dimension());
+  expr::evaluate(components.data(), expression.self());
+  return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicVector<T>& BasicVector<T>::operator+=(const expr::VectorExpression<E>& expression) {
+  return *this = *this + expression.self();
+}
+
+template <typename T>
+template <typename E>
+BasicVector<T>& BasicVector<T>::operator-=(const expr::VectorExpression<E>& expression) {
+  return *this = *this - expression.self();
+}
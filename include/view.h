@@ -0,0 +1,193 @@
+#pragma once
+
+#include "vector.h"
+#include "expression.h"
+
+template <typename T>
+class BasicMatrix;
+
+// Read-only, non-owning strided window onto the elements (float or double) of a BasicVector or
+// BasicMatrix. A view must not outlive the object it was taken from.
+template <typename T>
+class BasicConstVectorView : public expr::VectorExpression<BasicConstVectorView<T>> {
+public:
+  // Views dimension elements starting at data, stride elements apart
+  BasicConstVectorView(const T* data, size_t dimension, size_t stride = 1) noexcept;
+
+  // Views a whole vector
+  BasicConstVectorView(const BasicVector<T>& vector) noexcept;
+
+  // Returns the number of elements in the view
+  size_t dimension() const noexcept { return m_dimension; }
+
+  // Distance in elements between two consecutive entries
+  size_t stride() const noexcept { return m_stride; }
+
+  // Unchecked element read used by expression evaluation
+  T coeff(size_t index) const noexcept { return m_data[index * m_stride]; }
+
+  // Returns a const reference to the element at a specific index (read-only)
+  const T& operator[](size_t index) const;
+
+  // Pointer to the first element
+  const T* data() const noexcept { return m_data; }
+
+  // Returns the elements [first, first + count) as a view
+  BasicConstVectorView segment(size_t first, size_t count) const;
+
+  // Calculates the magnitude (length) of the viewed elements
+  double magnitude() const noexcept;
+
+  // Prints the viewed content to an output stream
+  void print(std::ostream& out) const noexcept;
+
+private:
+  const T* m_data;
+  size_t m_dimension, m_stride;
+};
+
+// Writable, non-owning strided window, e.g. a row, column or diagonal of a matrix.
+template <typename T>
+class BasicVectorView : public expr::VectorExpression<BasicVectorView<T>> {
+public:
+  // Views dimension elements starting at data, stride elements apart
+  BasicVectorView(T* data, size_t dimension, size_t stride = 1) noexcept;
+
+  // Views a whole vector
+  BasicVectorView(BasicVector<T>& vector) noexcept;
+
+  // Copying a view aliases the same elements
+  BasicVectorView(const BasicVectorView& other) = default;
+
+  // Assignment writes through to the viewed elements (dimensions must match)
+  BasicVectorView& operator=(const BasicVectorView& other);
+
+  // Evaluates an expression straight into the viewed elements (dimensions must match)
+  template <typename E>
+  BasicVectorView& operator=(const expr::VectorExpression<E>& expression);
+
+  // Read-only view of the same elements
+  operator BasicConstVectorView<T>() const noexcept { return BasicConstVectorView<T>(m_data, m_dimension, m_stride); }
+
+  size_t dimension() const noexcept { return m_dimension; }
+  size_t stride() const noexcept { return m_stride; }
+  T coeff(size_t index) const noexcept { return m_data[index * m_stride]; }
+  T* data() const noexcept { return m_data; }
+
+  // Returns a reference to the element at a specific index (modification)
+  T& operator[](size_t index) const;
+
+  // Returns the elements [first, first + count) as a view
+  BasicVectorView segment(size_t first, size_t count) const;
+
+  // Calculates the magnitude (length) of the viewed elements
+  double magnitude() const noexcept;
+
+private:
+  T* m_data;
+  size_t m_dimension, m_stride;
+};
+
+// Read-only, non-owning row-major window with unit column stride onto a matrix or a block of it.
+template <typename T>
+class BasicConstMatrixView : public expr::MatrixExpression<BasicConstMatrixView<T>> {
+public:
+  // Views a row_count x column_count block starting at data, rows stride elements apart
+  BasicConstMatrixView(const T* data, size_t row_count, size_t column_count, size_t stride) noexcept;
+
+  // Views a whole matrix
+  BasicConstMatrixView(const BasicMatrix<T>& matrix) noexcept;
+
+  size_t getRowCount() const noexcept { return m_row_count; }
+  size_t getColumnCount() const noexcept { return m_column_count; }
+  size_t stride() const noexcept { return m_stride; }
+  const T* data() const noexcept { return m_data; }
+  T coeff(size_t row, size_t column) const noexcept { return m_data[row * m_stride + column]; }
+  const T& operator()(size_t row, size_t column) const noexcept { return m_data[row * m_stride + column]; }
+
+  // Row, column, main diagonal and rectangular block views (all bounds checked)
+  BasicConstVectorView<T> row(size_t index) const;
+  BasicConstVectorView<T> column(size_t index) const;
+  BasicConstVectorView<T> diagonal() const noexcept;
+  BasicConstMatrixView block(size_t first_row, size_t first_column, size_t row_count, size_t column_count) const;
+
+  void print_matrix(std::ostream& buff) const noexcept;
+
+private:
+  const T* m_data;
+  size_t m_row_count, m_column_count, m_stride;
+};
+
+// Writable, non-owning row-major window with unit column stride onto a matrix or a block of it.
+template <typename T>
+class BasicMatrixView : public expr::MatrixExpression<BasicMatrixView<T>> {
+public:
+  // Views a row_count x column_count block starting at data, rows stride elements apart
+  BasicMatrixView(T* data, size_t row_count, size_t column_count, size_t stride) noexcept;
+
+  // Views a whole matrix
+  BasicMatrixView(BasicMatrix<T>& matrix) noexcept;
+
+  // Copying a view aliases the same elements
+  BasicMatrixView(const BasicMatrixView& other) = default;
+
+  // Assignment writes through to the viewed elements (shapes must match)
+  BasicMatrixView& operator=(const BasicMatrixView& other);
+
+  // Evaluates an expression straight into the viewed elements (shapes must match)
+  template <typename E>
+  BasicMatrixView& operator=(const expr::MatrixExpression<E>& expression);
+
+  // Read-only view of the same elements
+  operator BasicConstMatrixView<T>() const noexcept {
+    return BasicConstMatrixView<T>(m_data, m_row_count, m_column_count, m_stride);
+  }
+
+  size_t getRowCount() const noexcept { return m_row_count; }
+  size_t getColumnCount() const noexcept { return m_column_count; }
+  size_t stride() const noexcept { return m_stride; }
+  T* data() const noexcept { return m_data; }
+  T coeff(size_t row, size_t column) const noexcept { return m_data[row * m_stride + column]; }
+  T& operator()(size_t row, size_t column) const noexcept { return m_data[row * m_stride + column]; }
+
+  // Row, column, main diagonal and rectangular block views (all bounds checked)
+  BasicVectorView<T> row(size_t index) const;
+  BasicVectorView<T> column(size_t index) const;
+  BasicVectorView<T> diagonal() const noexcept;
+  BasicMatrixView block(size_t first_row, size_t first_column, size_t row_count, size_t column_count) const;
+
+private:
+  T* m_data;
+  size_t m_row_count, m_column_count, m_stride;
+};
+
+// Views of double elements, the ones the rest of the library works on.
+using ConstVectorView = BasicConstVectorView<double>;
+using VectorView = BasicVectorView<double>;
+using ConstMatrixView = BasicConstMatrixView<double>;
+using MatrixView = BasicMatrixView<double>;
+
+template <typename T>
+template <typename E>
+BasicVectorView<T>& BasicVectorView<T>::operator=(const expr::VectorExpression<E>& expression) {
+  const E& node = expression.self();
+  if (node.dimension() != m_dimension) {
+    throw std::invalid_argument("Vectors must have the same dimension for assignment");
+  }
+  for (size_t i = 0; i < m_dimension; ++i) {
+    m_data[i * m_stride] = static_cast<T>(node.coeff(i));
+  }
+  return *this;
+}
+
+template <typename T>
+template <typename E>
+BasicMatrixView<T>& BasicMatrixView<T>::operator=(const expr::MatrixExpression<E>& expression) {
+  const E& node = expression.self();
+  if (node.getRowCount() != m_row_count || node.getColumnCount() != m_column_count) {
+    throw -1;
+  }
+  // Unqualified, so that the kernels matrix.h declares for MATRIX operands are found at instantiation
+  evaluate(m_data, m_stride, node);
+  return *this;
+}
@@ -0,0 +1,136 @@
+#include "../include/aligned_buffer.h"
+#include "../include/arena.h"
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    template <typename T>
+    T *allocate_aligned(std::pmr::memory_resource *resource, size_t count)
+    {
+        if (count == 0)
+        {
+            return nullptr;
+        }
+        return static_cast<T *>(resource->allocate(count * sizeof(T), AlignedBuffer::alignment));
+    }
+
+    template <typename T>
+    void release_aligned(std::pmr::memory_resource *resource, T *block, size_t count) noexcept
+    {
+        if (block != nullptr)
+        {
+            resource->deallocate(block, count * sizeof(T), AlignedBuffer::alignment);
+        }
+    }
+}
+
+template <typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer() noexcept : m_data(nullptr), m_size(0), m_resource(memory::heap()) {}
+
+template <typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer(size_t count) : BasicAlignedBuffer(count, memory::current_resource()) {}
+
+template <typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer(size_t count, std::pmr::memory_resource *resource)
+    : m_data(allocate_aligned<T>(resource, count)), m_size(count), m_resource(resource)
+{
+    if (m_size != 0)
+    {
+        std::memset(m_data, 0, m_size * sizeof(T));
+    }
+}
+
+template <typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer(T *block, size_t count, std::pmr::memory_resource *resource) noexcept
+    : m_data(block), m_size(count), m_resource(resource)
+{
+}
+
+template <typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer(const BasicAlignedBuffer &other)
+    : m_data(allocate_aligned<T>(memory::current_resource(), other.m_size)), m_size(other.m_size),
+      m_resource(memory::current_resource())
+{
+    if (m_size != 0)
+    {
+        std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+    }
+}
+
+template <typename T>
+BasicAlignedBuffer<T>::BasicAlignedBuffer(BasicAlignedBuffer &&other) noexcept
+    : m_data(other.m_data), m_size(other.m_size), m_resource(other.m_resource)
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+}
+
+template <typename T>
+BasicAlignedBuffer<T> &BasicAlignedBuffer<T>::operator=(const BasicAlignedBuffer &other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    // Only reallocate when the block size changes
+    if (m_size != other.m_size)
+    {
+        T *block = allocate_aligned<T>(m_resource, other.m_size);
+        release_aligned(m_resource, m_data, m_size);
+        m_data = block;
+        m_size = other.m_size;
+    }
+    if (m_size != 0)
+    {
+        std::memcpy(m_data, other.m_data, m_size * sizeof(T));
+    }
+    return *this;
+}
+
+template <typename T>
+BasicAlignedBuffer<T> &BasicAlignedBuffer<T>::operator=(BasicAlignedBuffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        release_aligned(m_resource, m_data, m_size);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_resource = other.m_resource;
+    }
+    return *this;
+}
+
+template <typename T>
+BasicAlignedBuffer<T>::~BasicAlignedBuffer()
+{
+    release_aligned(m_resource, m_data, m_size);
+}
+
+template <typename T>
+T *BasicAlignedBuffer<T>::data() noexcept
+{
+    return m_data;
+}
+
+template <typename T>
+const T *BasicAlignedBuffer<T>::data() const noexcept
+{
+    return m_data;
+}
+
+template <typename T>
+size_t BasicAlignedBuffer<T>::size() const noexcept
+{
+    return m_size;
+}
+
+template <typename T>
+std::pmr::memory_resource *BasicAlignedBuffer<T>::resource() const noexcept
+{
+    return m_resource;
+}
+
+template class BasicAlignedBuffer<float>;
+template class BasicAlignedBuffer<double>;
@@ -0,0 +1,211 @@
+#include "../include/arena.h"
+#include "../include/aligned_buffer.h"
+#include "../include/instrument.h"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+    // Null means the heap, so that threads start out on it without any initialisation
+    thread_local std::pmr::memory_resource *current = nullptr;
+
+    // Holds an arena's spin lock for its lifetime. Allocations are a few instructions, so the lock is
+    // only ever contended by chunks of one parallel_for.
+    class SpinLock
+    {
+    public:
+        explicit SpinLock(std::atomic_flag &flag) noexcept : m_flag(flag)
+        {
+            while (m_flag.test_and_set(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        ~SpinLock()
+        {
+            m_flag.clear(std::memory_order_release);
+        }
+
+        SpinLock(const SpinLock &) = delete;
+        SpinLock &operator=(const SpinLock &) = delete;
+
+    private:
+        std::atomic_flag &m_flag;
+    };
+
+    char *align_up(char *pointer, size_t alignment) noexcept
+    {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(pointer);
+        return pointer + ((alignment - address % alignment) % alignment);
+    }
+
+#if TSMATH_INSTRUMENTATION
+    // new/delete that charges every allocation to the kernel running on the allocating thread
+    class CountingHeap : public std::pmr::memory_resource
+    {
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            instrument::record_allocation(bytes);
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *block, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(block, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+#endif
+}
+
+std::pmr::memory_resource *memory::heap() noexcept
+{
+#if TSMATH_INSTRUMENTATION
+    static CountingHeap counting;
+    return &counting;
+#else
+    return std::pmr::new_delete_resource();
+#endif
+}
+
+std::pmr::memory_resource *memory::current_resource() noexcept
+{
+    return current != nullptr ? current : heap();
+}
+
+memory::ScopedResource::ScopedResource(std::pmr::memory_resource *resource) noexcept : m_previous(current)
+{
+    current = resource;
+}
+
+memory::ScopedResource::~ScopedResource()
+{
+    current = m_previous;
+}
+
+memory::Arena::Arena(size_t chunk_bytes, std::pmr::memory_resource *upstream)
+    : m_chunk_bytes(std::max<size_t>(chunk_bytes, AlignedBuffer::alignment)), m_upstream(upstream)
+{
+}
+
+memory::Arena::~Arena()
+{
+    release();
+}
+
+memory::Arena::Mark memory::Arena::mark() const noexcept
+{
+    return Mark{m_current, m_offset};
+}
+
+void memory::Arena::rewind(Mark position) noexcept
+{
+    m_current = position.chunk;
+    m_offset = position.offset;
+}
+
+void memory::Arena::reset() noexcept
+{
+    rewind(Mark{0, 0});
+}
+
+void memory::Arena::release() noexcept
+{
+    for (const Chunk &chunk : m_chunks)
+    {
+        m_upstream->deallocate(chunk.data, chunk.size, chunk.alignment);
+    }
+    m_chunks.clear();
+    reset();
+}
+
+size_t memory::Arena::used() const noexcept
+{
+    size_t bytes = m_offset;
+    for (size_t c = 0; c < m_current && c < m_chunks.size(); c++)
+    {
+        bytes += m_chunks[c].size;
+    }
+    return bytes;
+}
+
+size_t memory::Arena::capacity() const noexcept
+{
+    size_t bytes = 0;
+    for (const Chunk &chunk : m_chunks)
+    {
+        bytes += chunk.size;
+    }
+    return bytes;
+}
+
+void *memory::Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    SpinLock lock(m_lock);
+    if (!m_chunks.empty())
+    {
+        const Chunk &chunk = m_chunks[m_current];
+        char *block = align_up(chunk.data + m_offset, alignment);
+        if (block + bytes <= chunk.data + chunk.size)
+        {
+            m_offset = block + bytes - chunk.data;
+            return block;
+        }
+    }
+
+    // Move on to the next chunk, kept from before a rewind when it is large enough, else a new one
+    // inserted right after the current chunk
+    const size_t next = m_chunks.empty() ? 0 : m_current + 1;
+    if (next == m_chunks.size() || m_chunks[next].size < bytes + alignment)
+    {
+        const size_t size = std::max(m_chunk_bytes, bytes + alignment);
+        const size_t chunk_alignment = std::max(alignment, AlignedBuffer::alignment);
+        char *data = static_cast<char *>(m_upstream->allocate(size, chunk_alignment));
+        m_chunks.insert(m_chunks.begin() + next, Chunk{data, size, chunk_alignment});
+    }
+    m_current = next;
+    char *block = align_up(m_chunks[next].data, alignment);
+    m_offset = block + bytes - m_chunks[next].data;
+    return block;
+}
+
+void memory::Arena::do_deallocate(void *block, size_t bytes, size_t)
+{
+    // Give back the latest block, so that short-lived temporaries freed in order reuse the space
+    SpinLock lock(m_lock);
+    if (m_chunks.empty())
+    {
+        return;
+    }
+    char *data = m_chunks[m_current].data;
+    if (static_cast<char *>(block) + bytes == data + m_offset && static_cast<char *>(block) >= data)
+    {
+        m_offset = static_cast<char *>(block) - data;
+    }
+}
+
+bool memory::Arena::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+{
+    return this == &other;
+}
+
+memory::Arena &memory::thread_arena()
+{
+    thread_local Arena arena;
+    return arena;
+}
+
+memory::ScopedArena::ScopedArena(Arena &arena) noexcept : m_arena(arena), m_mark(arena.mark()), m_resource(&arena)
+{
+}
+
+memory::ScopedArena::~ScopedArena()
+{
+    m_arena.rewind(m_mark);
+}
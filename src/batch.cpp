@@ -0,0 +1,387 @@
+#include "../include/batch.h"
+#include "../include/macros.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr size_t L = batch::MatrixBatch::lanes;
+
+    // Groups handed to one thread at a time.
+    constexpr size_t GROUP_GRAIN = 64;
+
+    // One interleaved group of C = alpha * A * B + beta * C, the lane loop is the SIMD dimension.
+    inline void gemm_group(size_t n, size_t m, size_t p, double alpha, const double *a, const double *b, double beta,
+                           double *c)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < p; j++)
+            {
+                double acc[L] = {};
+                for (size_t k = 0; k < m; k++)
+                {
+                    const double *x = a + (i * m + k) * L;
+                    const double *y = b + (k * p + j) * L;
+                    for (size_t l = 0; l < L; l++)
+                    {
+                        acc[l] += x[l] * y[l];
+                    }
+                }
+                double *z = c + (i * p + j) * L;
+                for (size_t l = 0; l < L; l++)
+                {
+                    z[l] = beta == 0.0 ? alpha * acc[l] : alpha * acc[l] + beta * z[l];
+                }
+            }
+        }
+    }
+
+    // x -= f * y over one lane block; staging through a local keeps the compiler from assuming x aliases y
+    inline void subtract_product(double *x, const double *f, const double *y)
+    {
+        double t[L];
+        for (size_t l = 0; l < L; l++)
+        {
+            t[l] = x[l] - f[l] * y[l];
+        }
+        for (size_t l = 0; l < L; l++)
+        {
+            x[l] = t[l];
+        }
+    }
+
+    // One interleaved group of A X = B with per-lane partial pivoting; a is scratch and is destroyed.
+    // Lanes that meet a zero pivot are marked in 'singular' and continue with a unit pivot.
+    inline void gpp_group(size_t n, size_t r, double *a, double *b, unsigned char *singular)
+    {
+        for (size_t j = 0; j < n; j++)
+        {
+            // Per-lane pivot search down column j
+            double best[L], pivot_row[L];
+            for (size_t l = 0; l < L; l++)
+            {
+                best[l] = std::abs(a[(j * n + j) * L + l]);
+                pivot_row[l] = double(j);
+            }
+            for (size_t i = j + 1; i < n; i++)
+            {
+                const double *x = a + (i * n + j) * L;
+                for (size_t l = 0; l < L; l++)
+                {
+                    const double v = std::abs(x[l]);
+                    pivot_row[l] = v > best[l] ? double(i) : pivot_row[l];
+                    best[l] = v > best[l] ? v : best[l];
+                }
+            }
+
+            // Per-lane row swaps as blends, row j against every candidate row
+            for (size_t i = j + 1; i < n; i++)
+            {
+                bool any = false;
+                for (size_t l = 0; l < L; l++)
+                {
+                    any |= pivot_row[l] == double(i);
+                }
+                if (!any)
+                {
+                    continue;
+                }
+                for (size_t c = 0; c < n + r; c++)
+                {
+                    double *top = c < n ? a + (j * n + c) * L : b + (j * r + c - n) * L;
+                    double *other = c < n ? a + (i * n + c) * L : b + (i * r + c - n) * L;
+                    for (size_t l = 0; l < L; l++)
+                    {
+                        const bool swap = pivot_row[l] == double(i);
+                        const double x = top[l], y = other[l];
+                        top[l] = swap ? y : x;
+                        other[l] = swap ? x : y;
+                    }
+                }
+            }
+
+            double inverse_pivot[L];
+            for (size_t l = 0; l < L; l++)
+            {
+                const double d = a[(j * n + j) * L + l];
+                singular[l] |= d == 0.0;
+                inverse_pivot[l] = 1.0 / (d == 0.0 ? 1.0 : d);
+            }
+
+            // Eliminate below the pivot in A and B
+            for (size_t i = j + 1; i < n; i++)
+            {
+                double factor[L];
+                for (size_t l = 0; l < L; l++)
+                {
+                    factor[l] = a[(i * n + j) * L + l] * inverse_pivot[l];
+                }
+                for (size_t c = j + 1; c < n; c++)
+                {
+                    subtract_product(a + (i * n + c) * L, factor, a + (j * n + c) * L);
+                }
+                for (size_t c = 0; c < r; c++)
+                {
+                    subtract_product(b + (i * r + c) * L, factor, b + (j * r + c) * L);
+                }
+            }
+        }
+
+        // Back substitution
+        for (size_t i = n; i-- > 0;)
+        {
+            double inverse_pivot[L];
+            for (size_t l = 0; l < L; l++)
+            {
+                const double d = a[(i * n + i) * L + l];
+                inverse_pivot[l] = 1.0 / (d == 0.0 ? 1.0 : d);
+            }
+            for (size_t c = 0; c < r; c++)
+            {
+                double *x = b + (i * r + c) * L;
+                for (size_t k = i + 1; k < n; k++)
+                {
+                    subtract_product(x, a + (i * n + k) * L, b + (k * r + c) * L);
+                }
+                for (size_t l = 0; l < L; l++)
+                {
+                    x[l] *= inverse_pivot[l];
+                }
+            }
+        }
+    }
+
+    struct GemmTask
+    {
+        size_t n, m, p;
+        double alpha, beta;
+        const double *a, *b;
+        double *c;
+    };
+
+    struct GppTask
+    {
+        size_t n, r;
+        const double *a;
+        double *b;
+        unsigned char *singular;
+    };
+
+    void gemm_groups(const GemmTask &t, size_t begin, size_t end)
+    {
+        for (size_t g = begin; g < end; g++)
+        {
+            gemm_group(t.n, t.m, t.p, t.alpha, t.a + g * t.n * t.m * L, t.b + g * t.m * t.p * L, t.beta,
+                       t.c + g * t.n * t.p * L);
+        }
+    }
+
+    void gpp_groups(const GppTask &t, size_t begin, size_t end)
+    {
+        std::vector<double> scratch(t.n * t.n * L);
+        for (size_t g = begin; g < end; g++)
+        {
+            std::memcpy(scratch.data(), t.a + g * t.n * t.n * L, scratch.size() * sizeof(double));
+            gpp_group(t.n, t.r, scratch.data(), t.b + g * t.n * t.r * L, t.singular + g * L);
+        }
+    }
+
+#if TSMATH_X86
+    // The same loops compiled for wider registers, the lane loops then map onto ymm/zmm registers.
+    TSMATH_TARGET("avx2,fma")
+    void gemm_groups_avx2(const GemmTask &t, size_t begin, size_t end)
+    {
+        gemm_groups(t, begin, end);
+    }
+
+    TSMATH_TARGET("avx512f")
+    void gemm_groups_avx512(const GemmTask &t, size_t begin, size_t end)
+    {
+        gemm_groups(t, begin, end);
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    void gpp_groups_avx2(const GppTask &t, size_t begin, size_t end)
+    {
+        gpp_groups(t, begin, end);
+    }
+
+    TSMATH_TARGET("avx512f")
+    void gpp_groups_avx512(const GppTask &t, size_t begin, size_t end)
+    {
+        gpp_groups(t, begin, end);
+    }
+#endif
+
+    template <typename Task>
+    void run(const Task &task, size_t groups, void (*scalar)(const Task &, size_t, size_t),
+             void (*avx2)(const Task &, size_t, size_t), void (*avx512)(const Task &, size_t, size_t))
+    {
+        auto kernel = scalar;
+        switch (simd::active_isa())
+        {
+        case simd::isa::avx512:
+            kernel = avx512;
+            break;
+        case simd::isa::avx2:
+            kernel = avx2;
+            break;
+        default:
+            break;
+        }
+        parallel::parallel_for(groups, GROUP_GRAIN, [&](size_t begin, size_t end) { kernel(task, begin, end); });
+    }
+
+    std::vector<size_t> singular_indices(const std::vector<unsigned char> &singular, size_t count)
+    {
+        std::vector<size_t> indices;
+        for (size_t k = 0; k < count; k++)
+        {
+            if (singular[k])
+            {
+                indices.push_back(k);
+            }
+        }
+        return indices;
+    }
+}
+
+batch::MatrixBatch::MatrixBatch(size_t count, size_t row_count, size_t column_count)
+    : m_buffer((count + L - 1) / L * L * row_count * column_count), m_count(count), m_row_count(row_count),
+      m_column_count(column_count)
+{
+}
+
+size_t batch::MatrixBatch::size() const noexcept
+{
+    return m_count;
+}
+
+size_t batch::MatrixBatch::getRowCount() const noexcept
+{
+    return m_row_count;
+}
+
+size_t batch::MatrixBatch::getColumnCount() const noexcept
+{
+    return m_column_count;
+}
+
+size_t batch::MatrixBatch::groups() const noexcept
+{
+    return (m_count + L - 1) / L;
+}
+
+double &batch::MatrixBatch::operator()(size_t index, size_t row, size_t column) noexcept
+{
+    return m_buffer.data()[(((index / L) * m_row_count + row) * m_column_count + column) * L + index % L];
+}
+
+const double &batch::MatrixBatch::operator()(size_t index, size_t row, size_t column) const noexcept
+{
+    return m_buffer.data()[(((index / L) * m_row_count + row) * m_column_count + column) * L + index % L];
+}
+
+void batch::MatrixBatch::set(size_t index, ConstMatrixView value)
+{
+    if (index >= m_count)
+    {
+        throw std::out_of_range("Batch index out of bounds");
+    }
+    if (value.getRowCount() != m_row_count || value.getColumnCount() != m_column_count)
+    {
+        throw std::invalid_argument("Matrix shape does not match the batch");
+    }
+    for (size_t i = 0; i < m_row_count; i++)
+    {
+        for (size_t j = 0; j < m_column_count; j++)
+        {
+            (*this)(index, i, j) = value(i, j);
+        }
+    }
+}
+
+MATRIX batch::MatrixBatch::get(size_t index) const
+{
+    if (index >= m_count)
+    {
+        throw std::out_of_range("Batch index out of bounds");
+    }
+    MATRIX result(m_row_count, m_column_count);
+    for (size_t i = 0; i < m_row_count; i++)
+    {
+        for (size_t j = 0; j < m_column_count; j++)
+        {
+            result(i, j) = (*this)(index, i, j);
+        }
+    }
+    return result;
+}
+
+double *batch::MatrixBatch::data() noexcept
+{
+    return m_buffer.data();
+}
+
+const double *batch::MatrixBatch::data() const noexcept
+{
+    return m_buffer.data();
+}
+
+void batch::gemm(double alpha, const MatrixBatch &A, const MatrixBatch &B, double beta, MatrixBatch &C)
+{
+    if (A.size() != B.size() || A.size() != C.size() || A.getColumnCount() != B.getRowCount() ||
+        C.getRowCount() != A.getRowCount() || C.getColumnCount() != B.getColumnCount())
+    {
+        throw std::invalid_argument("Batch dimensions do not match for gemm");
+    }
+
+    GemmTask task{A.getRowCount(), A.getColumnCount(), B.getColumnCount(), alpha, beta, A.data(), B.data(), C.data()};
+#if TSMATH_X86
+    run(task, A.groups(), gemm_groups, gemm_groups_avx2, gemm_groups_avx512);
+#else
+    run(task, A.groups(), gemm_groups, gemm_groups, gemm_groups);
+#endif
+}
+
+std::vector<size_t> batch::gpp(const MatrixBatch &A, MatrixBatch &B)
+{
+    if (A.size() != B.size() || A.getRowCount() != A.getColumnCount() || B.getRowCount() != A.getRowCount())
+    {
+        throw std::invalid_argument("Batch dimensions do not match for gpp");
+    }
+
+    std::vector<unsigned char> singular(A.groups() * L, 0);
+    GppTask task{A.getRowCount(), B.getColumnCount(), A.data(), B.data(), singular.data()};
+#if TSMATH_X86
+    run(task, A.groups(), gpp_groups, gpp_groups_avx2, gpp_groups_avx512);
+#else
+    run(task, A.groups(), gpp_groups, gpp_groups, gpp_groups);
+#endif
+    return singular_indices(singular, A.size());
+}
+
+std::vector<size_t> batch::inverse(const MatrixBatch &A, MatrixBatch &result)
+{
+    if (result.size() != A.size() || result.getRowCount() != A.getRowCount() ||
+        result.getColumnCount() != A.getColumnCount())
+    {
+        throw std::invalid_argument("Batch dimensions do not match for inverse");
+    }
+
+    // Solve against the identity in every lane
+    std::fill_n(result.data(), result.groups() * result.getRowCount() * result.getColumnCount() * L, 0.0);
+    for (size_t g = 0; g < result.groups(); g++)
+    {
+        for (size_t i = 0; i < result.getRowCount(); i++)
+        {
+            std::fill_n(result.data() + ((g * result.getRowCount() + i) * result.getColumnCount() + i) * L, L, 1.0);
+        }
+    }
+    return gpp(A, result);
+}
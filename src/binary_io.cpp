@@ -0,0 +1,420 @@
+#include "../include/binary_io.h"
+#include "../include/arena.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TSMATH_HAS_MMAP 1
+#else
+#define TSMATH_HAS_MMAP 0
+#endif
+
+namespace
+{
+    constexpr char MAGIC[8] = {'T', 'S', 'M', 'A', 'T', 'H', 'B', '\0'};
+
+    // Elements per padded row line, the same rounding as MATRIX uses.
+    constexpr size_t LINE = AlignedBuffer::alignment / sizeof(double);
+
+    // Bytes the Writer collects before each write to the file.
+    constexpr size_t STAGING_BYTES = 4 << 20;
+
+    [[noreturn]] void fail(const std::string &path, const char *what)
+    {
+        throw std::runtime_error("binary: " + path + ": " + what);
+    }
+
+    void validate(const binary::Header &header, std::uint64_t file_size, const std::string &path)
+    {
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            fail(path, "not a tsmath binary file");
+        }
+        if (header.byte_order != binary::ORDER_MARK)
+        {
+            fail(path, "written with a different byte order");
+        }
+        if (header.version == 0 || header.version > binary::VERSION)
+        {
+            fail(path, "unsupported format version");
+        }
+        const bool tiled = header.layout == binary::Layout::tiled;
+        if (header.dtype != binary::DType::float64 || (header.layout != binary::Layout::row_major && !tiled))
+        {
+            fail(path, "unsupported element type or layout");
+        }
+        if ((tiled ? header.stride == 0 || header.stride % LINE != 0 : header.stride < header.columns) ||
+            header.data_offset < sizeof(binary::Header) || header.data_offset % sizeof(double) != 0)
+        {
+            fail(path, "corrupt header");
+        }
+
+        // Overflow-safe form of data_offset + blocks * block * 8 <= file_size, a block being a row or a tile
+        std::uint64_t blocks = header.rows, block = header.stride;
+        if (tiled)
+        {
+            const std::uint64_t tile_rows = (header.rows + header.stride - 1) / header.stride;
+            const std::uint64_t tile_columns = (header.columns + header.stride - 1) / header.stride;
+            blocks = tile_columns == 0 ? 0 : tile_rows;
+            block = tile_columns > UINT64_MAX / header.stride / header.stride ? UINT64_MAX
+                                                                               : tile_columns * header.stride * header.stride;
+        }
+        const std::uint64_t room = (file_size - std::min(file_size, header.data_offset)) / sizeof(double);
+        if (file_size < header.data_offset || (block != 0 && blocks > room / block))
+        {
+            fail(path, "file is shorter than its header announces");
+        }
+    }
+
+#if TSMATH_HAS_MMAP
+    // Releases the element blocks handed to AlignedBuffers by binary::adopt: deallocating one of them
+    // unmaps its file, everything else is passed to the heap (a buffer that outgrows its mapping
+    // reallocates from its resource). Lives for the whole program, so that buffers may outlive any scope.
+    class MappingResource : public std::pmr::memory_resource
+    {
+    public:
+        void add(const void *block, void *base, size_t length)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_mappings.emplace(block, std::make_pair(base, length));
+        }
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            return memory::heap()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *block, size_t bytes, size_t alignment) override
+        {
+            std::pair<void *, size_t> mapping{nullptr, 0};
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                const auto found = m_mappings.find(block);
+                if (found != m_mappings.end())
+                {
+                    mapping = found->second;
+                    m_mappings.erase(found);
+                }
+            }
+            if (mapping.first != nullptr)
+            {
+                munmap(mapping.first, mapping.second);
+                return;
+            }
+            memory::heap()->deallocate(block, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+
+        std::mutex m_mutex;
+        std::unordered_map<const void *, std::pair<void *, size_t>> m_mappings;
+    };
+
+    MappingResource &mapping_resource()
+    {
+        static MappingResource *instance = new MappingResource();
+        return *instance;
+    }
+#endif
+}
+
+binary::Header binary::make_header(size_t rows, size_t columns) noexcept
+{
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = ORDER_MARK;
+    header.dtype = DType::float64;
+    header.layout = Layout::row_major;
+    header.alignment = AlignedBuffer::alignment;
+    header.rows = rows;
+    header.columns = columns;
+    header.stride = columns < LINE ? columns : (columns + LINE - 1) / LINE * LINE;
+    header.data_offset = sizeof(Header);
+    return header;
+}
+
+binary::Header binary::read_header(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+    {
+        fail(path, "cannot open");
+    }
+    const std::uint64_t size = static_cast<std::uint64_t>(in.tellg());
+    Header header{};
+    in.seekg(0);
+    if (size < sizeof(Header) || !in.read(reinterpret_cast<char *>(&header), sizeof(Header)))
+    {
+        fail(path, "not a tsmath binary file");
+    }
+    validate(header, size, path);
+    return header;
+}
+
+binary::MappedFile::MappedFile(const std::string &path, Access access) : m_access(access)
+{
+#if TSMATH_HAS_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        fail(path, "cannot open");
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<std::uint64_t>(status.st_size) < sizeof(Header))
+    {
+        ::close(fd);
+        fail(path, "not a tsmath binary file");
+    }
+
+    // Private mappings in both modes: the file is never written through one
+    const int protection = access == Access::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    m_length = static_cast<size_t>(status.st_size);
+    void *base = mmap(nullptr, m_length, protection, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+    {
+        fail(path, "cannot map");
+    }
+    m_base = base;
+
+    std::memcpy(&m_header, m_base, sizeof(Header));
+    try
+    {
+        validate(m_header, m_length, path);
+        if (m_header.layout != Layout::row_major)
+        {
+            fail(path, "holds a tiled matrix, open it as a TiledMatrix");
+        }
+    }
+    catch (...)
+    {
+        unmap();
+        throw;
+    }
+#else
+    fail(path, "memory-mapped files need a POSIX system");
+#endif
+}
+
+binary::MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+binary::MappedFile::MappedFile(MappedFile &&other) noexcept
+    : m_base(std::exchange(other.m_base, nullptr)), m_length(std::exchange(other.m_length, 0)),
+      m_header(other.m_header), m_access(other.m_access)
+{
+}
+
+binary::MappedFile &binary::MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        m_base = std::exchange(other.m_base, nullptr);
+        m_length = std::exchange(other.m_length, 0);
+        m_header = other.m_header;
+        m_access = other.m_access;
+    }
+    return *this;
+}
+
+void binary::MappedFile::unmap() noexcept
+{
+#if TSMATH_HAS_MMAP
+    if (m_base != nullptr)
+    {
+        munmap(m_base, m_length);
+    }
+#endif
+    m_base = nullptr;
+    m_length = 0;
+}
+
+const binary::Header &binary::MappedFile::header() const noexcept
+{
+    return m_header;
+}
+
+binary::Access binary::MappedFile::access() const noexcept
+{
+    return m_access;
+}
+
+ConstMatrixView binary::MappedFile::matrix() const noexcept
+{
+    const double *data = m_base == nullptr ? nullptr
+                                           : reinterpret_cast<const double *>(static_cast<const char *>(m_base) +
+                                                                              m_header.data_offset);
+    return ConstMatrixView(data, m_header.rows, m_header.columns, m_header.stride);
+}
+
+MatrixView binary::MappedFile::writable_matrix()
+{
+    if (m_access != Access::copy_on_write)
+    {
+        throw std::invalid_argument("A writable view needs a copy-on-write mapping");
+    }
+    const ConstMatrixView view = matrix();
+    return MatrixView(const_cast<double *>(view.data()), view.getRowCount(), view.getColumnCount(), view.stride());
+}
+
+ConstVectorView binary::MappedFile::vector() const
+{
+    const ConstMatrixView view = matrix();
+    if (view.getRowCount() == 1)
+    {
+        return ConstVectorView(view.data(), view.getColumnCount(), 1);
+    }
+    if (view.getColumnCount() == 1)
+    {
+        return ConstVectorView(view.data(), view.getRowCount(), view.stride());
+    }
+    throw std::invalid_argument("File does not hold a single row or column");
+}
+
+AlignedBuffer binary::adopt(MappedFile &&file)
+{
+    const size_t count = file.m_header.rows * file.m_header.stride;
+    if (file.m_base == nullptr || count == 0 || file.m_access != Access::copy_on_write ||
+        file.m_header.data_offset % AlignedBuffer::alignment != 0)
+    {
+        throw std::invalid_argument("Mapping cannot be adopted by an AlignedBuffer");
+    }
+#if TSMATH_HAS_MMAP
+    double *block = reinterpret_cast<double *>(static_cast<char *>(file.m_base) + file.m_header.data_offset);
+    mapping_resource().add(block, file.m_base, file.m_length);
+    file.m_base = nullptr;
+    file.m_length = 0;
+    return AlignedBuffer(block, count, &mapping_resource());
+#else
+    return AlignedBuffer();
+#endif
+}
+
+binary::Writer::Writer(const std::string &path, size_t rows, size_t columns)
+    : m_out(path, std::ios::binary | std::ios::trunc), m_path(path), m_header(make_header(rows, columns))
+{
+    if (!m_out)
+    {
+        fail(path, "cannot create");
+    }
+    m_out.write(reinterpret_cast<const char *>(&m_header), sizeof(Header));
+
+    // Whole padded rows, at least one
+    const size_t stride = std::max<size_t>(m_header.stride, 1);
+    m_staging.resize(std::max<size_t>(STAGING_BYTES / sizeof(double) / stride, 1) * stride);
+}
+
+binary::Writer::~Writer()
+{
+    if (m_out.is_open())
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+    }
+}
+
+void binary::Writer::write(ConstMatrixView rows)
+{
+    if (rows.getColumnCount() != m_header.columns)
+    {
+        throw std::invalid_argument("Rows do not match the column count of the file");
+    }
+    if (rows.getRowCount() > m_header.rows - m_rows_written)
+    {
+        throw std::invalid_argument("More rows than the file was created for");
+    }
+    const size_t columns = m_header.columns, stride = m_header.stride;
+    for (size_t i = 0; i < rows.getRowCount(); i++)
+    {
+        if (m_staged == m_staging.size())
+        {
+            flush();
+        }
+        // Padding is written as zeros whatever the view holds past its columns
+        double *target = m_staging.data() + m_staged;
+        std::copy_n(rows.data() + i * rows.stride(), columns, target);
+        std::fill(target + columns, target + stride, 0.0);
+        m_staged += stride;
+    }
+    m_rows_written += rows.getRowCount();
+}
+
+void binary::Writer::write(ConstVectorView row)
+{
+    if (row.stride() == 1)
+    {
+        write(ConstMatrixView(row.data(), 1, row.dimension(), row.dimension()));
+        return;
+    }
+    // Gather a strided row first
+    std::vector<double> gathered(row.dimension());
+    for (size_t j = 0; j < gathered.size(); j++)
+    {
+        gathered[j] = row.coeff(j);
+    }
+    write(ConstMatrixView(gathered.data(), 1, gathered.size(), gathered.size()));
+}
+
+size_t binary::Writer::rows_written() const noexcept
+{
+    return m_rows_written;
+}
+
+void binary::Writer::flush()
+{
+    m_out.write(reinterpret_cast<const char *>(m_staging.data()), m_staged * sizeof(double));
+    m_staged = 0;
+    if (!m_out)
+    {
+        fail(m_path, "write failed");
+    }
+}
+
+void binary::Writer::close()
+{
+    flush();
+    m_out.close();
+    if (!m_out)
+    {
+        fail(m_path, "write failed");
+    }
+    if (m_rows_written != m_header.rows)
+    {
+        fail(m_path, "closed before every row was written");
+    }
+}
+
+void binary::save(const std::string &path, ConstMatrixView A)
+{
+    Writer writer(path, A.getRowCount(), A.getColumnCount());
+    writer.write(A);
+    writer.close();
+}
+
+void binary::save(const std::string &path, ConstVectorView v)
+{
+    Writer writer(path, 1, v.dimension());
+    writer.write(v);
+    writer.close();
+}
@@ -0,0 +1,677 @@
+#include "../include/blas.h"
+#include "../include/aligned_buffer.h"
+#include "../include/arena.h"
+#include "../include/instrument.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <stdexcept>
+#if TSMATH_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Register tile of the portable micro-kernel: MR rows of C by NR columns of C. The vector
+    // micro-kernels below use their own tile, see gemm_kernels.
+    constexpr size_t MR = 4;
+    constexpr size_t NR = 8;
+
+    // Cache blocking: a KC x nr sliver of packed B stays in L1 (16 to 32 KiB),
+    // an MC x KC block of packed A stays in L2 (192 KiB, twice the rows for floats),
+    // and a KC x NC panel of packed B stays in L3 (8 MiB). MC and NC are multiples of every tile.
+    constexpr size_t KC = 256;
+    template <typename T>
+    constexpr size_t MC = 96 * sizeof(double) / sizeof(T);
+    constexpr size_t NC = 4096;
+
+    // Below this many multiply-adds packing costs more than it saves.
+    constexpr size_t SMALL_GEMM = 32 * 32 * 32;
+
+    // Below this many multiply-adds a product is not worth splitting over the pool.
+    constexpr size_t PARALLEL_GEMM = 64 * 64 * 64;
+
+    // Fewest rows of C handed to one chunk by parallel_gemm.
+    constexpr size_t PARALLEL_ROWS = 32;
+
+    // Per-thread packing workspace, grown on demand and reused across calls. It outlives any arena
+    // scope of the caller, so it always comes from the heap.
+    template <typename T>
+    T *workspace(BasicAlignedBuffer<T> &buffer, size_t count)
+    {
+        if (buffer.size() < count)
+        {
+            buffer = BasicAlignedBuffer<T>(count, memory::heap());
+        }
+        return buffer.data();
+    }
+
+    // Runs row(i) for every row of a rows x columns element-wise update, split across the pool once
+    // it is large enough.
+    template <typename Row>
+    void for_each_row(size_t rows, size_t columns, const Row &row)
+    {
+        const auto band = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                row(i);
+            }
+        };
+        if (parallel::worthwhile(rows * columns, expr::PARALLEL_ELEMENTS))
+        {
+            parallel::parallel_for(rows, expr::row_grain(columns), band);
+        }
+        else
+        {
+            band(0, rows);
+        }
+    }
+
+    void require_same_shape(ConstMatrixView X, ConstMatrixView Y)
+    {
+        if (X.getRowCount() != Y.getRowCount() || X.getColumnCount() != Y.getColumnCount())
+        {
+            throw std::invalid_argument("Matrix dimensions do not match");
+        }
+    }
+
+    void require_same_dimension(ConstVectorView x, ConstVectorView y)
+    {
+        if (x.dimension() != y.dimension())
+        {
+            throw std::invalid_argument("Vectors must have the same dimension");
+        }
+    }
+
+    template <typename T>
+    inline T element(blas::Op op, const T *X, size_t ldx, size_t row, size_t column)
+    {
+        return op == blas::Op::none ? X[row * ldx + column] : X[column * ldx + row];
+    }
+
+    // Packs an mc x kc block of op(A) into mr-row slivers stored k-major, zero padding the last sliver.
+    template <typename T>
+    void pack_a(blas::Op op, const T *A, size_t lda, size_t mc, size_t kc, size_t mr, T *packed)
+    {
+        for (size_t i = 0; i < mc; i += mr)
+        {
+            size_t rows = std::min(mr, mc - i);
+            for (size_t p = 0; p < kc; p++)
+            {
+                for (size_t r = 0; r < rows; r++)
+                {
+                    packed[r] = element(op, A, lda, i + r, p);
+                }
+                for (size_t r = rows; r < mr; r++)
+                {
+                    packed[r] = T(0);
+                }
+                packed += mr;
+            }
+        }
+    }
+
+    // Packs a kc x nc block of op(B) into nr-column slivers stored k-major, zero padding the last sliver.
+    template <typename T>
+    void pack_b(blas::Op op, const T *B, size_t ldb, size_t kc, size_t nc, size_t nr, T *packed)
+    {
+        for (size_t j = 0; j < nc; j += nr)
+        {
+            size_t columns = std::min(nr, nc - j);
+            for (size_t p = 0; p < kc; p++)
+            {
+                if (op == blas::Op::none && columns == nr)
+                {
+                    std::copy_n(B + p * ldb + j, nr, packed);
+                }
+                else
+                {
+                    for (size_t c = 0; c < columns; c++)
+                    {
+                        packed[c] = element(op, B, ldb, p, j + c);
+                    }
+                    for (size_t c = columns; c < nr; c++)
+                    {
+                        packed[c] = T(0);
+                    }
+                }
+                packed += nr;
+            }
+        }
+    }
+
+    // C[0:mr, 0:nr] += alpha * tile[0:mr, 0:nr] for a partial tile at the bottom or right edge of C.
+    template <typename T>
+    void add_tile(T alpha, const T *tile, size_t ld, T *C, size_t ldc, size_t mr, size_t nr)
+    {
+        for (size_t i = 0; i < mr; i++)
+        {
+            for (size_t j = 0; j < nr; j++)
+            {
+                C[i * ldc + j] += alpha * tile[i * ld + j];
+            }
+        }
+    }
+
+    // C[0:mr, 0:nr] += alpha * (packed A sliver) * (packed B sliver), accumulated in registers.
+    // Portable version on an MR x NR tile.
+    template <typename T>
+    void micro_kernel(size_t kc, T alpha, const T *a, const T *b, T *C, size_t ldc, size_t mr, size_t nr)
+    {
+        T acc[MR][NR] = {};
+        for (size_t p = 0; p < kc; p++)
+        {
+            for (size_t i = 0; i < MR; i++)
+            {
+                const T a_ip = a[i];
+                for (size_t j = 0; j < NR; j++)
+                {
+                    acc[i][j] += a_ip * b[j];
+                }
+            }
+            a += MR;
+            b += NR;
+        }
+
+        add_tile(alpha, &acc[0][0], NR, C, ldc, mr, nr);
+    }
+
+#if TSMATH_X86
+    // AVX2 + FMA: a 6 x 8 double tile in 12 of the 16 ymm registers, two loads of B and six
+    // broadcasts of A feeding twelve FMAs per step of k.
+    TSMATH_TARGET("avx2,fma")
+    void micro_kernel_avx2(size_t kc, double alpha, const double *a, const double *b, double *C, size_t ldc,
+                           size_t mr, size_t nr)
+    {
+        constexpr size_t rows = 6;
+        __m256d acc[rows][2];
+        for (size_t i = 0; i < rows; i++)
+        {
+            acc[i][0] = _mm256_setzero_pd();
+            acc[i][1] = _mm256_setzero_pd();
+        }
+        for (size_t p = 0; p < kc; p++)
+        {
+            const __m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4);
+            for (size_t i = 0; i < rows; i++)
+            {
+                const __m256d a_ip = _mm256_broadcast_sd(a + i);
+                acc[i][0] = _mm256_fmadd_pd(a_ip, b0, acc[i][0]);
+                acc[i][1] = _mm256_fmadd_pd(a_ip, b1, acc[i][1]);
+            }
+            a += rows;
+            b += 8;
+        }
+
+        const __m256d scale = _mm256_set1_pd(alpha);
+        if (mr == rows && nr == 8)
+        {
+            for (size_t i = 0; i < rows; i++)
+            {
+                double *c = C + i * ldc;
+                _mm256_storeu_pd(c, _mm256_fmadd_pd(scale, acc[i][0], _mm256_loadu_pd(c)));
+                _mm256_storeu_pd(c + 4, _mm256_fmadd_pd(scale, acc[i][1], _mm256_loadu_pd(c + 4)));
+            }
+            return;
+        }
+        alignas(64) double tile[rows * 8];
+        for (size_t i = 0; i < rows; i++)
+        {
+            _mm256_store_pd(tile + i * 8, acc[i][0]);
+            _mm256_store_pd(tile + i * 8 + 4, acc[i][1]);
+        }
+        add_tile(alpha, tile, 8, C, ldc, mr, nr);
+    }
+
+    // AVX-512: an 8 x 16 double tile in 16 of the 32 zmm registers.
+    TSMATH_TARGET("avx512f")
+    void micro_kernel_avx512(size_t kc, double alpha, const double *a, const double *b, double *C, size_t ldc,
+                             size_t mr, size_t nr)
+    {
+        constexpr size_t rows = 8;
+        __m512d acc[rows][2];
+        for (size_t i = 0; i < rows; i++)
+        {
+            acc[i][0] = _mm512_setzero_pd();
+            acc[i][1] = _mm512_setzero_pd();
+        }
+        for (size_t p = 0; p < kc; p++)
+        {
+            const __m512d b0 = _mm512_loadu_pd(b), b1 = _mm512_loadu_pd(b + 8);
+            for (size_t i = 0; i < rows; i++)
+            {
+                const __m512d a_ip = _mm512_set1_pd(a[i]);
+                acc[i][0] = _mm512_fmadd_pd(a_ip, b0, acc[i][0]);
+                acc[i][1] = _mm512_fmadd_pd(a_ip, b1, acc[i][1]);
+            }
+            a += rows;
+            b += 16;
+        }
+
+        const __m512d scale = _mm512_set1_pd(alpha);
+        if (mr == rows && nr == 16)
+        {
+            for (size_t i = 0; i < rows; i++)
+            {
+                double *c = C + i * ldc;
+                _mm512_storeu_pd(c, _mm512_fmadd_pd(scale, acc[i][0], _mm512_loadu_pd(c)));
+                _mm512_storeu_pd(c + 8, _mm512_fmadd_pd(scale, acc[i][1], _mm512_loadu_pd(c + 8)));
+            }
+            return;
+        }
+        alignas(64) double tile[rows * 16];
+        for (size_t i = 0; i < rows; i++)
+        {
+            _mm512_store_pd(tile + i * 16, acc[i][0]);
+            _mm512_store_pd(tile + i * 16 + 8, acc[i][1]);
+        }
+        add_tile(alpha, tile, 16, C, ldc, mr, nr);
+    }
+
+    // float versions of the two above: the same register counts with twice the columns, 6 x 16 on
+    // AVX2 and 8 x 32 on AVX-512.
+    TSMATH_TARGET("avx2,fma")
+    void micro_kernel_avx2(size_t kc, float alpha, const float *a, const float *b, float *C, size_t ldc,
+                           size_t mr, size_t nr)
+    {
+        constexpr size_t rows = 6;
+        __m256 acc[rows][2];
+        for (size_t i = 0; i < rows; i++)
+        {
+            acc[i][0] = _mm256_setzero_ps();
+            acc[i][1] = _mm256_setzero_ps();
+        }
+        for (size_t p = 0; p < kc; p++)
+        {
+            const __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+            for (size_t i = 0; i < rows; i++)
+            {
+                const __m256 a_ip = _mm256_broadcast_ss(a + i);
+                acc[i][0] = _mm256_fmadd_ps(a_ip, b0, acc[i][0]);
+                acc[i][1] = _mm256_fmadd_ps(a_ip, b1, acc[i][1]);
+            }
+            a += rows;
+            b += 16;
+        }
+
+        const __m256 scale = _mm256_set1_ps(alpha);
+        if (mr == rows && nr == 16)
+        {
+            for (size_t i = 0; i < rows; i++)
+            {
+                float *c = C + i * ldc;
+                _mm256_storeu_ps(c, _mm256_fmadd_ps(scale, acc[i][0], _mm256_loadu_ps(c)));
+                _mm256_storeu_ps(c + 8, _mm256_fmadd_ps(scale, acc[i][1], _mm256_loadu_ps(c + 8)));
+            }
+            return;
+        }
+        alignas(64) float tile[rows * 16];
+        for (size_t i = 0; i < rows; i++)
+        {
+            _mm256_store_ps(tile + i * 16, acc[i][0]);
+            _mm256_store_ps(tile + i * 16 + 8, acc[i][1]);
+        }
+        add_tile(alpha, tile, 16, C, ldc, mr, nr);
+    }
+
+    TSMATH_TARGET("avx512f")
+    void micro_kernel_avx512(size_t kc, float alpha, const float *a, const float *b, float *C, size_t ldc,
+                             size_t mr, size_t nr)
+    {
+        constexpr size_t rows = 8;
+        __m512 acc[rows][2];
+        for (size_t i = 0; i < rows; i++)
+        {
+            acc[i][0] = _mm512_setzero_ps();
+            acc[i][1] = _mm512_setzero_ps();
+        }
+        for (size_t p = 0; p < kc; p++)
+        {
+            const __m512 b0 = _mm512_loadu_ps(b), b1 = _mm512_loadu_ps(b + 16);
+            for (size_t i = 0; i < rows; i++)
+            {
+                const __m512 a_ip = _mm512_set1_ps(a[i]);
+                acc[i][0] = _mm512_fmadd_ps(a_ip, b0, acc[i][0]);
+                acc[i][1] = _mm512_fmadd_ps(a_ip, b1, acc[i][1]);
+            }
+            a += rows;
+            b += 32;
+        }
+
+        const __m512 scale = _mm512_set1_ps(alpha);
+        if (mr == rows && nr == 32)
+        {
+            for (size_t i = 0; i < rows; i++)
+            {
+                float *c = C + i * ldc;
+                _mm512_storeu_ps(c, _mm512_fmadd_ps(scale, acc[i][0], _mm512_loadu_ps(c)));
+                _mm512_storeu_ps(c + 16, _mm512_fmadd_ps(scale, acc[i][1], _mm512_loadu_ps(c + 16)));
+            }
+            return;
+        }
+        alignas(64) float tile[rows * 32];
+        for (size_t i = 0; i < rows; i++)
+        {
+            _mm512_store_ps(tile + i * 32, acc[i][0]);
+            _mm512_store_ps(tile + i * 32 + 16, acc[i][1]);
+        }
+        add_tile(alpha, tile, 32, C, ldc, mr, nr);
+    }
+#endif
+
+    // Register tile and micro-kernel of one instruction set, chosen per call from simd::active_isa().
+    template <typename T>
+    struct gemm_kernels
+    {
+        size_t mr, nr;
+        void (*micro)(size_t kc, T alpha, const T *a, const T *b, T *C, size_t ldc, size_t mr, size_t nr);
+    };
+
+    template <typename T>
+    const gemm_kernels<T> &gemm_kernels_for(simd::isa target) noexcept;
+
+    template <>
+    const gemm_kernels<double> &gemm_kernels_for(simd::isa target) noexcept
+    {
+        static const gemm_kernels<double> scalar_kernels = {MR, NR, micro_kernel<double>};
+#if TSMATH_X86
+        static const gemm_kernels<double> avx2_kernels = {6, 8, micro_kernel_avx2};
+        static const gemm_kernels<double> avx512_kernels = {8, 16, micro_kernel_avx512};
+        switch (target)
+        {
+        case simd::isa::avx512:
+            return avx512_kernels;
+        case simd::isa::avx2:
+            return avx2_kernels;
+        default:
+            break;
+        }
+#endif
+        return scalar_kernels;
+    }
+
+    template <>
+    const gemm_kernels<float> &gemm_kernels_for(simd::isa target) noexcept
+    {
+        static const gemm_kernels<float> scalar_kernels = {MR, NR, micro_kernel<float>};
+#if TSMATH_X86
+        static const gemm_kernels<float> avx2_kernels = {6, 16, micro_kernel_avx2};
+        static const gemm_kernels<float> avx512_kernels = {8, 32, micro_kernel_avx512};
+        switch (target)
+        {
+        case simd::isa::avx512:
+            return avx512_kernels;
+        case simd::isa::avx2:
+            return avx2_kernels;
+        default:
+            break;
+        }
+#endif
+        return scalar_kernels;
+    }
+
+    // C = beta * C, treating beta == 0 as an overwrite so NaNs in C do not leak through.
+    template <typename T>
+    void scale(size_t m, size_t n, T beta, T *C, size_t ldc)
+    {
+        if (beta == 1.0)
+        {
+            return;
+        }
+        for (size_t i = 0; i < m; i++)
+        {
+            T *c = C + i * ldc;
+            if (beta == 0.0)
+            {
+                std::fill_n(c, n, T(0));
+            }
+            else
+            {
+                for (size_t j = 0; j < n; j++)
+                {
+                    c[j] *= beta;
+                }
+            }
+        }
+    }
+
+    // Unpacked i-p-j loop for problems too small to amortise packing.
+    template <typename T>
+    void small_gemm(blas::Op op_a, blas::Op op_b, size_t m, size_t n, size_t k, T alpha,
+                    const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc)
+    {
+        for (size_t i = 0; i < m; i++)
+        {
+            T *c = C + i * ldc;
+            for (size_t p = 0; p < k; p++)
+            {
+                const T a_ip = alpha * element(op_a, A, lda, i, p);
+                if (op_b == blas::Op::none)
+                {
+                    const T *b = B + p * ldb;
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        c[j] += a_ip * b[j];
+                    }
+                }
+                else
+                {
+                    for (size_t j = 0; j < n; j++)
+                    {
+                        c[j] += a_ip * B[j * ldb + p];
+                    }
+                }
+            }
+        }
+    }
+
+    // Packed GEMM on row-major storage of T, see blas::gemm. With 'split' the rows of C are spread over
+    // the pool the way BLIS parallelises its ic loop: each KC x NC panel of B is packed once, on the
+    // calling thread, and every thread packs its own blocks of A against that shared panel.
+    template <typename T>
+    void gemm_kernel(blas::Op op_a, blas::Op op_b, size_t m, size_t n, size_t k, T alpha, const T *A, size_t lda,
+                     const T *B, size_t ldb, T beta, T *C, size_t ldc, bool split)
+    {
+        if (m == 0 || n == 0)
+        {
+            return;
+        }
+
+        TSMATH_INSTRUMENT(gemm, 2 * m * n * k, (m * k + k * n + 2 * m * n) * sizeof(T));
+        if (split)
+        {
+            for_each_row(m, n, [=](size_t i) { scale(1, n, beta, C + i * ldc, ldc); });
+        }
+        else
+        {
+            scale(m, n, beta, C, ldc);
+        }
+        if (k == 0 || alpha == T(0))
+        {
+            return;
+        }
+
+        if (m * n * k <= SMALL_GEMM)
+        {
+            small_gemm(op_a, op_b, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+            return;
+        }
+
+        const gemm_kernels<T> &kernels = gemm_kernels_for<T>(simd::active_isa());
+        const size_t mr_tile = kernels.mr, nr_tile = kernels.nr;
+        thread_local BasicAlignedBuffer<T> packed_b_buffer;
+        T *packed_b = workspace(packed_b_buffer, KC * ((std::min(n, NC) + nr_tile - 1) / nr_tile * nr_tile));
+
+        for (size_t jc = 0; jc < n; jc += NC)
+        {
+            size_t nc = std::min(NC, n - jc);
+            for (size_t pc = 0; pc < k; pc += KC)
+            {
+                size_t kc = std::min(KC, k - pc);
+                const T *b_block = op_b == blas::Op::none ? B + pc * ldb + jc : B + jc * ldb + pc;
+                pack_b(op_b, b_block, ldb, kc, nc, nr_tile, packed_b);
+
+                // Rows [first * mr, last * mr) of C, in MC-row blocks of A
+                const auto row_slivers = [&](size_t first, size_t last) {
+                    thread_local BasicAlignedBuffer<T> packed_a_buffer;
+                    T *packed_a = workspace(packed_a_buffer, MC<T> * KC);
+                    const size_t end = std::min(m, last * mr_tile);
+                    for (size_t ic = first * mr_tile; ic < end; ic += MC<T>)
+                    {
+                        size_t mc = std::min(MC<T>, end - ic);
+                        const T *a_block = op_a == blas::Op::none ? A + ic * lda + pc : A + pc * lda + ic;
+                        pack_a(op_a, a_block, lda, mc, kc, mr_tile, packed_a);
+
+                        for (size_t jr = 0; jr < nc; jr += nr_tile)
+                        {
+                            size_t nr = std::min(nr_tile, nc - jr);
+                            for (size_t ir = 0; ir < mc; ir += mr_tile)
+                            {
+                                size_t mr = std::min(mr_tile, mc - ir);
+                                kernels.micro(kc, alpha, packed_a + ir * kc, packed_b + jr * kc,
+                                              C + (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+                            }
+                        }
+                    }
+                };
+                const size_t slivers = (m + mr_tile - 1) / mr_tile;
+                if (split)
+                {
+                    parallel::parallel_for(slivers, std::max<size_t>(1, PARALLEL_ROWS / mr_tile), row_slivers);
+                }
+                else
+                {
+                    row_slivers(0, slivers);
+                }
+            }
+        }
+    }
+}
+
+void blas::gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, double alpha,
+                const double *A, size_t lda, const double *B, size_t ldb,
+                double beta, double *C, size_t ldc)
+{
+    gemm_kernel(op_a, op_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, false);
+}
+
+void blas::gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, float alpha,
+                const float *A, size_t lda, const float *B, size_t ldb,
+                float beta, float *C, size_t ldc)
+{
+    gemm_kernel(op_a, op_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, false);
+}
+
+void blas::parallel_gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, double alpha,
+                         const double *A, size_t lda, const double *B, size_t ldb,
+                         double beta, double *C, size_t ldc)
+{
+    gemm_kernel(op_a, op_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc,
+                parallel::worthwhile(m * n * k, PARALLEL_GEMM));
+}
+
+void blas::parallel_gemm(Op op_a, Op op_b, size_t m, size_t n, size_t k, float alpha,
+                         const float *A, size_t lda, const float *B, size_t ldb,
+                         float beta, float *C, size_t ldc)
+{
+    gemm_kernel(op_a, op_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc,
+                parallel::worthwhile(m * n * k, PARALLEL_GEMM));
+}
+
+void blas::gemm(double alpha, ConstMatrixView A, ConstMatrixView B, double beta, MatrixView C)
+{
+    gemm(Op::none, Op::none, alpha, A, B, beta, C);
+}
+
+void blas::gemm(Op op_a, Op op_b, double alpha, ConstMatrixView A, ConstMatrixView B, double beta, MatrixView C)
+{
+    size_t m = op_a == Op::none ? A.getRowCount() : A.getColumnCount();
+    size_t k = op_a == Op::none ? A.getColumnCount() : A.getRowCount();
+    size_t k_b = op_b == Op::none ? B.getRowCount() : B.getColumnCount();
+    size_t n = op_b == Op::none ? B.getColumnCount() : B.getRowCount();
+
+    if (k != k_b || C.getRowCount() != m || C.getColumnCount() != n)
+    {
+        throw std::invalid_argument("Matrix dimensions do not match for gemm");
+    }
+
+    gemm(op_a, op_b, m, n, k, alpha, A.data(), A.stride(), B.data(), B.stride(), beta, C.data(), C.stride());
+}
+
+void blas::axpy(double alpha, ConstVectorView x, VectorView y)
+{
+    require_same_dimension(x, y);
+    const size_t n = x.dimension();
+    TSMATH_INSTRUMENT(axpy, 2 * n, 3 * n * sizeof(double));
+    if (x.stride() == 1 && y.stride() == 1)
+    {
+        simd::axpy(alpha, x.data(), y.data(), n);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        y.data()[i * y.stride()] += alpha * x.data()[i * x.stride()];
+    }
+}
+
+void blas::axpy(double alpha, ConstMatrixView X, MatrixView Y)
+{
+    require_same_shape(X, Y);
+    const size_t n = X.getColumnCount();
+    TSMATH_INSTRUMENT(axpy, 2 * X.getRowCount() * n, 3 * X.getRowCount() * n * sizeof(double));
+    for_each_row(X.getRowCount(), n, [&](size_t i) {
+        simd::axpy(alpha, X.data() + i * X.stride(), Y.data() + i * Y.stride(), n);
+    });
+}
+
+void blas::scal(double alpha, VectorView x)
+{
+    const size_t n = x.dimension();
+    TSMATH_INSTRUMENT(scal, n, 2 * n * sizeof(double));
+    if (x.stride() == 1)
+    {
+        simd::scale(x.data(), alpha, x.data(), n);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        x.data()[i * x.stride()] *= alpha;
+    }
+}
+
+void blas::scal(double alpha, MatrixView X)
+{
+    const size_t n = X.getColumnCount();
+    TSMATH_INSTRUMENT(scal, X.getRowCount() * n, 2 * X.getRowCount() * n * sizeof(double));
+    for_each_row(X.getRowCount(), n, [&](size_t i) {
+        double *row = X.data() + i * X.stride();
+        simd::scale(row, alpha, row, n);
+    });
+}
+
+void blas::axpby(double alpha, ConstVectorView x, double beta, VectorView y)
+{
+    require_same_dimension(x, y);
+    const size_t n = x.dimension();
+    TSMATH_INSTRUMENT(axpby, 3 * n, 3 * n * sizeof(double));
+    if (x.stride() == 1 && y.stride() == 1)
+    {
+        simd::axpby(alpha, x.data(), beta, y.data(), n);
+        return;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        double &yi = y.data()[i * y.stride()];
+        yi = alpha * x.data()[i * x.stride()] + beta * yi;
+    }
+}
+
+void blas::axpby(double alpha, ConstMatrixView X, double beta, MatrixView Y)
+{
+    require_same_shape(X, Y);
+    const size_t n = X.getColumnCount();
+    TSMATH_INSTRUMENT(axpby, 3 * X.getRowCount() * n, 3 * X.getRowCount() * n * sizeof(double));
+    for_each_row(X.getRowCount(), n, [&](size_t i) {
+        simd::axpby(alpha, X.data() + i * X.stride(), beta, Y.data() + i * Y.stride(), n);
+    });
+}
@@ -0,0 +1,1252 @@
+#include "../include/lin_alg.h"
+#include "../include/blas.h"
+#include "../include/householder.h"
+#include "../include/instrument.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace
+{
+    // Panel width of the blocked tridiagonal and Hessenberg reductions.
+    constexpr size_t NB = 32;
+
+    // Divide and conquer hands subproblems up to this size to implicit QL.
+    constexpr size_t LEAF = 32;
+
+    // Rows handed to one thread in the matrix-vector products of the reductions.
+    constexpr size_t ROW_GRAIN = 128;
+
+    // Shifted QR sweeps allowed per eigenvalue before giving up.
+    constexpr size_t MAX_SWEEPS = 30;
+
+    const double EPS = std::numeric_limits<double>::epsilon();
+
+    void require_square(ConstMatrixView A)
+    {
+        if (A.getRowCount() != A.getColumnCount())
+        {
+            throw std::invalid_argument("Eigen-decomposition needs a square matrix");
+        }
+    }
+
+    // Symmetric up to rounding in the last few bits of each pair.
+    bool is_symmetric(ConstMatrixView A)
+    {
+        const size_t n = A.getRowCount();
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < i; j++)
+            {
+                const double a = A(i, j), b = A(j, i);
+                if (std::abs(a - b) > 64.0 * EPS * std::max(std::abs(a), std::abs(b)))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // y = A(first:, first:) x for a symmetric A reading only the lower triangle, so the reduction's
+    // memory-bound matrix-vector products stream half the matrix. Threads take row bands holding
+    // equal shares of the triangle and accumulate into private copies of y.
+    void symmetric_matvec(const MATRIX &A, size_t first, const double *x, double *y)
+    {
+        const size_t lda = A.stride(), count = A.getColumnCount() - first;
+        const double *a = A.data() + first * lda + first;
+        const size_t bands = std::max<size_t>(1, std::min(parallel::thread_count(), count / ROW_GRAIN));
+        std::vector<double> partial(bands * count, 0.0);
+        parallel::parallel_for(bands, 1, [&](size_t begin, size_t end) {
+            for (size_t band = begin; band < end; band++)
+            {
+                const size_t lo = size_t(double(count) * std::sqrt(double(band) / double(bands)));
+                const size_t hi = band + 1 == bands ? count : size_t(double(count) * std::sqrt(double(band + 1) / double(bands)));
+                double *acc = partial.data() + band * count;
+                for (size_t r = lo; r < hi; r++)
+                {
+                    const double *row = a + r * lda;
+                    const double xr = x[r];
+                    double sum = 0.0;
+                    for (size_t j = 0; j < r; j++)
+                    {
+                        sum += row[j] * x[j];
+                        acc[j] += row[j] * xr;
+                    }
+                    acc[r] += sum + row[r] * xr;
+                }
+            }
+        });
+        std::copy_n(partial.data(), count, y);
+        for (size_t band = 1; band < bands; band++)
+        {
+            const double *acc = partial.data() + band * count;
+            for (size_t j = 0; j < count; j++)
+            {
+                y[j] += acc[j];
+            }
+        }
+    }
+
+    // Householder reduction of a symmetric matrix to tridiagonal form, Q^T A Q = T.
+    struct Tridiagonal
+    {
+        // Reflector c is stored below the subdiagonal of column c, its scalar in tau[c].
+        MATRIX reflectors;
+        std::vector<double> d, e, tau;
+    };
+
+    // Blocked lower tridiagonalization on full storage. Within a panel every column is brought up to
+    // date with the panel's earlier reflectors through V and W, where W collects the
+    // tau * (A v - corrections) vectors, and the trailing matrix then takes one rank-2jb update
+    // A -= V W^T + W V^T as two products.
+    Tridiagonal tridiagonalize(ConstMatrixView A)
+    {
+        const size_t n = A.getRowCount();
+        Tridiagonal t{MATRIX(A), std::vector<double>(n), std::vector<double>(n), std::vector<double>(n)};
+        MATRIX &R = t.reflectors;
+        double *a = R.data();
+        const size_t lda = R.stride();
+        const size_t count = n > 1 ? n - 1 : 0;
+
+        MATRIX V(n, NB), W(n, NB), left(n, 2 * NB), right(n, 2 * NB);
+        std::vector<double> v(n), y(n), p1(NB), p2(NB);
+        for (size_t k = 0; k < count; k += NB)
+        {
+            const size_t jb = std::min(NB, count - k);
+            for (size_t i = 0; i < jb; i++)
+            {
+                const size_t c = k + i, rows = n - c - 1;
+
+                // Column c with the panel's earlier reflectors applied
+                for (size_t r = c; r < n && i > 0; r++)
+                {
+                    double sum = 0.0;
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        sum += V(r, p) * W(c, p) + W(r, p) * V(c, p);
+                    }
+                    a[r * lda + c] -= sum;
+                }
+                t.d[c] = a[c * lda + c];
+
+                const double tau = householder::generate(a + (c + 1) * lda + c, rows, lda);
+                t.tau[c] = tau;
+                t.e[c] = a[(c + 1) * lda + c];
+
+                for (size_t r = 0; r < n; r++)
+                {
+                    V(r, i) = r <= c ? 0.0 : r == c + 1 ? 1.0 : a[r * lda + c];
+                    W(r, i) = 0.0;
+                }
+                if (tau == 0.0)
+                {
+                    continue;
+                }
+
+                // w = tau (A22 v - V (W^T v) - W (V^T v)) on rows c+1..n
+                for (size_t r = 0; r < rows; r++)
+                {
+                    v[r] = V(c + 1 + r, i);
+                }
+                symmetric_matvec(R, c + 1, v.data(), y.data());
+                for (size_t p = 0; p < i; p++)
+                {
+                    double s1 = 0.0, s2 = 0.0;
+                    for (size_t r = 0; r < rows; r++)
+                    {
+                        s1 += W(c + 1 + r, p) * v[r];
+                        s2 += V(c + 1 + r, p) * v[r];
+                    }
+                    p1[p] = s1;
+                    p2[p] = s2;
+                }
+                for (size_t r = 0; r < rows; r++)
+                {
+                    double sum = y[r];
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        sum -= V(c + 1 + r, p) * p1[p] + W(c + 1 + r, p) * p2[p];
+                    }
+                    y[r] = tau * sum;
+                }
+
+                // w -= (tau / 2) (w^T v) v keeps the update symmetric
+                const double alpha = -0.5 * tau * simd::dot(y.data(), v.data(), rows);
+                for (size_t r = 0; r < rows; r++)
+                {
+                    W(c + 1 + r, i) = y[r] + alpha * v[r];
+                }
+            }
+
+            // A22 -= V W^T + W V^T on both triangles, as one product [V W] [W V]^T of depth 2jb
+            const size_t s = k + jb;
+            if (s < n)
+            {
+                const size_t m = n - s;
+                for (size_t r = 0; r < m; r++)
+                {
+                    for (size_t p = 0; p < jb; p++)
+                    {
+                        left(r, p) = right(r, jb + p) = V(s + r, p);
+                        left(r, jb + p) = right(r, p) = W(s + r, p);
+                    }
+                }
+                blas::parallel_gemm(blas::Op::none, blas::Op::transpose, m, m, 2 * jb, -1.0, left.data(), left.stride(),
+                                    right.data(), right.stride(), 1.0, a + s * lda + s, lda);
+            }
+        }
+        if (n > 0)
+        {
+            t.d[n - 1] = a[(n - 1) * lda + n - 1];
+            t.e[n - 1] = 0.0;
+        }
+        return t;
+    }
+
+    // Z = Q Z with Q = H_0 H_1 ... H_(count-1), reflector c acting on rows c + 1.. and stored
+    // below the subdiagonal of column c of 'reflectors'. Panels are applied last to first.
+    void apply_reflectors(const MATRIX &reflectors, const std::vector<double> &tau, size_t count, MatrixView Z)
+    {
+        const size_t n = reflectors.getRowCount();
+        if (count == 0)
+        {
+            return;
+        }
+        MATRIX V(n, NB), G(NB, NB), T(NB, NB), W(NB, Z.getColumnCount());
+        for (size_t panels = (count + NB - 1) / NB; panels-- > 0;)
+        {
+            const size_t k = panels * NB, jb = std::min(NB, count - k), rows = n - k - 1;
+            householder::unpack(reflectors.block(k + 1, k, rows, jb), jb, V);
+            householder::form_t(V, rows, jb, tau.data() + k, G, T.data(), T.stride());
+            householder::apply_block(V, rows, jb, T.data(), T.stride(), Z.block(k + 1, 0, rows, Z.getColumnCount()), W,
+                                     false);
+        }
+    }
+
+    // Sorts d ascending and permutes the columns of Z (when given) alike.
+    void sort_eigenpairs(double *d, size_t n, MatrixView *Z)
+    {
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) { return d[x] < d[y]; });
+
+        std::vector<double> sorted(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            sorted[i] = d[order[i]];
+        }
+        std::copy(sorted.begin(), sorted.end(), d);
+        if (Z)
+        {
+            const size_t rows = Z->getRowCount();
+            std::vector<double> row(n);
+            for (size_t r = 0; r < rows; r++)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    row[i] = (*Z)(r, order[i]);
+                }
+                for (size_t i = 0; i < n; i++)
+                {
+                    (*Z)(r, i) = row[i];
+                }
+            }
+        }
+    }
+
+    // Implicit QL with Wilkinson shifts on the tridiagonal (d, e), e[i] coupling i and i + 1 and
+    // e[n - 1] ignored. Rotations are accumulated into the columns of Z when given. O(n^2) without Z.
+    void tridiagonal_ql(double *d, double *e, size_t n, MatrixView *Z)
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        e[n - 1] = 0.0;
+        const size_t rows = Z ? Z->getRowCount() : 0;
+        for (size_t l = 0; l < n; l++)
+        {
+            size_t sweeps = 0;
+            for (;;)
+            {
+                size_t m = l;
+                for (; m + 1 < n; m++)
+                {
+                    const double dd = std::abs(d[m]) + std::abs(d[m + 1]);
+                    if (std::abs(e[m]) <= EPS * dd)
+                    {
+                        break;
+                    }
+                }
+                if (m == l)
+                {
+                    break;
+                }
+                if (sweeps++ == MAX_SWEEPS)
+                {
+                    throw std::runtime_error("Tridiagonal QL iteration did not converge");
+                }
+
+                double g = (d[l + 1] - d[l]) / (2.0 * e[l]);
+                double r = std::hypot(g, 1.0);
+                g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+                double s = 1.0, c = 1.0, p = 0.0;
+                bool underflow = false;
+                for (size_t i = m; i-- > l;)
+                {
+                    const double f = s * e[i], b = c * e[i];
+                    r = std::hypot(f, g);
+                    e[i + 1] = r;
+                    if (r == 0.0)
+                    {
+                        // Recover from underflow: the rotation split the matrix
+                        d[i + 1] -= p;
+                        e[m] = 0.0;
+                        underflow = true;
+                        break;
+                    }
+                    s = f / r;
+                    c = g / r;
+                    g = d[i + 1] - p;
+                    r = (d[i] - g) * s + 2.0 * c * b;
+                    p = s * r;
+                    d[i + 1] = g + p;
+                    g = c * r - b;
+                    for (size_t k = 0; k < rows; k++)
+                    {
+                        const double zi = (*Z)(k, i), zi1 = (*Z)(k, i + 1);
+                        (*Z)(k, i + 1) = s * zi + c * zi1;
+                        (*Z)(k, i) = c * zi - s * zi1;
+                    }
+                }
+                if (underflow)
+                {
+                    continue;
+                }
+                d[l] -= p;
+                e[l] = g;
+                e[m] = 0.0;
+            }
+        }
+        sort_eigenpairs(d, n, Z);
+    }
+
+    // Root i of the secular equation 1 + rho sum_j z_j^2 / (d_j - lambda) = 0 over the sorted poles d,
+    // returned as lambda = d[origin] + tau with the origin at the nearer pole so that the differences
+    // d_j - lambda = (d_j - d[origin]) - tau are exact. Safeguarded iteration on a two-pole rational
+    // model of the function (one pole for the last root), falling back to bisection.
+    void secular_root(const double *d, const double *z, size_t k, double rho, size_t i, size_t &origin, double &tau)
+    {
+        const bool last = i + 1 == k;
+        double lo, hi;
+        if (!last)
+        {
+            const double mid = 0.5 * (d[i + 1] - d[i]);
+            double f = 1.0;
+            for (size_t j = 0; j < k; j++)
+            {
+                f += rho * z[j] * z[j] / ((d[j] - d[i]) - mid);
+            }
+            if (f >= 0.0)
+            {
+                origin = i;
+                lo = 0.0;
+                hi = mid;
+            }
+            else
+            {
+                origin = i + 1;
+                lo = -mid;
+                hi = 0.0;
+            }
+        }
+        else
+        {
+            double norm = 0.0;
+            for (size_t j = 0; j < k; j++)
+            {
+                norm += z[j] * z[j];
+            }
+            origin = i;
+            lo = 0.0;
+            hi = rho * norm * (1.0 + 8.0 * EPS);
+        }
+
+        const double base = d[origin];
+        tau = 0.5 * (lo + hi);
+        for (size_t iteration = 0; iteration < 100; iteration++)
+        {
+            double psi = 0.0, dpsi = 0.0, phi = 0.0, dphi = 0.0;
+            for (size_t j = 0; j < k; j++)
+            {
+                const double delta = (d[j] - base) - tau;
+                const double term = rho * z[j] * z[j] / delta;
+                if (j <= i)
+                {
+                    psi += term;
+                    dpsi += term / delta;
+                }
+                else
+                {
+                    phi += term;
+                    dphi += term / delta;
+                }
+            }
+            const double f = 1.0 + psi + phi;
+            if (f < 0.0)
+            {
+                lo = tau;
+            }
+            else
+            {
+                hi = tau;
+            }
+            if (std::abs(f) <= 8.0 * EPS * (1.0 + std::abs(psi) + std::abs(phi)) ||
+                hi - lo <= 2.0 * EPS * std::max(std::abs(lo), std::abs(hi)))
+            {
+                return;
+            }
+
+            // psi(tau + h) ~ a + b / (di - h), phi(tau + h) ~ a1 + b1 / (di1 - h), matching values and slopes
+            const double di = (d[i] - base) - tau;
+            const double b = dpsi * di * di, a = psi - dpsi * di;
+            double h;
+            if (last)
+            {
+                const double C = 1.0 + a;
+                h = C > 0.0 ? di + b / C : std::numeric_limits<double>::quiet_NaN();
+            }
+            else
+            {
+                const double di1 = (d[i + 1] - base) - tau;
+                const double b1 = dphi * di1 * di1, a1 = phi - dphi * di1;
+                const double C = 1.0 + a + a1;
+                const double qb = -(C * (di + di1) + b + b1), qc = C * di * di1 + b * di1 + b1 * di;
+                if (C == 0.0)
+                {
+                    h = -qc / qb;
+                }
+                else
+                {
+                    const double disc = std::sqrt(std::max(0.0, qb * qb - 4.0 * C * qc));
+                    const double q = -0.5 * (qb + std::copysign(disc, qb));
+                    const double r1 = q / C, r2 = q != 0.0 ? qc / q : r1;
+                    h = r1 > di && r1 < di1 ? r1 : r2;
+                }
+            }
+            const double next = tau + h;
+            tau = next > lo && next < hi ? next : 0.5 * (lo + hi);
+        }
+    }
+
+    // Eigenvalues d (ascending) and eigenvectors Q of diag(d) + rho z z^T merged into the n x n
+    // eigenvector matrix Q = diag(Q1, Q2) of the two halves split at m. Follows Cuppen with the
+    // deflation of dlaed2 and the Gu-Eisenstat recomputed z for orthogonal vectors.
+    void merge(double *d, MatrixView Q, size_t m, double beta)
+    {
+        const size_t n = Q.getRowCount();
+        const double rho = 2.0 * std::abs(beta);
+
+        // z = [last row of Q1, sign(beta) first row of Q2] / sqrt(2)
+        std::vector<double> z(n);
+        const double scale = 1.0 / std::sqrt(2.0);
+        for (size_t j = 0; j < n; j++)
+        {
+            z[j] = j < m ? Q(m - 1, j) * scale : std::copysign(scale, beta) * Q(m, j);
+        }
+
+        std::vector<size_t> column(n);
+        std::iota(column.begin(), column.end(), size_t(0));
+        std::stable_sort(column.begin(), column.end(), [&](size_t x, size_t y) { return d[x] < d[y]; });
+        std::vector<double> ds(n), zs(n);
+        std::vector<unsigned char> type(n);
+        double dmax = 0.0, zmax = 0.0;
+        for (size_t j = 0; j < n; j++)
+        {
+            ds[j] = d[column[j]];
+            zs[j] = z[column[j]];
+            type[j] = column[j] < m ? 1 : 2;
+            dmax = std::max(dmax, std::abs(ds[j]));
+            zmax = std::max(zmax, std::abs(zs[j]));
+        }
+        const double tol = 8.0 * EPS * std::max(dmax, zmax);
+
+        // Deflation: negligible z components, and pairs of nearly equal poles rotated so that one
+        // of their z components vanishes
+        std::vector<size_t> kept, deflated;
+        size_t previous = n;
+        for (size_t j = 0; j < n; j++)
+        {
+            if (rho * std::abs(zs[j]) <= tol)
+            {
+                deflated.push_back(j);
+                continue;
+            }
+            if (previous == n)
+            {
+                previous = j;
+                continue;
+            }
+            const double tau = std::hypot(zs[j], zs[previous]);
+            const double c = zs[j] / tau, s = -zs[previous] / tau;
+            if (std::abs((ds[j] - ds[previous]) * c * s) <= tol)
+            {
+                zs[j] = tau;
+                zs[previous] = 0.0;
+                const size_t x = column[previous], y = column[j];
+                for (size_t r = 0; r < n; r++)
+                {
+                    const double qx = Q(r, x), qy = Q(r, y);
+                    Q(r, x) = c * qx + s * qy;
+                    Q(r, y) = c * qy - s * qx;
+                }
+                const double t = ds[previous] * c * c + ds[j] * s * s;
+                ds[j] = ds[previous] * s * s + ds[j] * c * c;
+                ds[previous] = t;
+                type[j] = type[previous] = type[j] | type[previous];
+                deflated.push_back(previous);
+            }
+            else
+            {
+                kept.push_back(previous);
+            }
+            previous = j;
+        }
+        if (previous != n)
+        {
+            kept.push_back(previous);
+        }
+
+        // Secular equation on the k kept poles; delta(i, j) = dk[j] - lambda_i
+        const size_t k = kept.size();
+        std::vector<double> dk(k), zk(k), lambda(k);
+        for (size_t j = 0; j < k; j++)
+        {
+            dk[j] = ds[kept[j]];
+            zk[j] = zs[kept[j]];
+        }
+        MATRIX delta(k, k), U(k, k);
+        parallel::parallel_for(k, 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                size_t origin;
+                double tau;
+                secular_root(dk.data(), zk.data(), k, rho, i, origin, tau);
+                lambda[i] = dk[origin] + tau;
+                for (size_t j = 0; j < k; j++)
+                {
+                    delta(i, j) = (dk[j] - dk[origin]) - tau;
+                }
+            }
+        });
+
+        // z_j^2 = prod_i (lambda_i - d_j) / (rho prod_(i != j) (d_i - d_j)), so that the computed
+        // lambdas are the exact eigenvalues of a nearby problem and the vectors come out orthogonal
+        std::vector<double> zhat(k);
+        for (size_t j = 0; j < k; j++)
+        {
+            double w = -delta(j, j) / rho;
+            for (size_t i = 0; i < k; i++)
+            {
+                if (i != j)
+                {
+                    w *= -delta(i, j) / (dk[i] - dk[j]);
+                }
+            }
+            zhat[j] = std::copysign(std::sqrt(std::max(w, 0.0)), zk[j]);
+        }
+        parallel::parallel_for(k, 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                double norm = 0.0;
+                for (size_t j = 0; j < k; j++)
+                {
+                    const double u = zhat[j] / delta(i, j);
+                    U(j, i) = u;
+                    norm += u * u;
+                }
+                norm = 1.0 / std::sqrt(norm);
+                for (size_t j = 0; j < k; j++)
+                {
+                    U(j, i) *= norm;
+                }
+            }
+        });
+
+        // New vectors Q[:, kept] U, using that columns from the first half are zero below row m and
+        // columns from the second half zero above it, unless a deflation rotation mixed them
+        MATRIX merged(n, k);
+        for (int half = 0; half < 2; half++)
+        {
+            const unsigned char bit = half == 0 ? 1 : 2;
+            const size_t first = half == 0 ? 0 : m, rows = half == 0 ? m : n - m;
+            std::vector<size_t> used;
+            for (size_t j = 0; j < k; j++)
+            {
+                if (type[kept[j]] & bit)
+                {
+                    used.push_back(j);
+                }
+            }
+            if (used.empty())
+            {
+                continue;
+            }
+            MATRIX Qs(rows, used.size()), Us(used.size(), k);
+            for (size_t r = 0; r < rows; r++)
+            {
+                for (size_t p = 0; p < used.size(); p++)
+                {
+                    Qs(r, p) = Q(first + r, column[kept[used[p]]]);
+                }
+            }
+            for (size_t p = 0; p < used.size(); p++)
+            {
+                std::copy_n(U.data() + used[p] * U.stride(), k, Us.data() + p * Us.stride());
+            }
+            blas::parallel_gemm(blas::Op::none, blas::Op::none, rows, k, used.size(), 1.0, Qs.data(), Qs.stride(),
+                                Us.data(), Us.stride(), 0.0, merged.data() + first * merged.stride(), merged.stride());
+        }
+
+        // Gather eigenvalues and vectors in ascending order
+        struct Pair
+        {
+            double value;
+            bool secular;
+            size_t index;
+        };
+        std::vector<Pair> pairs;
+        pairs.reserve(n);
+        for (size_t i = 0; i < k; i++)
+        {
+            pairs.push_back({lambda[i], true, i});
+        }
+        for (size_t j : deflated)
+        {
+            pairs.push_back({ds[j], false, column[j]});
+        }
+        std::stable_sort(pairs.begin(), pairs.end(), [](const Pair &x, const Pair &y) { return x.value < y.value; });
+
+        MATRIX result(n, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            d[i] = pairs[i].value;
+            for (size_t r = 0; r < n; r++)
+            {
+                result(r, i) = pairs[i].secular ? merged(r, pairs[i].index) : Q(r, pairs[i].index);
+            }
+        }
+        Q = result;
+    }
+
+    // Eigen-decomposition of the symmetric tridiagonal (d, e): d becomes the ascending eigenvalues and
+    // Q (n x n) the eigenvectors. Cuppen's divide and conquer: T = diag(T1, T2) + |beta| u u^T, solve
+    // the halves independently, then merge them through the rank-one secular equation.
+    void tridiagonal_dc(double *d, double *e, MatrixView Q)
+    {
+        const size_t n = Q.getRowCount();
+        for (size_t r = 0; r < n; r++)
+        {
+            for (size_t c = 0; c < n; c++)
+            {
+                Q(r, c) = r == c ? 1.0 : 0.0;
+            }
+        }
+        if (n <= LEAF)
+        {
+            std::vector<double> off(e, e + n);
+            tridiagonal_ql(d, off.data(), n, &Q);
+            return;
+        }
+
+        const size_t m = n / 2;
+        const double beta = e[m - 1];
+        d[m - 1] -= std::abs(beta);
+        d[m] -= std::abs(beta);
+
+        parallel::parallel_for(2, 1, [&](size_t begin, size_t end) {
+            for (size_t half = begin; half < end; half++)
+            {
+                if (half == 0)
+                {
+                    tridiagonal_dc(d, e, Q.block(0, 0, m, m));
+                }
+                else
+                {
+                    tridiagonal_dc(d + m, e + m, Q.block(m, m, n - m, n - m));
+                }
+            }
+        });
+        if (beta == 0.0)
+        {
+            MatrixView all = Q;
+            sort_eigenpairs(d, n, &all);
+            return;
+        }
+        merge(d, Q, m, beta);
+    }
+
+    // Symmetric eigenvalues (ascending) and, when vectors is given, the matching eigenvectors as columns.
+    Vector symmetric_eigen(ConstMatrixView A, MATRIX *vectors)
+    {
+        const size_t n = A.getRowCount();
+        // Nominal counts of the textbook algorithms, the QR iterations vary with the spectrum
+        TSMATH_INSTRUMENT(eigen, (vectors ? 9 * n * n * n : 4 * n * n * n / 3), 2 * n * n * sizeof(double));
+        Tridiagonal t = tridiagonalize(A);
+        if (!vectors)
+        {
+            tridiagonal_ql(t.d.data(), t.e.data(), n, nullptr);
+            return Vector(t.d);
+        }
+
+        *vectors = MATRIX(n, n);
+        tridiagonal_dc(t.d.data(), t.e.data(), *vectors);
+        apply_reflectors(t.reflectors, t.tau, n > 1 ? n - 1 : 0, *vectors);
+        return Vector(t.d);
+    }
+
+    // Hessenberg reduction Q^T A Q = H of a general matrix.
+    struct Hessenberg
+    {
+        // H on and above the subdiagonal, reflector c below the subdiagonal of column c.
+        MATRIX packed;
+        std::vector<double> tau;
+    };
+
+    // Blocked Hessenberg reduction in the style of dgehrd/dlahr2. Within a panel each column receives
+    // the pending right updates through Y = A V T and the left updates through the compact WY form;
+    // the rest of the matrix then takes A -= Y V^T and A = (I - V T^T V^T) A as block products.
+    Hessenberg hessenberg(ConstMatrixView A)
+    {
+        const size_t n = A.getRowCount();
+        Hessenberg h{MATRIX(A), std::vector<double>(n, 0.0)};
+        MATRIX &H = h.packed;
+        double *a = H.data();
+        const size_t lda = H.stride();
+        const size_t count = n > 2 ? n - 2 : 0;
+
+        MATRIX V(n, NB), Y(n, NB), T(NB, NB), Wt(NB, n);
+        std::vector<double> v(n), y(n), w(NB), x(NB);
+        for (size_t k = 0; k < count; k += NB)
+        {
+            const size_t jb = std::min(NB, count - k), rows = n - k - 1;
+            for (size_t i = 0; i < jb; i++)
+            {
+                const size_t c = k + i;
+                if (i > 0)
+                {
+                    // Right updates: A(k+1:, c) -= Y(k+1:, 0:i) V(i-1, 0:i)^T
+                    for (size_t r = k + 1; r < n; r++)
+                    {
+                        double sum = 0.0;
+                        for (size_t p = 0; p < i; p++)
+                        {
+                            sum += Y(r, p) * V(i - 1, p);
+                        }
+                        a[r * lda + c] -= sum;
+                    }
+
+                    // Left updates: b = (I - V T^T V^T) b with b = A(k+1:, c)
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        double sum = 0.0;
+                        for (size_t r = p; r < rows; r++)
+                        {
+                            sum += V(r, p) * a[(k + 1 + r) * lda + c];
+                        }
+                        w[p] = sum;
+                    }
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        double sum = 0.0;
+                        for (size_t q = 0; q <= p; q++)
+                        {
+                            sum += T(q, p) * w[q];
+                        }
+                        x[p] = sum;
+                    }
+                    for (size_t r = 0; r < rows; r++)
+                    {
+                        double sum = 0.0;
+                        for (size_t p = 0; p < i && p <= r; p++)
+                        {
+                            sum += V(r, p) * x[p];
+                        }
+                        a[(k + 1 + r) * lda + c] -= sum;
+                    }
+                }
+
+                const double tau = householder::generate(a + (c + 1) * lda + c, n - c - 1, lda);
+                h.tau[c] = tau;
+                for (size_t r = 0; r < rows; r++)
+                {
+                    const size_t row = k + 1 + r;
+                    V(r, i) = row <= c ? 0.0 : row == c + 1 ? 1.0 : a[row * lda + c];
+                }
+
+                // Y(k+1:, i) = tau (A(k+1:, c+1:) v - Y(k+1:, 0:i) V^T v)
+                for (size_t r = c + 1; r < n; r++)
+                {
+                    v[r - c - 1] = V(r - k - 1, i);
+                }
+                {
+                    const double *block = a + (k + 1) * lda + c + 1;
+                    const size_t length = n - c - 1;
+                    double *out = y.data();
+                    const double *vector = v.data();
+                    parallel::parallel_for(rows, ROW_GRAIN, [=](size_t begin, size_t end) {
+                        for (size_t r = begin; r < end; r++)
+                        {
+                            out[r] = simd::dot(block + r * lda, vector, length);
+                        }
+                    });
+                }
+                for (size_t p = 0; p < i; p++)
+                {
+                    double sum = 0.0;
+                    for (size_t r = i; r < rows; r++)
+                    {
+                        sum += V(r, p) * V(r, i);
+                    }
+                    T(p, i) = sum;
+                }
+                for (size_t r = 0; r < rows; r++)
+                {
+                    double sum = y[r];
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        sum -= Y(k + 1 + r, p) * T(p, i);
+                    }
+                    Y(k + 1 + r, i) = tau * sum;
+                }
+
+                // T(0:i, i) = -tau T(0:i, 0:i) V^T v, T(i, i) = tau
+                for (size_t p = 0; p < i; p++)
+                {
+                    double sum = 0.0;
+                    for (size_t q = p; q < i; q++)
+                    {
+                        sum += T(p, q) * T(q, i);
+                    }
+                    w[p] = -tau * sum;
+                }
+                for (size_t p = 0; p < i; p++)
+                {
+                    T(p, i) = w[p];
+                }
+                T(i, i) = tau;
+                for (size_t p = i + 1; p < NB; p++)
+                {
+                    T(p, i) = 0.0;
+                }
+            }
+
+            // Y(0:k+1, :) = A(0:k+1, k+1:) V T
+            const size_t top = k + 1;
+            blas::parallel_gemm(blas::Op::none, blas::Op::none, top, jb, rows, 1.0, a + k + 1, lda, V.data(), V.stride(),
+                                0.0, Y.data(), Y.stride());
+            for (size_t r = 0; r < top; r++)
+            {
+                for (size_t p = jb; p-- > 0;)
+                {
+                    double sum = 0.0;
+                    for (size_t q = 0; q <= p; q++)
+                    {
+                        sum += Y(r, q) * T(q, p);
+                    }
+                    Y(r, p) = sum;
+                }
+            }
+
+            // Right update: rows 0..k of every column past k, rows below only past the panel
+            blas::parallel_gemm(blas::Op::none, blas::Op::transpose, top, rows, jb, -1.0, Y.data(), Y.stride(), V.data(),
+                                V.stride(), 1.0, a + k + 1, lda);
+            const size_t after = k + jb;
+            if (after < n)
+            {
+                blas::parallel_gemm(blas::Op::none, blas::Op::transpose, rows, n - after, jb, -1.0,
+                                    Y.data() + top * Y.stride(), Y.stride(), V.data() + (jb - 1) * V.stride(), V.stride(),
+                                    1.0, a + top * lda + after, lda);
+
+                // Left update of the trailing columns
+                householder::apply_block(V, rows, jb, T.data(), T.stride(), H.block(top, after, rows, n - after), Wt,
+                                         true);
+            }
+        }
+        return h;
+    }
+
+    // Applies the plane rotation [c s; -s c] to rows (p, p + 1) of H from column 'first' on, and its
+    // transpose to columns (p, p + 1) of H up to row 'last' and of Z.
+    void rotate(MATRIX &H, MATRIX *Z, size_t p, double c, double s, size_t first, size_t last)
+    {
+        const size_t n = H.getColumnCount();
+        for (size_t j = first; j < n; j++)
+        {
+            const double x = H(p, j), y = H(p + 1, j);
+            H(p, j) = c * x + s * y;
+            H(p + 1, j) = c * y - s * x;
+        }
+        for (size_t i = 0; i <= last; i++)
+        {
+            const double x = H(i, p), y = H(i, p + 1);
+            H(i, p) = c * x + s * y;
+            H(i, p + 1) = c * y - s * x;
+        }
+        if (Z)
+        {
+            for (size_t i = 0; i < Z->getRowCount(); i++)
+            {
+                const double x = (*Z)(i, p), y = (*Z)(i, p + 1);
+                (*Z)(i, p) = c * x + s * y;
+                (*Z)(i, p + 1) = c * y - s * x;
+            }
+        }
+    }
+
+    // P = I - tau v v^T with v = (1, v1[, v2]) applied to 'size' consecutive rows of H from the left
+    // (columns [first, n)) and to the same columns from the right (rows [0, last]) and of Z.
+    void reflect(MATRIX &H, MATRIX *Z, size_t p, size_t size, const double *v, double tau, size_t first, size_t last)
+    {
+        const size_t n = H.getColumnCount();
+        for (size_t j = first; j < n; j++)
+        {
+            double sum = H(p, j);
+            for (size_t q = 1; q < size; q++)
+            {
+                sum += v[q] * H(p + q, j);
+            }
+            sum *= tau;
+            H(p, j) -= sum;
+            for (size_t q = 1; q < size; q++)
+            {
+                H(p + q, j) -= sum * v[q];
+            }
+        }
+        auto right = [&](MATRIX &M, size_t rows) {
+            for (size_t i = 0; i < rows; i++)
+            {
+                double sum = M(i, p);
+                for (size_t q = 1; q < size; q++)
+                {
+                    sum += v[q] * M(i, p + q);
+                }
+                sum *= tau;
+                M(i, p) -= sum;
+                for (size_t q = 1; q < size; q++)
+                {
+                    M(i, p + q) -= sum * v[q];
+                }
+            }
+        };
+        right(H, last + 1);
+        if (Z)
+        {
+            right(*Z, Z->getRowCount());
+        }
+    }
+
+    // Real Schur form of the upper Hessenberg H by Francis double-shift QR with deflation; the
+    // orthogonal transformations are accumulated into Z when given. Real 2x2 blocks are split into
+    // triangular form, so only complex conjugate pairs remain as 2x2 blocks.
+    void francis_qr(MATRIX &H, MATRIX *Z)
+    {
+        const size_t n = H.getRowCount();
+        double norm = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = i > 0 ? i - 1 : 0; j < n; j++)
+            {
+                norm += std::abs(H(i, j));
+            }
+        }
+
+        size_t hi = n, sweeps = 0;
+        while (hi > 0)
+        {
+            const size_t last = hi - 1;
+
+            // Deflate at the lowest negligible subdiagonal entry
+            size_t lo = last;
+            while (lo > 0)
+            {
+                double s = std::abs(H(lo - 1, lo - 1)) + std::abs(H(lo, lo));
+                if (s == 0.0)
+                {
+                    s = norm;
+                }
+                if (std::abs(H(lo, lo - 1)) <= EPS * s)
+                {
+                    H(lo, lo - 1) = 0.0;
+                    break;
+                }
+                lo--;
+            }
+
+            if (lo == last)
+            {
+                hi--;
+                sweeps = 0;
+                continue;
+            }
+            if (lo + 1 == last)
+            {
+                // 2x2 block: split real pairs with a rotation onto an eigenvector
+                const size_t p = last - 1;
+                const double a = H(p, p), b = H(p, p + 1), c = H(p + 1, p), d = H(p + 1, p + 1);
+                const double half = 0.5 * (a - d), disc = half * half + b * c;
+                if (disc >= 0.0)
+                {
+                    const double root = std::sqrt(disc);
+                    const double lambda = d + (half >= 0.0 ? half + root : half - root);
+                    double x = lambda - d, y = c;
+                    if (std::abs(x) + std::abs(y) < std::abs(b) + std::abs(lambda - a))
+                    {
+                        x = b;
+                        y = lambda - a;
+                    }
+                    const double r = std::hypot(x, y);
+                    if (r != 0.0)
+                    {
+                        rotate(H, Z, p, x / r, y / r, p, p + 1);
+                    }
+                    H(last, last - 1) = 0.0;
+                }
+                hi -= 2;
+                sweeps = 0;
+                continue;
+            }
+
+            if (sweeps++ == MAX_SWEEPS * (last - lo + 1))
+            {
+                throw std::runtime_error("Francis QR iteration did not converge");
+            }
+
+            // Double shift from the trailing 2x2 block, exceptional shifts every tenth sweep
+            double s = H(last - 1, last - 1) + H(last, last);
+            double t = H(last - 1, last - 1) * H(last, last) - H(last - 1, last) * H(last, last - 1);
+            if (sweeps % 10 == 0)
+            {
+                const double w = std::abs(H(last, last - 1)) + std::abs(H(last - 1, last - 2));
+                s = 1.5 * w;
+                t = w * w;
+            }
+
+            // First column of (H - s1 I)(H - s2 I), then chase the bulge down the window
+            double x = H(lo, lo) * H(lo, lo) + H(lo, lo + 1) * H(lo + 1, lo) - s * H(lo, lo) + t;
+            double y = H(lo + 1, lo) * (H(lo, lo) + H(lo + 1, lo + 1) - s);
+            double z = H(lo + 1, lo) * H(lo + 2, lo + 1);
+            for (size_t k = lo; k + 2 <= last; k++)
+            {
+                double v[3] = {x, y, z};
+                const double tau = householder::generate(v, 3, 1);
+                if (tau != 0.0)
+                {
+                    const double beta = v[0];
+                    v[0] = 1.0;
+                    const size_t first = k > lo ? k - 1 : lo;
+                    reflect(H, Z, k, 3, v, tau, first, std::min(k + 3, last));
+                    if (k > lo)
+                    {
+                        H(k, k - 1) = beta;
+                        H(k + 1, k - 1) = 0.0;
+                        H(k + 2, k - 1) = 0.0;
+                    }
+                }
+                x = H(k + 1, k);
+                y = H(k + 2, k);
+                if (k + 3 <= last)
+                {
+                    z = H(k + 3, k);
+                }
+            }
+            double v[2] = {x, y};
+            const double tau = householder::generate(v, 2, 1);
+            if (tau != 0.0)
+            {
+                const double beta = v[0];
+                v[0] = 1.0;
+                reflect(H, Z, last - 1, 2, v, tau, last - 2, last);
+                H(last - 1, last - 2) = beta;
+                H(last, last - 2) = 0.0;
+            }
+        }
+    }
+
+    // Real Schur decomposition (Z, T); Z is only accumulated when wanted.
+    void real_schur(ConstMatrixView A, MATRIX &T, MATRIX *Z)
+    {
+        const size_t n = A.getRowCount();
+        TSMATH_INSTRUMENT(eigen, (Z ? 25 : 10) * n * n * n, 2 * n * n * sizeof(double));
+        Hessenberg h = hessenberg(A);
+        if (Z)
+        {
+            *Z = MATRIX(n, n);
+            for (size_t i = 0; i < n; i++)
+            {
+                (*Z)(i, i) = 1.0;
+            }
+            apply_reflectors(h.packed, h.tau, n > 2 ? n - 2 : 0, *Z);
+        }
+
+        T = std::move(h.packed);
+        for (size_t i = 2; i < n; i++)
+        {
+            for (size_t j = 0; j + 1 < i; j++)
+            {
+                T(i, j) = 0.0;
+            }
+        }
+        francis_qr(T, Z);
+    }
+
+    // Eigenvalues on the diagonal (1x1) and in the 2x2 blocks of a real Schur form.
+    std::vector<std::complex<double>> schur_eigenvalues(const MATRIX &T)
+    {
+        const size_t n = T.getRowCount();
+        std::vector<std::complex<double>> values;
+        values.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            if (i + 1 < n && T(i + 1, i) != 0.0)
+            {
+                const double a = T(i, i), b = T(i, i + 1), c = T(i + 1, i), d = T(i + 1, i + 1);
+                const double half = 0.5 * (a - d), disc = half * half + b * c;
+                const double mean = 0.5 * (a + d), imaginary = std::sqrt(std::max(0.0, -disc));
+                values.emplace_back(mean, imaginary);
+                values.emplace_back(mean, -imaginary);
+                i++;
+            }
+            else
+            {
+                values.emplace_back(T(i, i), 0.0);
+            }
+        }
+        return values;
+    }
+}
+
+std::pair<MATRIX, MATRIX> eigen::schur(ConstMatrixView A)
+{
+    require_square(A);
+    MATRIX T(0, 0), Z(0, 0);
+    real_schur(A, T, &Z);
+    return std::make_pair(Z, T);
+}
+
+MATRIX eigen::shurr_factorization(ConstMatrixView A)
+{
+    require_square(A);
+    MATRIX T(0, 0);
+    real_schur(A, T, nullptr);
+    return T;
+}
+
+std::vector<std::complex<double>> eigen::complex_eigen_values(ConstMatrixView A)
+{
+    require_square(A);
+    if (is_symmetric(A))
+    {
+        Vector values = symmetric_eigen(A, nullptr);
+        return std::vector<std::complex<double>>(values.data(), values.data() + values.dimension());
+    }
+    MATRIX T(0, 0);
+    real_schur(A, T, nullptr);
+    return schur_eigenvalues(T);
+}
+
+Vector eigen::eigen_values(ConstMatrixView A)
+{
+    require_square(A);
+    if (is_symmetric(A))
+    {
+        return symmetric_eigen(A, nullptr);
+    }
+
+    std::vector<std::complex<double>> values = complex_eigen_values(A);
+    Vector result(values.size());
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (values[i].imag() != 0.0)
+        {
+            throw std::domain_error("Matrix has complex eigenvalues, use eigen::complex_eigen_values");
+        }
+        result[i] = values[i].real();
+    }
+    return result;
+}
+
+MATRIX eigen::eigen_Vectors(ConstMatrixView A)
+{
+    require_square(A);
+    const size_t n = A.getRowCount();
+    if (is_symmetric(A))
+    {
+        MATRIX vectors(0, 0);
+        symmetric_eigen(A, &vectors);
+        return vectors;
+    }
+
+    MATRIX T(0, 0), Z(0, 0);
+    real_schur(A, T, &Z);
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        if (T(i + 1, i) != 0.0)
+        {
+            throw std::domain_error("Matrix has complex eigenvalues, use eigen::schur");
+        }
+    }
+
+    // Eigenvectors of the triangular T by back substitution, then mapped back through Z
+    double norm = 0.0;
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t j = i; j < n; j++)
+        {
+            norm = std::max(norm, std::abs(T(i, j)));
+        }
+    }
+    const double small = std::max(EPS * norm, std::numeric_limits<double>::min());
+    MATRIX X(n, n);
+    for (size_t k = 0; k < n; k++)
+    {
+        const double lambda = T(k, k);
+        X(k, k) = 1.0;
+        for (size_t i = k; i-- > 0;)
+        {
+            double sum = 0.0;
+            for (size_t j = i + 1; j <= k; j++)
+            {
+                sum += T(i, j) * X(j, k);
+            }
+            double pivot = T(i, i) - lambda;
+            if (std::abs(pivot) < small)
+            {
+                pivot = small;
+            }
+            X(i, k) = -sum / pivot;
+        }
+    }
+    MATRIX vectors(n, n);
+    blas::parallel_gemm(blas::Op::none, blas::Op::none, n, n, n, 1.0, Z.data(), Z.stride(), X.data(), X.stride(), 0.0,
+                        vectors.data(), vectors.stride());
+    for (size_t k = 0; k < n; k++)
+    {
+        double length = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            length += vectors(i, k) * vectors(i, k);
+        }
+        length = 1.0 / std::sqrt(length);
+        for (size_t i = 0; i < n; i++)
+        {
+            vectors(i, k) *= length;
+        }
+    }
+    return vectors;
+}
@@ -0,0 +1,142 @@
+#include "../include/householder.h"
+#include "../include/blas.h"
+#include "../include/thread_pool.h"
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Columns of the updated matrix handed to one thread when applying a block reflector.
+    constexpr size_t APPLY_GRAIN = 256;
+}
+
+double householder::generate(double *x, size_t length, size_t stride)
+{
+    double alpha = x[0];
+    double squares = 0.0;
+    for (size_t i = 1; i < length; i++)
+    {
+        squares += x[i * stride] * x[i * stride];
+    }
+    double sigma = std::sqrt(squares);
+    if (!std::isfinite(squares) || (squares != 0.0 && squares < std::numeric_limits<double>::min()))
+    {
+        // Over- or underflow in the squares, redo the norm with running hypot
+        sigma = 0.0;
+        for (size_t i = 1; i < length; i++)
+        {
+            sigma = std::hypot(sigma, x[i * stride]);
+        }
+    }
+    if (sigma == 0.0)
+    {
+        return 0.0;
+    }
+
+    double norm = std::hypot(alpha, sigma);
+    double beta = alpha >= 0.0 ? -norm : norm;
+    double scale = 1.0 / (alpha - beta);
+    for (size_t i = 1; i < length; i++)
+    {
+        x[i * stride] *= scale;
+    }
+    x[0] = beta;
+    return (beta - alpha) / beta;
+}
+
+void householder::unpack(ConstMatrixView packed, size_t jb, MATRIX &V)
+{
+    const size_t rows = packed.getRowCount();
+    for (size_t i = 0; i < rows; i++)
+    {
+        for (size_t p = 0; p < jb; p++)
+        {
+            V(i, p) = i < p ? 0.0 : i == p ? 1.0 : packed(i, p);
+        }
+    }
+}
+
+void householder::form_t(const MATRIX &V, size_t rows, size_t jb, const double *tau, MATRIX &G, double *t, size_t ldt)
+{
+    blas::gemm(blas::Op::transpose, blas::Op::none, jb, jb, rows, 1.0, V.data(), V.stride(), V.data(), V.stride(),
+               0.0, G.data(), G.stride());
+    for (size_t i = 0; i < jb; i++)
+    {
+        t[i * ldt + i] = tau[i];
+        for (size_t p = 0; p < i; p++)
+        {
+            double sum = 0.0;
+            for (size_t q = p; q < i; q++)
+            {
+                sum += t[p * ldt + q] * G(q, i);
+            }
+            t[p * ldt + i] = -tau[i] * sum;
+        }
+        for (size_t p = i + 1; p < jb; p++)
+        {
+            t[p * ldt + i] = 0.0;
+        }
+    }
+}
+
+void householder::apply_block(const MATRIX &V, size_t rows, size_t jb, const double *t, size_t ldt, MatrixView C,
+                              MATRIX &W, bool transposed)
+{
+    const size_t columns = C.getColumnCount();
+    parallel::parallel_for(columns, APPLY_GRAIN, [&](size_t begin, size_t end) {
+        const size_t width = end - begin;
+        double *w = W.data() + begin;
+        const size_t ldw = W.stride();
+        double *c = C.data() + begin;
+
+        // W = V^T C
+        blas::gemm(blas::Op::transpose, blas::Op::none, jb, width, rows, 1.0, V.data(), V.stride(), c, C.stride(),
+                   0.0, w, ldw);
+
+        // W = T^T W (lower, bottom-up) or W = T W (upper, top-down), in place
+        if (transposed)
+        {
+            for (size_t i = jb; i-- > 0;)
+            {
+                double *wi = w + i * ldw;
+                for (size_t j = 0; j < width; j++)
+                {
+                    wi[j] *= t[i * ldt + i];
+                }
+                for (size_t p = 0; p < i; p++)
+                {
+                    const double tpi = t[p * ldt + i];
+                    const double *wp = w + p * ldw;
+                    for (size_t j = 0; j < width; j++)
+                    {
+                        wi[j] += tpi * wp[j];
+                    }
+                }
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < jb; i++)
+            {
+                double *wi = w + i * ldw;
+                for (size_t j = 0; j < width; j++)
+                {
+                    wi[j] *= t[i * ldt + i];
+                }
+                for (size_t p = i + 1; p < jb; p++)
+                {
+                    const double tip = t[i * ldt + p];
+                    const double *wp = w + p * ldw;
+                    for (size_t j = 0; j < width; j++)
+                    {
+                        wi[j] += tip * wp[j];
+                    }
+                }
+            }
+        }
+
+        // C -= V W
+        blas::gemm(blas::Op::none, blas::Op::none, rows, width, jb, -1.0, V.data(), V.stride(), w, ldw, 1.0, c,
+                   C.stride());
+    });
+}
@@ -0,0 +1,238 @@
+#include "../include/instrument.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <utility>
+
+namespace
+{
+    constexpr size_t KERNELS = static_cast<size_t>(instrument::Kernel::count);
+
+    const char *const NAMES[KERNELS] = {
+        "vector_expression", "vector_add", "vector_scale", "vector_axpy", "vector_dot",
+        "matrix_expression", "matrix_add", "matrix_scale", "matrix_axpy", "matrix_multiply", "transpose",
+        "transpose_in_place", "gemm", "axpy", "scal", "axpby", "triangular_solve",
+        "lu", "lu_solve", "cholesky", "cholesky_solve", "inverse", "gpp", "qr", "least_squares", "eigen", "svd",
+        "randomized_svd", "convolution", "polynomial_division", "sparse_multiply", "cg", "gmres", "bicgstab",
+        "allocation"};
+
+    // Counters of one kernel. Only the owning thread writes them, so a relaxed load and store is
+    // enough and compiles to plain moves; other threads may read them at any time.
+    struct Slot
+    {
+        std::atomic<std::uint64_t> calls{0}, nanoseconds{0}, flops{0}, bytes{0}, allocations{0}, allocated_bytes{0};
+    };
+
+    constexpr size_t FIELDS = 6;
+
+    inline void add(std::atomic<std::uint64_t> &counter, std::uint64_t value) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    using Totals = std::array<std::array<std::uint64_t, FIELDS>, KERNELS>;
+
+    struct ThreadCounters;
+
+    // Counters of the running threads, and the totals of the threads that have exited.
+    struct Registry
+    {
+        std::mutex mutex;
+        std::vector<ThreadCounters *> threads;
+        Totals retired{};
+    };
+
+    Registry &registry()
+    {
+        // Never destroyed, threads may exit during static destruction
+        static Registry *instance = new Registry();
+        return *instance;
+    }
+
+    // Reads the counters of one slot in Stats order.
+    std::array<std::uint64_t, FIELDS> load(const Slot &slot) noexcept
+    {
+        return {slot.calls.load(std::memory_order_relaxed),       slot.nanoseconds.load(std::memory_order_relaxed),
+                slot.flops.load(std::memory_order_relaxed),       slot.bytes.load(std::memory_order_relaxed),
+                slot.allocations.load(std::memory_order_relaxed), slot.allocated_bytes.load(std::memory_order_relaxed)};
+    }
+
+    struct ThreadCounters
+    {
+        Slot slots[KERNELS];
+
+        ThreadCounters()
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.threads.push_back(this);
+        }
+
+        ~ThreadCounters()
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for (size_t k = 0; k < KERNELS; k++)
+            {
+                const auto values = load(slots[k]);
+                for (size_t f = 0; f < FIELDS; f++)
+                {
+                    r.retired[k][f] += values[f];
+                }
+            }
+            r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+        }
+    };
+
+    ThreadCounters &counters()
+    {
+        thread_local ThreadCounters instance;
+        return instance;
+    }
+
+    // Innermost kernel of the calling thread, Kernel::count outside every kernel. A plain thread_local
+    // without a constructor, so allocations during thread start-up and exit can read it.
+    thread_local instrument::Kernel innermost = instrument::Kernel::count;
+
+    // Prints the counters at exit when TSMATH_INSTRUMENT_DUMP is set, to stderr.
+    struct ExitDump
+    {
+        ~ExitDump()
+        {
+            if (instrument::enabled() && std::getenv("TSMATH_INSTRUMENT_DUMP") != nullptr)
+            {
+                instrument::dump(std::cerr);
+            }
+        }
+    } exit_dump;
+}
+
+const char *instrument::name(Kernel kernel) noexcept
+{
+    const size_t k = static_cast<size_t>(kernel);
+    return k < KERNELS ? NAMES[k] : "unknown";
+}
+
+void instrument::record(Kernel kernel, std::uint64_t nanoseconds, std::uint64_t flops, std::uint64_t bytes) noexcept
+{
+    Slot &slot = counters().slots[static_cast<size_t>(kernel)];
+    add(slot.calls, 1);
+    add(slot.nanoseconds, nanoseconds);
+    add(slot.flops, flops);
+    add(slot.bytes, bytes);
+}
+
+instrument::Kernel instrument::enter(Kernel kernel) noexcept
+{
+    return std::exchange(innermost, kernel);
+}
+
+void instrument::leave(Kernel previous) noexcept
+{
+    innermost = previous;
+}
+
+instrument::Kernel instrument::current() noexcept
+{
+    return innermost;
+}
+
+void instrument::record_allocation(std::uint64_t bytes) noexcept
+{
+    const Kernel kernel = innermost == Kernel::count ? Kernel::allocation : innermost;
+    Slot &slot = counters().slots[static_cast<size_t>(kernel)];
+    add(slot.allocations, 1);
+    add(slot.allocated_bytes, bytes);
+}
+
+instrument::Scope::~Scope()
+{
+    leave(m_previous);
+    const auto elapsed = std::chrono::steady_clock::now() - m_start;
+    record(m_kernel, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), m_flops, m_bytes);
+}
+
+std::vector<instrument::Stats> instrument::snapshot()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Totals totals = r.retired;
+    for (const ThreadCounters *thread : r.threads)
+    {
+        for (size_t k = 0; k < KERNELS; k++)
+        {
+            const auto values = load(thread->slots[k]);
+            for (size_t f = 0; f < FIELDS; f++)
+            {
+                totals[k][f] += values[f];
+            }
+        }
+    }
+
+    std::vector<Stats> stats;
+    for (size_t k = 0; k < KERNELS; k++)
+    {
+        if (totals[k][0] != 0 || totals[k][4] != 0)
+        {
+            stats.push_back(Stats{static_cast<Kernel>(k), NAMES[k], totals[k][0], totals[k][1], totals[k][2], totals[k][3],
+                                  totals[k][4], totals[k][5]});
+        }
+    }
+    return stats;
+}
+
+void instrument::reset()
+{
+    Registry &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired = Totals{};
+    for (ThreadCounters *thread : r.threads)
+    {
+        for (Slot &slot : thread->slots)
+        {
+            slot.calls.store(0, std::memory_order_relaxed);
+            slot.nanoseconds.store(0, std::memory_order_relaxed);
+            slot.flops.store(0, std::memory_order_relaxed);
+            slot.bytes.store(0, std::memory_order_relaxed);
+            slot.allocations.store(0, std::memory_order_relaxed);
+            slot.allocated_bytes.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void instrument::dump(std::ostream &out)
+{
+    std::vector<Stats> stats = snapshot();
+    std::stable_sort(stats.begin(), stats.end(),
+                     [](const Stats &a, const Stats &b) { return a.nanoseconds > b.nanoseconds; });
+
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::left << std::setw(20) << "kernel" << std::right << std::setw(12) << "calls" << std::setw(14)
+        << "time[ms]" << std::setw(14) << "per call[us]" << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s"
+        << std::setw(10) << "allocs" << std::setw(16) << "alloc bytes" << '\n';
+    out << std::fixed;
+    for (const Stats &s : stats)
+    {
+        const double seconds = s.nanoseconds * 1e-9;
+        out << std::left << std::setw(20) << s.name << std::right << std::setw(12) << s.calls << std::setprecision(3);
+        if (s.calls == 0)
+        {
+            // Kernel::allocation, or a kernel whose only calls so far are still running
+            out << std::setw(14) << "-" << std::setw(14) << "-" << std::setw(10) << "-" << std::setw(10) << "-";
+        }
+        else
+        {
+            out << std::setw(14) << s.nanoseconds * 1e-6 << std::setw(14) << s.nanoseconds * 1e-3 / s.calls
+                << std::setprecision(2) << std::setw(10) << (seconds > 0.0 ? s.flops * 1e-9 / seconds : 0.0)
+                << std::setw(10) << (seconds > 0.0 ? s.bytes * 1e-9 / seconds : 0.0);
+        }
+        out << std::setw(10) << s.allocations << std::setw(16) << s.allocated_bytes << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,689 @@
+#include "../include/instrument.h"
+#include "../include/krylov.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // Rows handed to one thread by the dense operator.
+    constexpr size_t ROW_GRAIN = 64;
+
+    // Dense products with fewer entries than this stay on the calling thread.
+    constexpr size_t PARALLEL_DENSE = 64 * 64 * 64;
+
+    // Marks a column with no entry in the current row of the ILU(0) elimination.
+    constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    double norm(const double *x, size_t n)
+    {
+        return std::sqrt(simd::sum_squares(x, n));
+    }
+
+    // y += alpha * x
+    void axpy(double alpha, const double *x, double *y, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    void gather(ConstVectorView v, double *out)
+    {
+        for (size_t i = 0; i < v.dimension(); i++)
+        {
+            out[i] = v.coeff(i);
+        }
+    }
+
+    void scatter(const double *x, VectorView v)
+    {
+        for (size_t i = 0; i < v.dimension(); i++)
+        {
+            v[i] = x[i];
+        }
+    }
+
+    // r = b - A x
+    void residual(const krylov::Operator &A, const double *b, const double *x, double *r, size_t n)
+    {
+        A.apply(x, r);
+        for (size_t i = 0; i < n; i++)
+        {
+            r[i] = b[i] - r[i];
+        }
+    }
+
+    // Shapes of A x = b, and the result of a solve before its first iteration.
+    krylov::Result start(const krylov::Operator &A, ConstVectorView b, VectorView x, const krylov::Options &options)
+    {
+        if (b.dimension() != A.dimension() || x.dimension() != A.dimension())
+        {
+            throw std::invalid_argument("Vector dimensions do not match the operator");
+        }
+        krylov::Result result{false, 0, 0.0, std::vector<double>()};
+        if (options.record_history)
+        {
+            result.history.reserve(options.max_iterations + 1);
+        }
+        return result;
+    }
+
+    void record(krylov::Result &result, const krylov::Options &options, double residual)
+    {
+        result.residual = residual;
+        if (options.record_history)
+        {
+            result.history.push_back(residual);
+        }
+    }
+
+    // A zero right-hand side is solved by x = 0.
+    bool solve_zero(double bnorm, VectorView x, krylov::Result &result, const krylov::Options &options)
+    {
+        if (bnorm != 0.0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < x.dimension(); i++)
+        {
+            x[i] = 0.0;
+        }
+        record(result, options, 0.0);
+        result.converged = true;
+        return true;
+    }
+
+    // Sparse copy in CSR order, for the factorizations that walk rows.
+    SparseMatrix square_csr(const SparseMatrix &A)
+    {
+        if (A.getRowCount() != A.getColumnCount())
+        {
+            throw std::invalid_argument("Preconditioner needs a square matrix");
+        }
+        return A.to_format(SparseMatrix::Format::csr);
+    }
+}
+
+krylov::Operator::Operator(size_t dimension, Apply apply) : m_dimension(dimension), m_apply(std::move(apply))
+{
+}
+
+krylov::Operator::Operator(ConstMatrixView A) : m_dimension(A.getRowCount())
+{
+    if (A.getRowCount() != A.getColumnCount())
+    {
+        throw std::invalid_argument("Operator needs a square matrix");
+    }
+    const double *a = A.data();
+    const size_t n = m_dimension, lda = A.stride();
+    m_apply = [a, n, lda](const double *x, double *y) {
+        const auto rows = [=](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                y[i] = simd::dot(a + i * lda, x, n);
+            }
+        };
+        if (!parallel::worthwhile(n * n, PARALLEL_DENSE))
+        {
+            rows(0, n);
+        }
+        else
+        {
+            parallel::parallel_for(n, ROW_GRAIN, rows);
+        }
+    };
+}
+
+krylov::Operator::Operator(const MATRIX &A) : Operator(ConstMatrixView(A))
+{
+}
+
+krylov::Operator::Operator(const SparseMatrix &A) : m_dimension(A.getRowCount())
+{
+    if (A.getRowCount() != A.getColumnCount())
+    {
+        throw std::invalid_argument("Operator needs a square matrix");
+    }
+    const SparseMatrix csr = A.to_format(SparseMatrix::Format::csr);
+    const size_t n = m_dimension;
+    m_apply = [csr, n](const double *x, double *y) {
+        csr.multiply(1.0, ConstVectorView(x, n), 0.0, VectorView(y, n));
+    };
+}
+
+size_t krylov::Operator::dimension() const noexcept
+{
+    return m_dimension;
+}
+
+void krylov::Operator::apply(const double *x, double *y) const
+{
+    m_apply(x, y);
+}
+
+krylov::Preconditioner::Preconditioner() : m_kind(Kind::identity)
+{
+}
+
+krylov::Preconditioner::Preconditioner(Apply apply) : m_kind(Kind::custom), m_apply(std::move(apply))
+{
+}
+
+krylov::Preconditioner krylov::Preconditioner::jacobi(const SparseMatrix &A)
+{
+    const SparseMatrix csr = square_csr(A);
+    Preconditioner M;
+    M.m_kind = Kind::jacobi;
+    M.m_values.resize(csr.getRowCount());
+    for (size_t i = 0; i < csr.getRowCount(); i++)
+    {
+        const double d = csr.coeff(i, i);
+        if (d == 0.0)
+        {
+            throw std::domain_error("Jacobi preconditioner needs a non-zero diagonal");
+        }
+        M.m_values[i] = 1.0 / d;
+    }
+    return M;
+}
+
+krylov::Preconditioner krylov::Preconditioner::jacobi(ConstMatrixView A)
+{
+    if (A.getRowCount() != A.getColumnCount())
+    {
+        throw std::invalid_argument("Preconditioner needs a square matrix");
+    }
+    Preconditioner M;
+    M.m_kind = Kind::jacobi;
+    M.m_values.resize(A.getRowCount());
+    for (size_t i = 0; i < A.getRowCount(); i++)
+    {
+        if (A(i, i) == 0.0)
+        {
+            throw std::domain_error("Jacobi preconditioner needs a non-zero diagonal");
+        }
+        M.m_values[i] = 1.0 / A(i, i);
+    }
+    return M;
+}
+
+krylov::Preconditioner krylov::Preconditioner::ilu0(const SparseMatrix &A)
+{
+    const SparseMatrix csr = square_csr(A);
+    const size_t n = csr.getRowCount();
+    Preconditioner M;
+    M.m_kind = Kind::ilu0;
+    M.m_offsets = csr.offsets();
+    M.m_indices = csr.indices();
+    M.m_values = csr.values();
+    M.m_diagonal.resize(n);
+    const size_t *offsets = M.m_offsets.data(), *indices = M.m_indices.data();
+    double *values = M.m_values.data();
+    for (size_t i = 0; i < n; i++)
+    {
+        const size_t *found = std::lower_bound(indices + offsets[i], indices + offsets[i + 1], i);
+        if (found == indices + offsets[i + 1] || *found != i)
+        {
+            throw std::domain_error("ILU(0) needs every diagonal entry stored");
+        }
+        M.m_diagonal[i] = found - indices;
+    }
+
+    // Row i is eliminated against the finished rows above it, updates that fall outside the
+    // pattern of row i being dropped
+    std::vector<size_t> position(n, NONE);
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t q = offsets[i]; q < offsets[i + 1]; q++)
+        {
+            position[indices[q]] = q;
+        }
+        for (size_t p = offsets[i]; p < M.m_diagonal[i]; p++)
+        {
+            const size_t k = indices[p];
+            const double pivot = values[M.m_diagonal[k]];
+            if (pivot == 0.0)
+            {
+                throw std::domain_error("Zero pivot in ILU(0)");
+            }
+            const double l = values[p] /= pivot;
+            for (size_t q = M.m_diagonal[k] + 1; q < offsets[k + 1]; q++)
+            {
+                if (position[indices[q]] != NONE)
+                {
+                    values[position[indices[q]]] -= l * values[q];
+                }
+            }
+        }
+        for (size_t q = offsets[i]; q < offsets[i + 1]; q++)
+        {
+            position[indices[q]] = NONE;
+        }
+        if (values[M.m_diagonal[i]] == 0.0)
+        {
+            throw std::domain_error("Zero pivot in ILU(0)");
+        }
+    }
+    return M;
+}
+
+krylov::Preconditioner krylov::Preconditioner::ic0(const SparseMatrix &A)
+{
+    const SparseMatrix csr = square_csr(A);
+    const size_t n = csr.getRowCount();
+    Preconditioner M;
+    M.m_kind = Kind::ic0;
+
+    // Lower triangle of A, the diagonal closing every row
+    M.m_offsets.assign(n + 1, 0);
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t p = csr.offsets()[i]; p < csr.offsets()[i + 1] && csr.indices()[p] <= i; p++)
+        {
+            M.m_indices.push_back(csr.indices()[p]);
+            M.m_values.push_back(csr.values()[p]);
+        }
+        M.m_offsets[i + 1] = M.m_indices.size();
+        if (M.m_offsets[i + 1] == M.m_offsets[i] || M.m_indices.back() != i)
+        {
+            throw std::domain_error("IC(0) needs every diagonal entry stored");
+        }
+    }
+
+    // L(i, k) = (A(i, k) - L(i, 0:k) . L(k, 0:k)) / L(k, k), the dot product over the common pattern
+    const size_t *offsets = M.m_offsets.data(), *indices = M.m_indices.data();
+    double *values = M.m_values.data();
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t p = offsets[i]; p < offsets[i + 1]; p++)
+        {
+            const size_t k = indices[p], last_k = offsets[k + 1] - 1;
+            double s = values[p];
+            size_t a = offsets[i], b = offsets[k];
+            while (a < p && b < last_k)
+            {
+                if (indices[a] == indices[b])
+                {
+                    s -= values[a++] * values[b++];
+                }
+                else if (indices[a] < indices[b])
+                {
+                    a++;
+                }
+                else
+                {
+                    b++;
+                }
+            }
+            if (k < i)
+            {
+                values[p] = s / values[last_k];
+            }
+            else
+            {
+                if (!(s > 0.0))
+                {
+                    throw std::domain_error("Non-positive pivot in IC(0)");
+                }
+                values[p] = std::sqrt(s);
+            }
+        }
+    }
+    return M;
+}
+
+void krylov::Preconditioner::apply(const double *r, double *z, size_t n) const
+{
+    const size_t *offsets = m_offsets.data(), *indices = m_indices.data(), *diagonal = m_diagonal.data();
+    const double *values = m_values.data();
+    switch (m_kind)
+    {
+    case Kind::identity:
+        std::copy_n(r, n, z);
+        break;
+    case Kind::custom:
+        m_apply(r, z);
+        break;
+    case Kind::jacobi:
+        for (size_t i = 0; i < n; i++)
+        {
+            z[i] = values[i] * r[i];
+        }
+        break;
+    case Kind::ilu0:
+        // L y = r (unit diagonal), then U z = y
+        for (size_t i = 0; i < n; i++)
+        {
+            double s = r[i];
+            for (size_t p = offsets[i]; p < diagonal[i]; p++)
+            {
+                s -= values[p] * z[indices[p]];
+            }
+            z[i] = s;
+        }
+        for (size_t i = n; i-- > 0;)
+        {
+            double s = z[i];
+            for (size_t p = diagonal[i] + 1; p < offsets[i + 1]; p++)
+            {
+                s -= values[p] * z[indices[p]];
+            }
+            z[i] = s / values[diagonal[i]];
+        }
+        break;
+    case Kind::ic0:
+        // L y = r, then L^T z = y column by column of L^T, i.e. row by row of L
+        for (size_t i = 0; i < n; i++)
+        {
+            double s = r[i];
+            const size_t last = offsets[i + 1] - 1;
+            for (size_t p = offsets[i]; p < last; p++)
+            {
+                s -= values[p] * z[indices[p]];
+            }
+            z[i] = s / values[last];
+        }
+        for (size_t i = n; i-- > 0;)
+        {
+            const size_t last = offsets[i + 1] - 1;
+            const double zi = z[i] /= values[last];
+            for (size_t p = offsets[i]; p < last; p++)
+            {
+                z[indices[p]] -= values[p] * zi;
+            }
+        }
+        break;
+    }
+}
+
+double *krylov::Workspace::reserve(size_t count)
+{
+    if (m_buffer.size() < count)
+    {
+        m_buffer.resize(count);
+    }
+    return m_buffer.data();
+}
+
+krylov::Result krylov::cg(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M,
+                          const Options &options, Workspace &workspace)
+{
+    // Time only: the iteration count is not known up front, operator products count as their own kernels
+    TSMATH_INSTRUMENT(cg, 0, 0);
+    Result result = start(A, b, x, options);
+    const size_t n = A.dimension();
+    double *w = workspace.reserve(6 * n);
+    double *bs = w, *xs = w + n, *r = w + 2 * n, *z = w + 3 * n, *p = w + 4 * n, *q = w + 5 * n;
+    gather(b, bs);
+    gather(x, xs);
+    const double bnorm = norm(bs, n);
+    if (solve_zero(bnorm, x, result, options))
+    {
+        return result;
+    }
+
+    residual(A, bs, xs, r, n);
+    M.apply(r, z, n);
+    std::copy_n(z, n, p);
+    double rz = simd::dot(r, z, n);
+    record(result, options, norm(r, n) / bnorm);
+    result.converged = result.residual <= options.tolerance;
+
+    while (!result.converged && result.iterations < options.max_iterations)
+    {
+        A.apply(p, q);
+        const double pq = simd::dot(p, q, n);
+        if (!(pq > 0.0))
+        {
+            // A (or M) is not positive definite along p
+            break;
+        }
+        const double alpha = rz / pq;
+        axpy(alpha, p, xs, n);
+        axpy(-alpha, q, r, n);
+        result.iterations++;
+        record(result, options, norm(r, n) / bnorm);
+        if (result.residual <= options.tolerance)
+        {
+            result.converged = true;
+            break;
+        }
+
+        M.apply(r, z, n);
+        const double rz_next = simd::dot(r, z, n);
+        const double beta = rz_next / rz;
+        rz = rz_next;
+        for (size_t i = 0; i < n; i++)
+        {
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+    scatter(xs, x);
+    return result;
+}
+
+krylov::Result krylov::gmres(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M,
+                             const Options &options, Workspace &workspace)
+{
+    TSMATH_INSTRUMENT(gmres, 0, 0);
+    Result result = start(A, b, x, options);
+    const size_t n = A.dimension(), m = std::max<size_t>(1, options.restart);
+
+    // b, x, u, z, the m + 1 basis vectors, the Hessenberg matrix, the rotations, g and y
+    double *w = workspace.reserve((m + 5) * n + (m + 1) * m + 4 * m + 1);
+    double *bs = w, *xs = w + n, *u = w + 2 * n, *z = w + 3 * n, *V = w + 4 * n;
+    double *H = V + (m + 1) * n, *cs = H + (m + 1) * m, *sn = cs + m, *g = sn + m, *y = g + m + 1;
+    gather(b, bs);
+    gather(x, xs);
+    const double bnorm = norm(bs, n);
+    if (solve_zero(bnorm, x, result, options))
+    {
+        return result;
+    }
+
+    for (bool first = true;; first = false)
+    {
+        // True residual at every restart
+        residual(A, bs, xs, V, n);
+        const double beta = norm(V, n);
+        if (first)
+        {
+            record(result, options, beta / bnorm);
+        }
+        else
+        {
+            result.residual = beta / bnorm;
+        }
+        if (result.residual <= options.tolerance)
+        {
+            result.converged = true;
+            break;
+        }
+        if (result.iterations >= options.max_iterations || beta == 0.0)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            V[i] /= beta;
+        }
+        std::fill_n(g, m + 1, 0.0);
+        g[0] = beta;
+
+        // Arnoldi with modified Gram-Schmidt, the least squares problem kept triangular by Givens rotations
+        size_t k = 0;
+        while (k < m && result.iterations < options.max_iterations)
+        {
+            const size_t j = k;
+            double *v = V + j * n, *next = V + (j + 1) * n;
+            M.apply(v, u, n);
+            A.apply(u, next);
+            for (size_t i = 0; i <= j; i++)
+            {
+                const double h = simd::dot(next, V + i * n, n);
+                H[i * m + j] = h;
+                axpy(-h, V + i * n, next, n);
+            }
+            const double h_next = norm(next, n);
+            if (h_next != 0.0)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    next[i] /= h_next;
+                }
+            }
+
+            for (size_t i = 0; i < j; i++)
+            {
+                const double a = H[i * m + j], c = H[(i + 1) * m + j];
+                H[i * m + j] = cs[i] * a + sn[i] * c;
+                H[(i + 1) * m + j] = -sn[i] * a + cs[i] * c;
+            }
+            const double r = std::hypot(H[j * m + j], h_next);
+            cs[j] = r == 0.0 ? 1.0 : H[j * m + j] / r;
+            sn[j] = r == 0.0 ? 0.0 : h_next / r;
+            H[j * m + j] = r;
+            H[(j + 1) * m + j] = 0.0;
+            g[j + 1] = -sn[j] * g[j];
+            g[j] = cs[j] * g[j];
+
+            k++;
+            result.iterations++;
+            record(result, options, std::abs(g[j + 1]) / bnorm);
+            if (result.residual <= options.tolerance || h_next == 0.0)
+            {
+                break;
+            }
+        }
+
+        // x += M^-1 V y with H y = g
+        for (size_t i = k; i-- > 0;)
+        {
+            double s = g[i];
+            for (size_t c = i + 1; c < k; c++)
+            {
+                s -= H[i * m + c] * y[c];
+            }
+            y[i] = H[i * m + i] == 0.0 ? 0.0 : s / H[i * m + i];
+        }
+        std::fill_n(u, n, 0.0);
+        for (size_t i = 0; i < k; i++)
+        {
+            axpy(y[i], V + i * n, u, n);
+        }
+        M.apply(u, z, n);
+        axpy(1.0, z, xs, n);
+    }
+    scatter(xs, x);
+    return result;
+}
+
+krylov::Result krylov::bicgstab(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M,
+                                const Options &options, Workspace &workspace)
+{
+    TSMATH_INSTRUMENT(bicgstab, 0, 0);
+    Result result = start(A, b, x, options);
+    const size_t n = A.dimension();
+    double *w = workspace.reserve(9 * n);
+    double *bs = w, *xs = w + n, *r = w + 2 * n, *rhat = w + 3 * n, *p = w + 4 * n, *v = w + 5 * n;
+    double *phat = w + 6 * n, *shat = w + 7 * n, *t = w + 8 * n;
+    gather(b, bs);
+    gather(x, xs);
+    const double bnorm = norm(bs, n);
+    if (solve_zero(bnorm, x, result, options))
+    {
+        return result;
+    }
+
+    // (Re)starts the recurrences from the true residual r = b - A x, with r as the shadow vector.
+    // Returns whether x already meets the tolerance.
+    double rho = 0.0;
+    const auto restart = [&]() {
+        residual(A, bs, xs, r, n);
+        result.residual = norm(r, n) / bnorm;
+        std::copy_n(r, n, rhat);
+        std::copy_n(r, n, p);
+        rho = simd::dot(rhat, r, n);
+        return result.residual <= options.tolerance;
+    };
+    result.converged = restart();
+    record(result, options, result.residual);
+
+    while (!result.converged && result.iterations < options.max_iterations && rho != 0.0)
+    {
+        M.apply(p, phat, n);
+        A.apply(phat, v);
+        const double rv = simd::dot(rhat, v, n);
+        if (rv == 0.0)
+        {
+            break;
+        }
+        const double alpha = rho / rv;
+
+        // s = r - alpha v, kept in r
+        axpy(-alpha, v, r, n);
+        axpy(alpha, phat, xs, n);
+        result.iterations++;
+        const double s_norm = norm(r, n) / bnorm;
+        double omega = 0.0;
+        if (s_norm <= options.tolerance)
+        {
+            record(result, options, s_norm);
+        }
+        else
+        {
+            M.apply(r, shat, n);
+            A.apply(shat, t);
+            const double tt = simd::dot(t, t, n);
+            omega = tt == 0.0 ? 0.0 : simd::dot(t, r, n) / tt;
+            axpy(omega, shat, xs, n);
+            axpy(-omega, t, r, n);
+            record(result, options, norm(r, n) / bnorm);
+        }
+
+        // The updated residual drifts from b - A x after large intermediate peaks: convergence is
+        // confirmed on the true residual, and the iteration restarts from it when they disagree
+        if (result.residual <= options.tolerance || omega == 0.0)
+        {
+            result.converged = restart();
+            continue;
+        }
+
+        const double rho_next = simd::dot(rhat, r, n);
+        const double beta = (rho_next / rho) * (alpha / omega);
+        rho = rho_next;
+        for (size_t i = 0; i < n; i++)
+        {
+            p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        }
+    }
+    scatter(xs, x);
+    return result;
+}
+
+krylov::Result krylov::cg(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M,
+                          const Options &options)
+{
+    Workspace workspace;
+    return cg(A, b, x, M, options, workspace);
+}
+
+krylov::Result krylov::gmres(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M,
+                             const Options &options)
+{
+    Workspace workspace;
+    return gmres(A, b, x, M, options, workspace);
+}
+
+krylov::Result krylov::bicgstab(const Operator &A, ConstVectorView b, VectorView x, const Preconditioner &M,
+                                const Options &options)
+{
+    Workspace workspace;
+    return bicgstab(A, b, x, M, options, workspace);
+}
@@ -1,5 +1,8 @@
 #include "../include/lin_alg.h"
+#include "../include/instrument.h"
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
 
 
 
@@ -8,117 +11,185 @@
 // Consider removing conio.h if not used for console input/output
 // #include <conio.h>
 
-// Function to find the degree of the highest non-zero coefficient in a polynomial Vector
-size_t findHighestDegree(const Vector &polynomial, double tolerance = 1e-7)
-{
-    for (size_t i = 0; i < polynomial.dimension(); ++i)
-    {
-        if (std::abs(polynomial[i]) > tolerance)
-        {
-            return polynomial.dimension() - i - 1;
-        }
-    }
-    
-    return -1;
-}
-
-// Function to perform convolution of two Vectors
-Vector TSA::convolution(const Vector &u, const Vector &v, double tolerance)
+// Function to perform convolution of two Vectors (the coefficients of the product of two polynomials)
+Vector TSA::convolution(ConstVectorView u, ConstVectorView v, double tolerance)
 {
     size_t n = u.dimension();
     size_t m = v.dimension();
+    if (n == 0 || m == 0)
+    {
+        return Vector(size_t(0));
+    }
+    // Nominal count of the direct sum, the FFT path does fewer
+    TSMATH_INSTRUMENT(convolution, 2 * n * m, (n + m + (n + m - 1)) * sizeof(double));
 
-    // Result Vector with size n + m initialized to zeros
-    Vector result(n + m, 0.0);
-
-    // Perform element-wise multiplication and accumulation
+    // fft::convolve works on contiguous data
+    std::vector<double> left(n), right(m);
     for (size_t i = 0; i < n; ++i)
     {
-        for (size_t k = 0; k < m; ++k)
-        {
-            result[i + k] += u[i] * v[k];
-        }
+        left[i] = u.coeff(i);
     }
-
-    // Trim leading zeros from the result
-    size_t first = 0;
-    while (std::abs(result[first]) < tolerance && first < result.dimension())
+    for (size_t k = 0; k < m; ++k)
     {
-        result.popFront();
+        right[k] = v.coeff(k);
     }
 
-    // Consider removing trailing zero trimming if not needed
-    result.popBack();
+    // Direct for short inputs, FFT overlap-add past the measured crossover
+    std::vector<double> result(n + m - 1);
+    fft::convolve(left.data(), n, right.data(), m, result.data());
 
-    return result;
+    // Trim leading zeros from the result in one pass, keeping the constant term of a zero polynomial
+    size_t first = 0;
+    while (first + 1 < result.size() && std::abs(result[first]) < tolerance)
+    {
+        ++first;
+    }
+    Vector trimmed(result.size() - first);
+    std::copy(result.begin() + first, result.end(), trimmed.data());
+    return trimmed;
 }
 
-// Function to construct the T Vector used in polynomial division
-Vector constructT(const Vector &quotient, const Vector &divisor)
+namespace
 {
-    size_t n = quotient.dimension() + divisor.dimension() - 1;
-    size_t k = quotient.dimension();
-    size_t l = divisor.dimension();
+    // Smallest quotient chunk of the reciprocal division, so that short divisors still get FFT-sized products.
+    constexpr size_t RECIPROCAL_CHUNK = 1024;
 
-    // T Vector with size n initialized to zeros
-    Vector t(n, 0.0);
+    // Synthetic division in place: on return r[0..k] holds the quotient and r[k+1..] the remainder.
+    // Coefficients are highest degree first and b[0] is the (non-zero) leading coefficient.
+    void synthetic_division(std::vector<double> &r, const double *b, size_t m, size_t k)
+    {
+        const double inverse_lead = 1.0 / b[0];
+        for (size_t i = 0; i <= k; ++i)
+        {
+            const double coefficient = r[i] * inverse_lead;
+            r[i] = coefficient;
+            for (size_t j = 1; j <= m; ++j)
+            {
+                r[i + j] -= coefficient * b[j];
+            }
+        }
+    }
 
-    // Calculate element-wise product of quotient and flipped divisor
-    // (Multiplying with flipped divisor is equivalent to convolution)
-    for (size_t i = 0; i < k; ++i)
+    // First 'count' coefficients of the product of u (n coefficients) and v (m coefficients)
+    std::vector<double> truncated_product(const double *u, size_t n, const double *v, size_t m, size_t count)
     {
-        for (size_t j = 0; j < l; ++j)
+        n = std::min(n, count);
+        m = std::min(m, count);
+        std::vector<double> product(n + m - 1);
+        fft::convolve(u, n, v, m, product.data());
+        product.resize(count, 0.0);
+        return product;
+    }
+
+    // Power series inverse g of b modulo x^count by Newton iteration, g <- g (2 - b g), doubling
+    // the number of correct terms per step. b[0] must be non-zero.
+    std::vector<double> series_inverse(const std::vector<double> &b, size_t count)
+    {
+        std::vector<double> g(1, 1.0 / b[0]);
+        for (size_t terms = 1; terms < count;)
         {
-            t[n - (i + j + 1)] += quotient[k - i - 1] * divisor[l - j - 1];
+            terms = std::min(2 * terms, count);
+            std::vector<double> correction = truncated_product(b.data(), b.size(), g.data(), g.size(), terms);
+            for (double &c : correction)
+            {
+                c = -c;
+            }
+            correction[0] += 2.0;
+            g = truncated_product(g.data(), g.size(), correction.data(), terms, terms);
         }
+        return g;
     }
 
-    return t;
+    // Division through the reciprocal. Read highest degree first, the arrays are the reversed
+    // polynomials and rev(q) = rev(r) / rev(b) mod x^len gives the next len quotient coefficients
+    // of the running remainder r. The quotient is produced 'chunk' coefficients at a time, all
+    // chunks sharing one series inverse, and q_chunk * b is subtracted from r after each; the
+    // layout on return matches synthetic_division.
+    void reciprocal_division(std::vector<double> &r, const std::vector<double> &b, size_t k, size_t chunk)
+    {
+        const std::vector<double> g = series_inverse(b, chunk);
+        std::vector<double> product(chunk + b.size() - 1);
+        for (size_t start = 0; start <= k; start += chunk)
+        {
+            const size_t length = std::min(chunk, k + 1 - start);
+            const std::vector<double> q = truncated_product(r.data() + start, length, g.data(), g.size(), length);
+            fft::convolve(q.data(), length, b.data(), b.size(), product.data());
+            for (size_t t = length; t < length + b.size() - 1; ++t)
+            {
+                r[start + t] -= product[t];
+            }
+            std::copy(q.begin(), q.end(), r.begin() + start);
+        }
+    }
 }
 
-// Function to perform polynomial division
-Vector TSA::polynomial_division(Vector &dividend, const Vector &divisor, double tolerance)
+// Function to perform polynomial division, returning (quotient, remainder)
+std::pair<Vector, Vector> TSA::polynomial_divmod(ConstVectorView dividend, ConstVectorView divisor, double tolerance)
 {
-
-    size_t degreeDividend = findHighestDegree(dividend, tolerance);
-    size_t degreeDivisor = findHighestDegree(divisor, tolerance);
-    size_t degreeQuotient = degreeDividend - degreeDivisor;
-
-    // Quotient Vector with size degreeQuotient + 1 initialized to zeros
-    Vector quotient(degreeQuotient + 1, 0.0);
-
-    DEBUG(std::cout << "Degree of dividend: " << degreeDividend << std::endl;
-    std::cout << "Degree of divisor: " << degreeDivisor << std::endl;
-    std::cout << "Degree of quotient: " << degreeQuotient << std::endl;);
-
-    while (degreeDividend >= degreeDivisor)
+    // Coefficients are stored highest degree first; skip the negligible leading ones
+    size_t firstDividend = 0, firstDivisor = 0;
+    while (firstDivisor < divisor.dimension() && std::abs(divisor[firstDivisor]) <= tolerance)
     {
-        // Calculate coefficient of the current term in the quotient
-        double coefficient = dividend[dividend.dimension() - degreeDividend - 1] /
-                             divisor[divisor.dimension() - 1 - degreeDivisor];
-        quotient[quotient.dimension() - 1 - degreeQuotient] = coefficient;
-
-        DEBUG(std::cout << "Coefficient: " << coefficient << std::endl;
-        std::cout << "Current quotient: ";
-        quotient.print(std::cout););
+        ++firstDivisor;
+    }
+    if (firstDivisor == divisor.dimension())
+    {
+        throw std::domain_error("TSA::polynomial_divmod: division by the zero polynomial");
+    }
+    while (firstDividend < dividend.dimension() && std::abs(dividend[firstDividend]) <= tolerance)
+    {
+        ++firstDividend;
+    }
 
-        // Construct temporary Vector with the coefficient at the appropriate position
-        Vector temp(degreeQuotient + 1, 0.0);
-        temp[temp.dimension() - degreeDividend + degreeDivisor -1] = coefficient;
+    std::vector<double> b(divisor.dimension() - firstDivisor);
+    for (size_t j = 0; j < b.size(); ++j)
+    {
+        b[j] = divisor[firstDivisor + j];
+    }
+    const size_t degreeDivisor = b.size() - 1;
+    const size_t remainderSize = std::max<size_t>(degreeDivisor, 1);
+
+    // Dividend of lower degree than the divisor: the quotient is zero and the dividend is the remainder
+    const size_t dividendSize = dividend.dimension() - firstDividend;
+    TSMATH_INSTRUMENT(polynomial_division, dividendSize > degreeDivisor ? 2 * (dividendSize - degreeDivisor) * b.size() : 0,
+                      (dividendSize + b.size() + dividendSize) * sizeof(double));
+    if (dividendSize <= degreeDivisor)
+    {
+        Vector remainder(remainderSize, 0.0);
+        for (size_t i = 0; i < dividendSize; ++i)
+        {
+            remainder[remainderSize - dividendSize + i] = dividend[firstDividend + i];
+        }
+        return {Vector(1, 0.0), std::move(remainder)};
+    }
 
-        DEBUG(std::cout << "Temporary Vector: ";
-        temp.print(std::cout);)
+    std::vector<double> a(dividendSize);
+    for (size_t i = 0; i < dividendSize; ++i)
+    {
+        a[i] = dividend[firstDividend + i];
+    }
+    const size_t degreeQuotient = dividendSize - 1 - degreeDivisor;
 
-        // Calculate T Vector using constructed temporary Vector and divisor
-        Vector t = constructT(temp, divisor);
+    // Small degrees: O(k * m) synthetic division. Large ones: the quotient in chunks of
+    // max(m + 1, RECIPROCAL_CHUNK) coefficients through the FFT.
+    const size_t chunk = std::min(degreeQuotient + 1, std::max(b.size(), RECIPROCAL_CHUNK));
+    if (fft::prefer_fft(chunk, b.size()))
+    {
+        reciprocal_division(a, b, degreeQuotient, chunk);
+    }
+    else
+    {
+        synthetic_division(a, b.data(), degreeDivisor, degreeQuotient);
+    }
 
-        DEBUG(std::cout << "T Vector: ";
-        t.print(std::cout);)
-        dividend = dividend - t;
+    Vector quotient(degreeQuotient + 1), remainder(remainderSize, 0.0);
+    std::copy(a.begin(), a.begin() + degreeQuotient + 1, quotient.data());
+    std::copy(a.begin() + degreeQuotient + 1, a.end(), remainder.data() + remainderSize - degreeDivisor);
+    return {std::move(quotient), std::move(remainder)};
+}
 
-        degreeDividend--;
-        degreeQuotient--;
-        dividend.popFront();
-    }
-    return quotient;
+// Function to perform polynomial division, returning the quotient
+Vector TSA::polynomial_division(ConstVectorView dividend, ConstVectorView divisor, double tolerance)
+{
+    return polynomial_divmod(dividend, divisor, tolerance).first;
 }
@@ -0,0 +1,864 @@
+#include "../include/lin_alg.h"
+#include "../include/blas.h"
+#include "../include/instrument.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include "../include/triangular.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // Panel width of the blocked factorization.
+    constexpr size_t NB = 64;
+
+    // Trailing updates smaller than this many multiply-adds stay on the calling thread.
+    constexpr size_t PARALLEL_UPDATE = 64 * 64 * 64;
+
+    // Rows handed to one thread when the inverse is formed row by row.
+    constexpr size_t ROW_GRAIN = 64;
+
+    // Refinement steps the mixed-precision gpp allows before falling back (as LAPACK's dsgesv).
+    constexpr size_t REFINEMENT_STEPS = 30;
+
+    // Unblocked LU of the panel A[k:m, k:k+jb] of the m x n matrix at a (float or double); row swaps
+    // are applied to whole rows. Returns false if a zero pivot was met.
+    template <typename T>
+    bool factor_panel(T *a, size_t m, size_t n, size_t lda, size_t k, size_t jb, factorization::Pivoting pivoting,
+                      std::vector<size_t> &pivots)
+    {
+        bool regular = true;
+
+        for (size_t j = k; j < k + jb; j++)
+        {
+            // Find the largest entry of column j on or below the diagonal
+            size_t p = j;
+            if (pivoting == factorization::Pivoting::partial)
+            {
+                T best = std::abs(a[j * lda + j]);
+                for (size_t i = j + 1; i < m; i++)
+                {
+                    T candidate = std::abs(a[i * lda + j]);
+                    if (candidate > best)
+                    {
+                        best = candidate;
+                        p = i;
+                    }
+                }
+            }
+            pivots[j] = p;
+            if (p != j)
+            {
+                std::swap_ranges(a + j * lda, a + j * lda + n, a + p * lda);
+            }
+
+            const T pivot = a[j * lda + j];
+            if (pivot == T(0))
+            {
+                regular = false;
+                for (size_t i = j + 1; i < m; i++)
+                {
+                    if (a[i * lda + j] != T(0))
+                    {
+                        throw std::domain_error("Zero pivot, the factorization needs row pivoting");
+                    }
+                }
+                continue;
+            }
+
+            // Multipliers, then a rank-1 update of the rest of the panel
+            const T *u = a + j * lda;
+            for (size_t i = j + 1; i < m; i++)
+            {
+                T *row = a + i * lda;
+                const T l = row[j] /= pivot;
+                for (size_t c = j + 1; c < k + jb; c++)
+                {
+                    row[c] -= l * u[c];
+                }
+            }
+        }
+        return regular;
+    }
+
+    // A[k:k+jb, k+jb:n] = L11^-1 * A[k:k+jb, k+jb:n] with the unit lower panel diagonal block.
+    template <typename T>
+    void solve_row_panel(T *a, size_t n, size_t lda, size_t k, size_t jb)
+    {
+        for (size_t i = k + 1; i < k + jb; i++)
+        {
+            T *row = a + i * lda;
+            for (size_t p = k; p < i; p++)
+            {
+                const T l = row[p];
+                const T *u = a + p * lda;
+                for (size_t c = k + jb; c < n; c++)
+                {
+                    row[c] -= l * u[c];
+                }
+            }
+        }
+    }
+
+    // A22 -= A21 * A12, split by rows across the thread pool.
+    template <typename T>
+    void update_trailing(T *a, size_t m, size_t n, size_t lda, size_t k, size_t jb)
+    {
+        const size_t rows = m - k - jb, columns = n - k - jb;
+        if (rows == 0 || columns == 0)
+        {
+            return;
+        }
+
+        const T *a21 = a + (k + jb) * lda + k;
+        const T *a12 = a + k * lda + k + jb;
+        T *a22 = a + (k + jb) * lda + k + jb;
+
+        size_t grain = !parallel::worthwhile(rows * columns * jb, PARALLEL_UPDATE) ? rows : NB;
+        parallel::parallel_for(rows, grain, [=](size_t begin, size_t end) {
+            blas::gemm(blas::Op::none, blas::Op::none, end - begin, columns, jb, T(-1),
+                       a21 + begin * lda, lda, a12, lda, T(1), a22 + begin * lda, lda);
+        });
+    }
+
+    // Blocked right-looking LU of the m x n matrix at a in place, min(m, n) pivots. Returns false if a
+    // zero pivot was met.
+    template <typename T>
+    bool factor(T *a, size_t m, size_t n, size_t lda, factorization::Pivoting pivoting, std::vector<size_t> &pivots)
+    {
+        bool regular = true;
+        const size_t steps = pivots.size();
+        for (size_t k = 0; k < steps; k += NB)
+        {
+            const size_t jb = std::min(NB, steps - k);
+            if (!factor_panel(a, m, n, lda, k, jb, pivoting, pivots))
+            {
+                regular = false;
+            }
+            solve_row_panel(a, n, lda, k, jb);
+            update_trailing(a, m, n, lda, k, jb);
+        }
+        return regular;
+    }
+
+    bool factor(MatrixView A, factorization::Pivoting pivoting, std::vector<size_t> &pivots)
+    {
+        return factor(A.data(), A.getRowCount(), A.getColumnCount(), A.stride(), pivoting, pivots);
+    }
+
+    // Overwrites the packed factors of a square, non-singular P A = L U with A^-1: U is inverted in
+    // place, X L = U^-1 is solved for X = (P A)^-1 one block column at a time from the right, and
+    // the row interchanges are undone as column swaps. Needs n x NB scratch.
+    void invert_factors(MatrixView A, const std::vector<size_t> &pivots)
+    {
+        const size_t n = A.getRowCount(), lda = A.stride();
+        double *a = A.data();
+        triangular::invert_upper(A);
+
+        MATRIX W(n, NB);
+        double *w = W.data();
+        const size_t ldw = W.stride();
+        for (size_t panels = (n + NB - 1) / NB; panels-- > 0;)
+        {
+            const size_t j = panels * NB, jb = std::min(NB, n - j), after = j + jb;
+
+            // W = the block column's part of L, zeroed in A so that only U^-1 remains there
+            for (size_t i = j; i < n; i++)
+            {
+                for (size_t c = 0; c < jb; c++)
+                {
+                    double &entry = a[i * lda + j + c];
+                    w[i * ldw + c] = i > j + c ? entry : 0.0;
+                    if (i > j + c)
+                    {
+                        entry = 0.0;
+                    }
+                }
+            }
+
+            // X(:, j:j+jb) = (U^-1(:, j:j+jb) - X(:, j+jb:n) L(j+jb:n, j:j+jb)) L(j:j+jb, j:j+jb)^-1
+            if (after < n)
+            {
+                blas::parallel_gemm(blas::Op::none, blas::Op::none, n, jb, n - after, -1.0, a + after, lda,
+                                    w + after * ldw, ldw, 1.0, a + j, lda);
+            }
+            parallel::parallel_for(n, ROW_GRAIN, [=](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; r++)
+                {
+                    double *x = a + r * lda + j;
+                    for (size_t c = jb; c-- > 0;)
+                    {
+                        double sum = x[c];
+                        for (size_t p = c + 1; p < jb; p++)
+                        {
+                            sum -= x[p] * w[(j + p) * ldw + c];
+                        }
+                        x[c] = sum;
+                    }
+                }
+            });
+        }
+
+        // A^-1 = (P A)^-1 P: the interchanges are applied to the columns, last to first
+        const size_t *pivot = pivots.data();
+        parallel::parallel_for(n, ROW_GRAIN, [=](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++)
+            {
+                double *row = a + r * lda;
+                for (size_t i = n; i-- > 0;)
+                {
+                    std::swap(row[i], row[pivot[i]]);
+                }
+            }
+        });
+    }
+
+    // Blocked right-looking Cholesky factorization A = U^T U in place, reading and writing only the
+    // upper triangle. Returns false when a pivot is not positive, i.e. A is not positive definite.
+    bool factor_cholesky(MatrixView A)
+    {
+        const size_t n = A.getRowCount(), lda = A.stride();
+        double *a = A.data();
+        for (size_t k = 0; k < n; k += NB)
+        {
+            const size_t jb = std::min(NB, n - k), after = k + jb;
+
+            // Rows k..k+jb of U: each row is scaled by its pivot and folded into the panel rows below it
+            for (size_t j = k; j < after; j++)
+            {
+                double *row = a + j * lda;
+                if (!(row[j] > 0.0))
+                {
+                    return false;
+                }
+                const double pivot = std::sqrt(row[j]);
+                row[j] = pivot;
+                for (size_t c = j + 1; c < n; c++)
+                {
+                    row[c] /= pivot;
+                }
+                for (size_t i = j + 1; i < after; i++)
+                {
+                    const double u = row[i];
+                    double *target = a + i * lda;
+                    for (size_t c = i; c < n; c++)
+                    {
+                        target[c] -= u * row[c];
+                    }
+                }
+            }
+
+            // A22 -= U12^T U12 on the upper triangle, one band of NB rows per task
+            if (after < n)
+            {
+                const size_t rest = n - after, bands = (rest + NB - 1) / NB;
+                const double *u12 = a + k * lda;
+                const size_t grain = !parallel::worthwhile(rest * rest * jb, 2 * PARALLEL_UPDATE) ? bands : 1;
+                parallel::parallel_for(bands, grain, [=](size_t begin, size_t end) {
+                    for (size_t band = begin; band < end; band++)
+                    {
+                        const size_t first = after + band * NB, last = std::min(n, first + NB);
+                        blas::gemm(blas::Op::transpose, blas::Op::none, last - first, n - first, jb, -1.0, u12 + first,
+                                   lda, u12 + first, lda, 1.0, a + first * lda + first, lda);
+                    }
+                });
+            }
+        }
+        return true;
+    }
+
+    // Overwrites the Cholesky factor U (upper triangle) with the full symmetric A^-1 = U^-1 U^-T.
+    // Block column k of A^-1 below the diagonal is one product of rows of U^-1 that are never
+    // needed again, so it is written straight into the lower triangle, then mirrored.
+    void invert_cholesky(MatrixView A)
+    {
+        const size_t n = A.getRowCount(), lda = A.stride();
+        double *a = A.data();
+        for (size_t i = 0; i < n; i++)
+        {
+            std::fill_n(a + i * lda, i, 0.0);
+        }
+        triangular::invert_upper(A);
+
+        MATRIX T(n, NB);
+        const size_t ldt = T.stride();
+        for (size_t k = 0; k < n; k += NB)
+        {
+            const size_t jb = std::min(NB, n - k);
+            double *block = a + k * lda + k;
+            blas::parallel_gemm(blas::Op::none, blas::Op::transpose, n - k, jb, n - k, 1.0, block, lda, block, lda, 0.0,
+                                T.data(), ldt);
+            for (size_t r = 0; r < n - k; r++)
+            {
+                std::copy_n(T.data() + r * ldt, std::min(r + 1, jb), block + r * lda);
+            }
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = i + 1; j < n; j++)
+            {
+                a[i * lda + j] = a[j * lda + i];
+            }
+        }
+    }
+
+    // sign * prod_i d_i^power over the n diagonal entries at a (rows lda apart), renormalized as it
+    // goes so that partial products neither overflow nor underflow.
+    double diagonal_product(const double *a, size_t lda, size_t n, double sign, int power)
+    {
+        double mantissa = sign;
+        long exponent = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (int p = 0; p < power; p++)
+            {
+                int e;
+                mantissa = std::frexp(mantissa * a[i * lda + i], &e);
+                exponent += e;
+            }
+        }
+        exponent = std::max<long>(std::min<long>(exponent, INT_MAX), INT_MIN);
+        return std::ldexp(mantissa, static_cast<int>(exponent));
+    }
+
+    // (sign, log|prod_i d_i^power|) over the same diagonal; (0, -inf) when an entry is zero.
+    std::pair<double, double> diagonal_log_product(const double *a, size_t lda, size_t n, double sign, int power)
+    {
+        double log = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            const double d = a[i * lda + i];
+            if (d == 0.0)
+            {
+                return std::make_pair(0.0, -std::numeric_limits<double>::infinity());
+            }
+            log += power * std::log(std::abs(d));
+            if (d < 0.0 && power % 2 == 1)
+            {
+                sign = -sign;
+            }
+        }
+        return std::make_pair(sign, log);
+    }
+
+    void require_square(ConstMatrixView A, const char *message)
+    {
+        if (A.getRowCount() != A.getColumnCount())
+        {
+            throw std::invalid_argument(message);
+        }
+    }
+
+    // Shapes of a triangular system A X = B, and no zero on the diagonal of A.
+    void require_triangular_system(ConstMatrixView A, ConstMatrixView B)
+    {
+        require_square(A, "Triangular solve needs a square matrix");
+        if (B.getRowCount() != A.getRowCount())
+        {
+            throw std::invalid_argument("Right-hand side does not match the matrix size");
+        }
+        for (size_t i = 0; i < A.getRowCount(); i++)
+        {
+            if (A(i, i) == 0.0)
+            {
+                throw std::domain_error("Matrix is singular");
+            }
+        }
+    }
+
+    // Float32 LU of a square A for the mixed-precision gpp, rows padded to 64 bytes, and ||A||_inf.
+    struct SingleFactors
+    {
+        BasicAlignedBuffer<float> a;
+        size_t lda = 0;
+        std::vector<size_t> pivots;
+        double norm = 0.0;
+    };
+
+    // Rounds A to float32 and factorizes it. Returns false when an entry does not fit the float range
+    // or the float32 factors came out singular or overflowed: the caller then falls back to float64.
+    bool factor_single(ConstMatrixView A, SingleFactors &f)
+    {
+        const size_t n = A.getRowCount();
+        f.lda = (n + 15) / 16 * 16;
+        f.a = BasicAlignedBuffer<float>(n * f.lda);
+        f.pivots.assign(n, 0);
+        float *a = f.a.data();
+        for (size_t i = 0; i < n; i++)
+        {
+            double row_sum = 0.0;
+            for (size_t j = 0; j < n; j++)
+            {
+                const double entry = A(i, j);
+                if (!(std::abs(entry) <= std::numeric_limits<float>::max()))
+                {
+                    return false;
+                }
+                a[i * f.lda + j] = static_cast<float>(entry);
+                row_sum += std::abs(entry);
+            }
+            f.norm = std::max(f.norm, row_sum);
+        }
+
+        if (!factor(a, n, n, f.lda, factorization::Pivoting::partial, f.pivots))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!std::isfinite(a[i * f.lda + i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // x = A^-1 x through the float32 factors, the substitutions done in float32 on a rounded copy.
+    void solve_single(const SingleFactors &f, double *x, std::vector<float> &y)
+    {
+        const size_t n = f.pivots.size(), lda = f.lda;
+        const float *a = f.a.data();
+        std::copy_n(x, n, y.data());
+        for (size_t i = 0; i < n; i++)
+        {
+            std::swap(y[i], y[f.pivots[i]]);
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            float sum = y[i];
+            for (size_t p = 0; p < i; p++)
+            {
+                sum -= a[i * lda + p] * y[p];
+            }
+            y[i] = sum;
+        }
+        for (size_t i = n; i-- > 0;)
+        {
+            float sum = y[i];
+            for (size_t p = i + 1; p < n; p++)
+            {
+                sum -= a[i * lda + p] * y[p];
+            }
+            y[i] = sum / a[i * lda + i];
+        }
+        std::copy_n(y.data(), n, x);
+    }
+
+    // Solves A x = b from the float32 factors of A, then refines x += A^-1 r with the float64
+    // residual r = b - A x until ||r|| <= sqrt(n) eps ||A|| ||x|| (infinity norms, the stopping test
+    // of LAPACK's dsgesv), i.e. until x is as good as a float64 solve. Every step must at least halve
+    // the residual: otherwise cond(A) is too large for the float32 factors and false is returned.
+    bool solve_mixed(ConstMatrixView A, ConstVectorView b, Vector &x)
+    {
+        SingleFactors f;
+        if (!factor_single(A, f))
+        {
+            return false;
+        }
+
+        const size_t n = A.getRowCount();
+        const double tolerance = std::sqrt(static_cast<double>(n)) * std::numeric_limits<double>::epsilon() * f.norm;
+        std::vector<float> y(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            x[i] = b.coeff(i);
+        }
+        solve_single(f, x.data(), y);
+
+        Vector r(n);
+        double previous = std::numeric_limits<double>::infinity();
+        for (size_t step = 0; step <= REFINEMENT_STEPS; step++)
+        {
+            const double *a = A.data(), *xs = x.data();
+            double *rs = r.data();
+            const size_t lda = A.stride();
+            parallel::parallel_for(n, ROW_GRAIN, [=, &b](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    rs[i] = b.coeff(i) - simd::dot(a + i * lda, xs, n);
+                }
+            });
+
+            double norm_r = 0.0, norm_x = 0.0;
+            for (size_t i = 0; i < n; i++)
+            {
+                norm_r = std::max(norm_r, std::abs(r[i]));
+                norm_x = std::max(norm_x, std::abs(x[i]));
+            }
+            if (!std::isfinite(norm_r) || !std::isfinite(norm_x))
+            {
+                return false;
+            }
+            if (norm_r <= tolerance * norm_x)
+            {
+                return true;
+            }
+            if (step == REFINEMENT_STEPS || norm_r > 0.5 * previous)
+            {
+                return false;
+            }
+            previous = norm_r;
+
+            solve_single(f, r.data(), y);
+            for (size_t i = 0; i < n; i++)
+            {
+                x[i] += r[i];
+            }
+        }
+        return false;
+    }
+}
+
+factorization::LU::LU(ConstMatrixView A, Pivoting pivoting)
+    : m_factors(A), m_pivots(std::min(A.getRowCount(), A.getColumnCount())), m_singular(false)
+{
+    [[maybe_unused]] const size_t m = A.getRowCount(), n = A.getColumnCount(), p = m_pivots.size();
+    TSMATH_INSTRUMENT(lu, 2 * m * n * p - (m + n) * p * p + 2 * p * p * p / 3, 2 * m * n * sizeof(double));
+    m_singular = !factor(m_factors, pivoting, m_pivots);
+}
+
+size_t factorization::LU::getRowCount() const noexcept
+{
+    return m_factors.getRowCount();
+}
+
+size_t factorization::LU::getColumnCount() const noexcept
+{
+    return m_factors.getColumnCount();
+}
+
+bool factorization::LU::is_singular() const noexcept
+{
+    return m_singular;
+}
+
+const MATRIX &factorization::LU::packed() const noexcept
+{
+    return m_factors;
+}
+
+const std::vector<size_t> &factorization::LU::pivots() const noexcept
+{
+    return m_pivots;
+}
+
+MATRIX factorization::LU::lower() const
+{
+    const size_t m = getRowCount(), r = m_pivots.size();
+    MATRIX L(m, r);
+    for (size_t i = 0; i < m; i++)
+    {
+        for (size_t j = 0; j < std::min(i, r); j++)
+        {
+            L(i, j) = m_factors(i, j);
+        }
+        if (i < r)
+        {
+            L(i, i) = 1.0;
+        }
+    }
+    return L;
+}
+
+MATRIX factorization::LU::upper() const
+{
+    const size_t n = getColumnCount(), r = m_pivots.size();
+    MATRIX U(r, n);
+    for (size_t i = 0; i < r; i++)
+    {
+        for (size_t j = i; j < n; j++)
+        {
+            U(i, j) = m_factors(i, j);
+        }
+    }
+    return U;
+}
+
+Vector factorization::LU::solve(ConstVectorView b) const
+{
+    Vector x = b;
+    solve_in_place(MatrixView(x.data(), x.dimension(), 1, 1));
+    return x;
+}
+
+void factorization::LU::solve_in_place(MatrixView B) const
+{
+    const size_t n = getRowCount();
+    TSMATH_INSTRUMENT(lu_solve, 2 * n * n * B.getColumnCount(), (n * n + 2 * n * B.getColumnCount()) * sizeof(double));
+    if (n != getColumnCount())
+    {
+        throw std::invalid_argument("LU solve needs a square matrix");
+    }
+    if (B.getRowCount() != n)
+    {
+        throw std::invalid_argument("Right-hand side does not match the matrix size");
+    }
+    if (m_singular)
+    {
+        throw std::domain_error("Matrix is singular");
+    }
+
+    const size_t nrhs = B.getColumnCount(), ldb = B.stride();
+    double *b = B.data();
+
+    // P B
+    for (size_t i = 0; i < n; i++)
+    {
+        if (m_pivots[i] != i)
+        {
+            std::swap_ranges(b + i * ldb, b + i * ldb + nrhs, b + m_pivots[i] * ldb);
+        }
+    }
+
+    // L Y = P B, then U X = Y
+    triangular::solve(triangular::Uplo::lower, blas::Op::none, triangular::Diag::unit, m_factors, B);
+    triangular::solve(triangular::Uplo::upper, blas::Op::none, triangular::Diag::non_unit, m_factors, B);
+}
+
+double factorization::LU::determinant() const
+{
+    require_square(m_factors, "Determinant needs a square matrix");
+    if (m_singular)
+    {
+        return 0.0;
+    }
+    double sign = 1.0;
+    for (size_t i = 0; i < m_pivots.size(); i++)
+    {
+        if (m_pivots[i] != i)
+        {
+            sign = -sign;
+        }
+    }
+    return diagonal_product(m_factors.data(), m_factors.stride(), m_pivots.size(), sign, 1);
+}
+
+std::pair<double, double> factorization::LU::slogdet() const
+{
+    require_square(m_factors, "Determinant needs a square matrix");
+    double sign = 1.0;
+    for (size_t i = 0; i < m_pivots.size(); i++)
+    {
+        if (m_pivots[i] != i)
+        {
+            sign = -sign;
+        }
+    }
+    return diagonal_log_product(m_factors.data(), m_factors.stride(), m_pivots.size(), sign, 1);
+}
+
+MATRIX factorization::LU::inverse() const
+{
+    [[maybe_unused]] const size_t n = m_factors.getRowCount();
+    TSMATH_INSTRUMENT(inverse, 4 * n * n * n / 3, 2 * n * n * sizeof(double));
+    require_square(m_factors, "Only square matrices have an inverse");
+    if (m_singular)
+    {
+        throw std::domain_error("Matrix is singular");
+    }
+    MATRIX X(m_factors);
+    invert_factors(X, m_pivots);
+    return X;
+}
+
+Vector lin_systems::gpp(ConstMatrixView A, ConstVectorView b, Precision precision)
+{
+    const size_t n = A.getRowCount();
+    TSMATH_INSTRUMENT(gpp, 2 * n * n * n / 3 + 2 * n * n, (2 * n * n + 2 * n) * sizeof(double));
+    if (precision == Precision::mixed && n == A.getColumnCount() && b.dimension() == n)
+    {
+        Vector x(n);
+        if (solve_mixed(A, b, x))
+        {
+            return x;
+        }
+    }
+    // Also reports the shape errors
+    return factorization::LU(A).solve(b);
+}
+
+Vector lin_systems::ltris(ConstMatrixView A, ConstVectorView b)
+{
+    Vector x = b;
+    ltris_in_place(A, MatrixView(x.data(), x.dimension(), 1, 1));
+    return x;
+}
+
+Vector lin_systems::utris(ConstMatrixView A, ConstVectorView b)
+{
+    Vector x = b;
+    utris_in_place(A, MatrixView(x.data(), x.dimension(), 1, 1));
+    return x;
+}
+
+void lin_systems::ltris_in_place(ConstMatrixView A, MatrixView B)
+{
+    require_triangular_system(A, B);
+    triangular::solve(triangular::Uplo::lower, blas::Op::none, triangular::Diag::non_unit, A, B);
+}
+
+void lin_systems::utris_in_place(ConstMatrixView A, MatrixView B)
+{
+    require_triangular_system(A, B);
+    triangular::solve(triangular::Uplo::upper, blas::Op::none, triangular::Diag::non_unit, A, B);
+}
+
+std::pair<MATRIX, MATRIX> factorization::doolittle(ConstMatrixView A)
+{
+    LU lu(A, Pivoting::none);
+    return std::make_pair(lu.lower(), lu.upper());
+}
+
+std::pair<MATRIX, MATRIX> factorization::crout(ConstMatrixView A)
+{
+    // A = (L D)(D^-1 U): move the diagonal of Doolittle's U onto L
+    LU lu(A, Pivoting::none);
+    if (lu.is_singular())
+    {
+        throw std::domain_error("Crout factorization needs a non-singular leading block");
+    }
+    MATRIX L = lu.lower();
+    MATRIX U = lu.upper();
+    for (size_t j = 0; j < U.getRowCount(); j++)
+    {
+        const double d = U(j, j);
+        for (size_t i = j; i < L.getRowCount(); i++)
+        {
+            L(i, j) *= d;
+        }
+        for (size_t c = j; c < U.getColumnCount(); c++)
+        {
+            U(j, c) /= d;
+        }
+    }
+    return std::make_pair(L, U);
+}
+
+factorization::Cholesky::Cholesky(ConstMatrixView A) : m_factors(A)
+{
+    [[maybe_unused]] const size_t n = A.getRowCount();
+    TSMATH_INSTRUMENT(cholesky, n * n * n / 3, 2 * n * n * sizeof(double));
+    require_square(A, "Cholesky factorization needs a square matrix");
+    if (!factor_cholesky(m_factors))
+    {
+        throw std::domain_error("Matrix is not positive definite");
+    }
+    for (size_t i = 0; i < m_factors.getRowCount(); i++)
+    {
+        std::fill_n(m_factors.data() + i * m_factors.stride(), i, 0.0);
+    }
+}
+
+size_t factorization::Cholesky::getRowCount() const noexcept
+{
+    return m_factors.getRowCount();
+}
+
+size_t factorization::Cholesky::getColumnCount() const noexcept
+{
+    return m_factors.getColumnCount();
+}
+
+const MATRIX &factorization::Cholesky::upper() const noexcept
+{
+    return m_factors;
+}
+
+MATRIX factorization::Cholesky::lower() const
+{
+    return m_factors.transpose();
+}
+
+double factorization::Cholesky::determinant() const
+{
+    return diagonal_product(m_factors.data(), m_factors.stride(), m_factors.getRowCount(), 1.0, 2);
+}
+
+std::pair<double, double> factorization::Cholesky::slogdet() const
+{
+    return diagonal_log_product(m_factors.data(), m_factors.stride(), m_factors.getRowCount(), 1.0, 2);
+}
+
+MATRIX factorization::Cholesky::inverse() const
+{
+    [[maybe_unused]] const size_t n = m_factors.getRowCount();
+    TSMATH_INSTRUMENT(inverse, 2 * n * n * n / 3, 2 * n * n * sizeof(double));
+    MATRIX X(m_factors);
+    invert_cholesky(X);
+    return X;
+}
+
+Vector factorization::Cholesky::solve(ConstVectorView b) const
+{
+    Vector x = b;
+    solve_in_place(MatrixView(x.data(), x.dimension(), 1, 1));
+    return x;
+}
+
+void factorization::Cholesky::solve_in_place(MatrixView B) const
+{
+    const size_t n = getRowCount();
+    TSMATH_INSTRUMENT(cholesky_solve, 2 * n * n * B.getColumnCount(), (n * n + 2 * n * B.getColumnCount()) * sizeof(double));
+    if (B.getRowCount() != n)
+    {
+        throw std::invalid_argument("Right-hand side does not match the matrix size");
+    }
+
+    // U^T Y = B, then U X = Y
+    triangular::solve(triangular::Uplo::upper, blas::Op::transpose, triangular::Diag::non_unit, m_factors, B);
+    triangular::solve(triangular::Uplo::upper, blas::Op::none, triangular::Diag::non_unit, m_factors, B);
+}
+
+MATRIX lin_systems::inverse(ConstMatrixView A, factorization::Structure structure)
+{
+    MATRIX X(A);
+    invert_in_place(X, structure);
+    return X;
+}
+
+void lin_systems::invert_in_place(MatrixView A, factorization::Structure structure)
+{
+    require_square(A, "Only square matrices have an inverse");
+    [[maybe_unused]] const size_t n = A.getRowCount();
+    TSMATH_INSTRUMENT(inverse, (structure == factorization::Structure::spd ? 1 : 2) * n * n * n, 2 * n * n * sizeof(double));
+    if (structure == factorization::Structure::spd)
+    {
+        if (!factor_cholesky(A))
+        {
+            throw std::domain_error("Matrix is not positive definite");
+        }
+        invert_cholesky(A);
+        return;
+    }
+
+    std::vector<size_t> pivots(A.getRowCount());
+    if (!factor(A, factorization::Pivoting::partial, pivots))
+    {
+        throw std::domain_error("Matrix is singular");
+    }
+    invert_factors(A, pivots);
+}
+
+double eigen::determinant(ConstMatrixView A, factorization::Structure structure)
+{
+    require_square(A, "Determinant needs a square matrix");
+    if (structure == factorization::Structure::spd)
+    {
+        return factorization::Cholesky(A).determinant();
+    }
+    return factorization::LU(A).determinant();
+}
+
+std::pair<double, double> eigen::slogdet(ConstMatrixView A, factorization::Structure structure)
+{
+    require_square(A, "Determinant needs a square matrix");
+    if (structure == factorization::Structure::spd)
+    {
+        return factorization::Cholesky(A).slogdet();
+    }
+    return factorization::LU(A).slogdet();
+}
@@ -1,42 +1,202 @@
 #include "../include/matrix.h"
-#include <conio.h>
-MATRIX::MATRIX(const std::vector<std::vector<double>> &buffer) : m_components(buffer)
+#include "../include/arena.h"
+#include "../include/blas.h"
+#include "../include/instrument.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace
 {
-    // Set the row count of the matrix
-    row_count = m_components.size();
-    // Set the column count of the matrix (0 if buffer is empty)
-    column_count = m_components.size() == 0 ? 0 : buffer[0].size();
+    // Runs band(begin, end) over the rows of a rows x columns operation, split across the pool
+    // once it is large enough.
+    template <typename Band>
+    void for_row_bands(size_t rows, size_t columns, const Band &band)
+    {
+        if (parallel::worthwhile(rows * columns, expr::PARALLEL_ELEMENTS))
+        {
+            parallel::parallel_for(rows, expr::row_grain(columns), band);
+        }
+        else
+        {
+            band(0, rows);
+        }
+    }
+
+    // Y += alpha X and X *= alpha on whole matrices: the BLAS-1 kernels for double, row loops the
+    // compiler vectorises for float (blas.h is double only)
+    void axpy(double alpha, const MATRIX &X, MATRIX &Y)
+    {
+        blas::axpy(alpha, X, Y);
+    }
+
+    void axpy(double alpha, const BasicMatrix<float> &X, BasicMatrix<float> &Y)
+    {
+        if (X.getRowCount() != Y.getRowCount() || X.getColumnCount() != Y.getColumnCount())
+        {
+            throw std::invalid_argument("Matrix shapes differ in axpy");
+        }
+        const float a = static_cast<float>(alpha);
+        for_row_bands(Y.getRowCount(), Y.getColumnCount(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                const float *x = X.data() + i * X.stride();
+                float *y = Y.data() + i * Y.stride();
+                for (size_t j = 0; j < Y.getColumnCount(); j++)
+                {
+                    y[j] += a * x[j];
+                }
+            }
+        });
+    }
+
+    void scal(double alpha, MATRIX &X)
+    {
+        blas::scal(alpha, X);
+    }
+
+    void scal(double alpha, BasicMatrix<float> &X)
+    {
+        const float a = static_cast<float>(alpha);
+        for_row_bands(X.getRowCount(), X.getColumnCount(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                float *x = X.data() + i * X.stride();
+                for (size_t j = 0; j < X.getColumnCount(); j++)
+                {
+                    x[j] *= a;
+                }
+            }
+        });
+    }
+}
+
+template <typename T>
+size_t BasicMatrix<T>::padded_stride(size_t column_count) noexcept
+{
+    // Padding a row narrower than a line would multiply the footprint of tall, thin matrices
+    constexpr size_t line = BasicAlignedBuffer<T>::alignment / sizeof(T);
+    return column_count < line ? column_count : (column_count + line - 1) / line * line;
 }
 
-MATRIX::MATRIX(std::vector<std::vector<double>> &&buffer) : m_components(buffer)
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const std::vector<std::vector<T>> &buffer)
 {
     // Set the row count of the matrix
-    row_count = m_components.size();
+    row_count = buffer.size();
     // Set the column count of the matrix (0 if buffer is empty)
-    column_count = m_components.size() == 0 ? 0 : buffer[0].size();
+    column_count = buffer.size() == 0 ? 0 : buffer[0].size();
+
+    m_stride = padded_stride(column_count);
+    m_buffer = BasicAlignedBuffer<T>(row_count * m_stride);
+
+    // Import every row into the contiguous storage, rejecting ragged input
+    for (size_t i = 0; i < row_count; i++)
+    {
+        if (buffer[i].size() != column_count)
+        {
+            throw -1;
+        }
+        std::copy(buffer[i].begin(), buffer[i].end(), m_buffer.data() + i * m_stride);
+    }
 }
 
-MATRIX::MATRIX(const MATRIX &other)
+template <typename T>
+BasicMatrix<T>::BasicMatrix(std::vector<std::vector<T>> &&buffer)
+    : BasicMatrix(static_cast<const std::vector<std::vector<T>> &>(buffer))
 {
-    // Initialize the matrix components with appropriate dimensions
-    m_components = std::vector<std::vector<double>>(
-        other.getRowCount(), std::vector<double>(other.getRowCount() == 0 ? 0 : other.m_components[0].size(), 0.0));
+    // The nested rows cannot be adopted by the contiguous storage, release them eagerly
+    std::vector<std::vector<T>>().swap(buffer);
+}
 
-    row_count = m_components.size();
+template <typename T>
+BasicMatrix<T>::BasicMatrix(std::initializer_list<std::initializer_list<T>> rows)
+{
+    row_count = rows.size();
+    column_count = rows.size() == 0 ? 0 : rows.begin()->size();
 
-    column_count = m_components.size() == 0 ? 0 : m_components[0].size();
+    m_stride = padded_stride(column_count);
+    m_buffer = BasicAlignedBuffer<T>(row_count * m_stride);
 
-    // Perform element-wise copy from 'other' matrix to the new matrix
-    for (size_t i = 0; i < other.getRowCount(); i++)
+    size_t i = 0;
+    for (const auto &row : rows)
     {
-        for (size_t j = 0; j < other.getColumnCount(); j++)
+        if (row.size() != column_count)
         {
-            m_components[i][j] = other.m_components[i][j];
+            throw -1;
         }
+        std::copy(row.begin(), row.end(), m_buffer.data() + i++ * m_stride);
     }
 }
 
-MATRIX &MATRIX::operator=(MATRIX &other)
+template <typename T>
+BasicMatrix<T>::BasicMatrix(size_t row_count, size_t column_count, T initialValue)
+    : BasicMatrix(row_count, column_count, initialValue, memory::current_resource())
+{
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(size_t row_count, size_t column_count, T initialValue,
+                            std::pmr::memory_resource *resource)
+    : m_buffer(row_count * padded_stride(column_count), resource), column_count(column_count), row_count(row_count),
+      m_stride(padded_stride(column_count))
+{
+    if (initialValue != T(0))
+    {
+        for (size_t i = 0; i < row_count; i++)
+        {
+            std::fill_n(m_buffer.data() + i * m_stride, column_count, initialValue);
+        }
+    }
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const std::string &path)
+{
+    // Always writable pages, a matrix hands out mutable elements
+    binary::MappedFile file(path, binary::Access::copy_on_write);
+    row_count = file.header().rows;
+    column_count = file.header().columns;
+    m_stride = padded_stride(column_count);
+    if constexpr (std::is_same<T, double>::value)
+    {
+        if (file.header().stride == m_stride && file.header().data_offset % AlignedBuffer::alignment == 0 &&
+            row_count * m_stride != 0)
+        {
+            // Rows are already padded like ours, the mapping becomes the storage
+            m_buffer = binary::adopt(std::move(file));
+            return;
+        }
+    }
+
+    // Files hold doubles, a float matrix rounds them on the way in
+    const ConstMatrixView source = file.matrix();
+    m_buffer = BasicAlignedBuffer<T>(row_count * m_stride);
+    for (size_t i = 0; i < row_count; i++)
+    {
+        std::copy_n(source.data() + i * source.stride(), column_count, m_buffer.data() + i * m_stride);
+    }
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(const BasicMatrix &other)
+    : m_buffer(other.m_buffer), column_count(other.column_count), row_count(other.row_count), m_stride(other.m_stride)
+{
+}
+
+template <typename T>
+BasicMatrix<T>::BasicMatrix(BasicMatrix &&other) noexcept
+    : m_buffer(std::move(other.m_buffer)), column_count(other.column_count), row_count(other.row_count),
+      m_stride(other.m_stride)
+{
+    other.row_count = other.column_count = other.m_stride = 0;
+}
+
+template <typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator=(const BasicMatrix &other)
 {
     // Check for self-assignment
     if (this == &other)
@@ -44,32 +204,87 @@ MATRIX &MATRIX::operator=(MATRIX &other)
         return *this;
     }
 
-    size_t n = other.m_components.size();
-    size_t m = n == 0 ? 0 : other.m_components[0].size();
-    // Resize current vector if dimensions differ
-    m_components.resize(n);
+    // A single block copy, the buffer is only reallocated if its size differs
+    m_buffer = other.m_buffer;
+    row_count = other.row_count;
+    column_count = other.column_count;
+    m_stride = other.m_stride;
 
-    // Perform element-wise copy
-    for (size_t i = 0; i < n; ++i)
+    return *this;
+}
+
+template <typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator=(BasicMatrix &&other)
+{
+    if (this == &other)
     {
-        m_components[i].resize(m);
-        for (size_t j = 0; j < m; j++)
-        {
-            m_components[i][j] = other.m_components[i][j];
-        }
+        return *this;
+    }
+
+    // A block from another resource stays there, this matrix keeps allocating from its own
+    if (!m_buffer.resource()->is_equal(*other.m_buffer.resource()))
+    {
+        *this = static_cast<const BasicMatrix &>(other);
     }
+    else
+    {
+        m_buffer = std::move(other.m_buffer);
+        row_count = other.row_count;
+        column_count = other.column_count;
+        m_stride = other.m_stride;
+    }
+    other.m_buffer = BasicAlignedBuffer<T>(0, other.m_buffer.resource());
+    other.row_count = other.column_count = other.m_stride = 0;
+    return *this;
+}
+
+template <typename T>
+BasicMatrix<T>::~BasicMatrix() = default;
+
+template <typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator+=(const BasicMatrix &other)
+{
+    TSMATH_INSTRUMENT(matrix_axpy, 2 * row_count * column_count, 3 * row_count * column_count * sizeof(T));
+    axpy(1.0, other, *this);
+    return *this;
+}
 
+template <typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator-=(const BasicMatrix &other)
+{
+    TSMATH_INSTRUMENT(matrix_axpy, 2 * row_count * column_count, 3 * row_count * column_count * sizeof(T));
+    axpy(-1.0, other, *this);
     return *this;
 }
 
-MATRIX::~MATRIX()
+template <typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator+=(const expr::MatrixScaled<BasicMatrix> &other)
 {
-    m_components.clear();
+    TSMATH_INSTRUMENT(matrix_axpy, 2 * row_count * column_count, 3 * row_count * column_count * sizeof(T));
+    axpy(other.scalar(), other.operand_expression(), *this);
+    return *this;
 }
 
-Vector &MATRIX::get_row(int row_index)
+template <typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator-=(const expr::MatrixScaled<BasicMatrix> &other)
 {
-    size_t n = m_components.size();
+    TSMATH_INSTRUMENT(matrix_axpy, 2 * row_count * column_count, 3 * row_count * column_count * sizeof(T));
+    axpy(-other.scalar(), other.operand_expression(), *this);
+    return *this;
+}
+
+template <typename T>
+BasicMatrix<T> &BasicMatrix<T>::operator*=(double scalar)
+{
+    TSMATH_INSTRUMENT(matrix_scale, row_count * column_count, 2 * row_count * column_count * sizeof(T));
+    scal(scalar, *this);
+    return *this;
+}
+
+template <typename T>
+BasicVectorView<T> BasicMatrix<T>::get_row(int row_index)
+{
+    size_t n = row_count;
     bool index_is_valid = std::abs(row_index) < n;
 
     if (!index_is_valid)
@@ -77,14 +292,13 @@ Vector &MATRIX::get_row(int row_index)
         throw -1;
     }
 
-    auto result = std::vector<double>(m_components.at(row_index <0 ? n+row_index : row_index));
-
-    return *new Vector(std::move(result));
+    return BasicVectorView<T>(data() + (row_index < 0 ? n + row_index : row_index) * m_stride, column_count, 1);
 }
 
-const Vector &MATRIX::get_row_const(int row_index) const
+template <typename T>
+BasicConstVectorView<T> BasicMatrix<T>::get_row_const(int row_index) const
 {
-    size_t n = m_components.size();
+    size_t n = row_count;
     bool index_is_valid = std::abs(row_index) < n;
 
     if (!index_is_valid)
@@ -92,12 +306,11 @@ const Vector &MATRIX::get_row_const(int row_index) const
         throw -1;
     }
 
-    auto result = std::vector<double>(m_components.at(row_index <0 ? n+row_index : row_index));
-
-    return * new Vector(std::move(result));
+    return BasicConstVectorView<T>(data() + (row_index < 0 ? n + row_index : row_index) * m_stride, column_count, 1);
 }
 
-MATRIX MATRIX::operator*(const MATRIX &other) const
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::operator*(const BasicMatrix &other) const
 {
     // Get dimensions of both matrices
     size_t nA = this->row_count, mA = this->column_count, nB = other.row_count, mB = other.column_count;
@@ -108,179 +321,250 @@ MATRIX MATRIX::operator*(const MATRIX &other) const
         throw -1;
     }
 
-    // Initialize result matrix with appropriate dimensions
-    MATRIX C = MATRIX(std::vector<std::vector<double>>(nA, std::vector<double>(mB, 0.0)));
+    // Initialize result matrix with appropriate dimensions (its allocation is charged to the product)
+    TSMATH_INSTRUMENT(matrix_multiply, 2 * nA * mB * mA, (nA * mA + mA * mB + nA * mB) * sizeof(T));
+    BasicMatrix C(nA, mB);
 
-    // Perform matrix multiplication
-    for (size_t k = 0; k < nA; k++)
-    {
-        for (size_t i = 0; i < mA; i++)
-        {
-            for (size_t j = 0; j < nB; j++)
-            {
-                C.m_components[k][i] += (this->m_components[k][i] * other.m_components[j][k]);
-            }
-        }
-    }
+    // Packed, cache-blocked multiplication straight into the result (DGEMM or SGEMM), rows of C split
+    // across the pool
+    blas::parallel_gemm(blas::Op::none, blas::Op::none, nA, mB, mA, T(1), data(), m_stride, other.data(),
+                        other.m_stride, T(0), C.data(), C.m_stride);
     return C;
 }
 
-MATRIX MATRIX::operator*(double scalar) const noexcept
+void expr::evaluate(double *out, size_t stride, const MatrixBinary<MATRIX, MATRIX, plus> &e, bool whole) noexcept
 {
-    size_t nA = this->row_count, mA = this->column_count;
-
-    // Initialize result matrix with appropriate dimensions
-    MATRIX C = MATRIX(std::vector<std::vector<double>>(nA, std::vector<double>(mA, 0.0)));
-
-    // Perform scalar multiplication
-    for (size_t k = 0; k < nA; k++)
-    {
-        for (size_t i = 0; i < mA; i++)
+    const MATRIX &a = e.lhs(), &b = e.rhs();
+    // The padded rows of a block view would spill over the columns next to it
+    whole = whole && stride == a.stride() && stride == b.stride();
+    [[maybe_unused]] const size_t elements = a.getRowCount() * a.getColumnCount();
+    TSMATH_INSTRUMENT(matrix_add, elements, 3 * elements * sizeof(double));
+    for_row_bands(a.getRowCount(), a.getColumnCount(), [&](size_t begin, size_t end) {
+        if (whole)
         {
-            C.m_components[k][i] = (this->m_components[k][i] * scalar);
+            // Padding stays zero
+            simd::add(a.data() + begin * stride, b.data() + begin * stride, out + begin * stride, (end - begin) * stride);
+            return;
         }
-    }
-    return C;
+        for (size_t i = begin; i < end; i++)
+        {
+            simd::add(a.data() + i * a.stride(), b.data() + i * b.stride(), out + i * stride, a.getColumnCount());
+        }
+    });
 }
 
-MATRIX MATRIX::operator+(const MATRIX &other) const
+void expr::evaluate(double *out, size_t stride, const MatrixScaled<MATRIX> &e, bool whole) noexcept
 {
-    size_t nA = this->row_count, mA = this->column_count;
-
-    // Check if matrices have the same dimensions
-    if (nA != other.getRowCount() || mA != other.getColumnCount())
-    {
-        throw -1;
-    }
-
-    // Initialize result matrix with appropriate dimensions
-    MATRIX C = MATRIX(std::vector<std::vector<double>>(nA, std::vector<double>(mA, 0.0)));
+    const MATRIX &a = e.operand_expression();
+    whole = whole && stride == a.stride();
+    const double scalar = e.scalar();
+    [[maybe_unused]] const size_t elements = a.getRowCount() * a.getColumnCount();
+    TSMATH_INSTRUMENT(matrix_scale, elements, 2 * elements * sizeof(double));
+    for_row_bands(a.getRowCount(), a.getColumnCount(), [&](size_t begin, size_t end) {
+        if (whole)
+        {
+            simd::scale(a.data() + begin * stride, scalar, out + begin * stride, (end - begin) * stride);
+            return;
+        }
+        for (size_t i = begin; i < end; i++)
+        {
+            simd::scale(a.data() + i * a.stride(), scalar, out + i * stride, a.getColumnCount());
+        }
+    });
+}
 
-    // Perform matrix addition
-    for (size_t k = 0; k < nA; k++)
-    {
-        for (size_t i = 0; i < mA; i++)
+void expr::evaluate(double *out, size_t stride, const MatrixBinary<MATRIX, MatrixScaled<MATRIX>, plus> &e,
+                    bool) noexcept
+{
+    const MATRIX &a = e.lhs(), &b = e.rhs().operand_expression();
+    const double scalar = e.rhs().scalar();
+    const size_t n = a.getColumnCount();
+    TSMATH_INSTRUMENT(matrix_axpy, 2 * a.getRowCount() * n, 3 * a.getRowCount() * n * sizeof(double));
+    for_row_bands(a.getRowCount(), n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
         {
-            C.m_components[k][i] = (this->m_components[k][i] + other.m_components[k][i]);
+            const double *x = a.data() + i * a.stride(), *y = b.data() + i * b.stride();
+            double *row = out + i * stride;
+            if (row == y)
+            {
+                simd::axpby(1.0, x, scalar, row, n);
+                continue;
+            }
+            if (row != x)
+            {
+                std::copy_n(x, n, row);
+            }
+            simd::axpy(scalar, y, row, n);
         }
-    }
-    return C;
+    });
 }
 
-MATRIX MATRIX::operator-(const MATRIX &other) const
+template <typename T>
+BasicMatrix<T> BasicMatrix<T>::transpose() const noexcept
 {
-    size_t nA = this->row_count, mA = this->column_count;
+    TSMATH_INSTRUMENT(transpose, 0, 2 * row_count * column_count * sizeof(T));
+    BasicMatrix C(column_count, row_count);
+    blas::transpose(row_count, column_count, data(), m_stride, C.data(), C.m_stride);
+    return C;
+}
 
-    // Check if matrices have the same dimensions
-    if (nA != other.getRowCount() || mA != other.getColumnCount())
+template <typename T>
+void BasicMatrix<T>::transpose_in_place()
+{
+    const size_t m = row_count, n = column_count;
+    TSMATH_INSTRUMENT(transpose_in_place, 0, 2 * m * n * sizeof(T));
+    T *a = m_buffer.data();
+    if (m == n)
     {
-        throw -1;
+        blas::transpose_in_place(n, a, m_stride);
+        return;
     }
 
-    // Initialize result matrix with appropriate dimensions
-    MATRIX C = MATRIX(std::vector<std::vector<double>>(nA, std::vector<double>(mA, 0.0)));
+    // Squeeze out the row padding, transpose the dense m x n block, then pad the n rows of m
+    const size_t stride = padded_stride(m);
+    for (size_t i = 1; i < m && m_stride != n; i++)
+    {
+        std::memmove(a + i * n, a + i * m_stride, n * sizeof(T));
+    }
+    blas::transpose_in_place(m, n, a);
 
-    // Perform matrix subtraction
-    for (size_t k = 0; k < nA; k++)
+    if (n * stride > m_buffer.size())
     {
-        for (size_t i = 0; i < mA; i++)
+        BasicAlignedBuffer<T> grown(n * stride, m_buffer.resource());
+        for (size_t j = 0; j < n; j++)
         {
-            C.m_components[k][i] = (this->m_components[k][i] - other.m_components[k][i]);
+            std::memcpy(grown.data() + j * stride, a + j * m, m * sizeof(T));
         }
+        m_buffer = std::move(grown);
     }
-    return C;
-}
-
-MATRIX MATRIX::transpose() const noexcept
-{
-
-    size_t nA = this->row_count, mA = this->column_count;
-
-    // Initialize result matrix with appropriate dimensions for transposition
-    MATRIX C = MATRIX(std::vector<std::vector<double>>(mA, std::vector<double>(nA, 0.0)));
-
-    // Perform matrix transposition
-    for (size_t k = 0; k < nA; k++)
+    else
     {
-        for (size_t i = 0; i < mA; i++)
+        // Last row first, each row only moves towards the end of the buffer
+        for (size_t j = n; j-- > 0;)
         {
-            C.m_components[k][i] = this->m_components[i][k];
+            std::memmove(a + j * stride, a + j * m, m * sizeof(T));
+            std::fill(a + j * stride + m, a + (j + 1) * stride, T(0));
         }
     }
-    return C;
+    row_count = n;
+    column_count = m;
+    m_stride = stride;
 }
 
-Vector &MATRIX::get_column(int index)
+template <typename T>
+BasicVectorView<T> BasicMatrix<T>::get_column(int index)
 {
     size_t m = column_count;
-    size_t n = row_count;
-    bool index_is_valid = abs( index  ) < m;
-
-    std::cout << m << " " << n << "\n";
+    bool index_is_valid = std::abs(index) < m;
 
     if (!index_is_valid)
     {
         throw -1;
     }
 
-    auto* result =  new std::vector<double>(n, 0.0);
-
-    this->print_matrix(std::cout);
-    for (size_t i = 0; i < n; i++)
-    {
-        
-        (*result)[i] = m_components[i][index < 0 ? m+index : index];
-        //std::cout <<result[i]<<"\n";
-    }
-
-    auto vector = new Vector(std::move(*result));
-   
-    return *vector;
+    // Consecutive column entries are one row stride apart
+    return BasicVectorView<T>(data() + (index < 0 ? m + index : index), row_count, m_stride);
 }
 
-const Vector &MATRIX::get_column_const(int index) const
+template <typename T>
+BasicConstVectorView<T> BasicMatrix<T>::get_column_const(int index) const
 {
     size_t m = column_count;
-    size_t n = row_count;
-    bool index_is_valid =abs(index) < m;
+    bool index_is_valid = std::abs(index) < m;
+
     if (!index_is_valid)
     {
         throw -1;
     }
 
-    auto* result =  new std::vector<double>(n, 0.0);
+    return BasicConstVectorView<T>(data() + (index < 0 ? m + index : index), row_count, m_stride);
+}
 
-    
-    for (size_t i = 0; i < n; i++)
-    {
-        
-        (*result)[i] = m_components.at(i).at( index <0 ? m+index : index);
-        //std::cout <<result[i]<<"\n";
-    }
+template <typename T>
+BasicMatrixView<T> BasicMatrix<T>::block(size_t first_row, size_t first_column, size_t row_count, size_t column_count)
+{
+    return BasicMatrixView<T>(*this).block(first_row, first_column, row_count, column_count);
+}
 
-    auto vector = new Vector(std::move(*result));
-  
-    return *vector;
+template <typename T>
+BasicConstMatrixView<T> BasicMatrix<T>::block(size_t first_row, size_t first_column, size_t row_count,
+                                              size_t column_count) const
+{
+    return BasicConstMatrixView<T>(*this).block(first_row, first_column, row_count, column_count);
+}
+
+template <typename T>
+BasicVectorView<T> BasicMatrix<T>::diagonal() noexcept
+{
+    return BasicMatrixView<T>(*this).diagonal();
 }
 
-size_t MATRIX::getColumnCount() const noexcept
+template <typename T>
+BasicConstVectorView<T> BasicMatrix<T>::diagonal() const noexcept
+{
+    return BasicConstMatrixView<T>(*this).diagonal();
+}
+
+template <typename T>
+T &BasicMatrix<T>::operator()(size_t row, size_t column) noexcept
+{
+    return m_buffer.data()[row * m_stride + column];
+}
+
+template <typename T>
+const T &BasicMatrix<T>::operator()(size_t row, size_t column) const noexcept
+{
+    return m_buffer.data()[row * m_stride + column];
+}
+
+template <typename T>
+T *BasicMatrix<T>::data() noexcept
+{
+    return m_buffer.data();
+}
+
+template <typename T>
+const T *BasicMatrix<T>::data() const noexcept
+{
+    return m_buffer.data();
+}
+
+template <typename T>
+size_t BasicMatrix<T>::stride() const noexcept
+{
+    return m_stride;
+}
+
+template <typename T>
+std::pmr::memory_resource *BasicMatrix<T>::resource() const noexcept
+{
+    return m_buffer.resource();
+}
+
+template <typename T>
+size_t BasicMatrix<T>::getColumnCount() const noexcept
 {
     return column_count;
 }
 
-size_t MATRIX::getRowCount() const noexcept
+template <typename T>
+size_t BasicMatrix<T>::getRowCount() const noexcept
 {
     return row_count;
 }
-void MATRIX::print_matrix(std::ostream &buff) const noexcept
+template <typename T>
+void BasicMatrix<T>::print_matrix(std::ostream &buff) const noexcept
 {
-    for (const auto &row : m_components)
+    for (size_t i = 0; i < row_count; i++)
     {
         buff << "[";
-        for (const auto &value : row)
+        for (size_t j = 0; j < column_count; j++)
         {
-            buff << value << " ";
+            buff << (*this)(i, j) << " ";
         }
         buff << "]\n";
     }
 }
+
+template class BasicMatrix<float>;
+template class BasicMatrix<double>;
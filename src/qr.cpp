@@ -0,0 +1,300 @@
+#include "../include/lin_alg.h"
+#include "../include/blas.h"
+#include "../include/householder.h"
+#include "../include/instrument.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // Panel width of the blocked factorization.
+    constexpr size_t NB = 32;
+
+    // Panels at most this wide are factored column by column.
+    constexpr size_t LEAF = 16;
+
+    // Scratch shared by the steps of one factorization; every use is transient.
+    struct PanelWorkspace
+    {
+        MATRIX V, G, T, W;
+
+        PanelWorkspace(size_t rows, size_t width, size_t columns)
+            : V(rows, width), G(width, width), T(width, width), W(width, columns)
+        {
+        }
+    };
+
+    // Unblocked factorization of columns [j0, j0 + width), reflectors applied row by row within them.
+    void factor_columns(MATRIX &A, size_t j0, size_t width, Vector &tau, double *w)
+    {
+        const size_t m = A.getRowCount(), lda = A.stride();
+        double *a = A.data();
+        for (size_t j = j0; j < j0 + width; j++)
+        {
+            const double t = householder::generate(a + j * lda + j, m - j, lda);
+            tau[j] = t;
+            if (t == 0.0)
+            {
+                continue;
+            }
+
+            // w = v^T A[j:, j+1:end], then A[j:, j+1:end] -= tau v w^T
+            const size_t first = j + 1, count = j0 + width - first;
+            std::copy_n(a + j * lda + first, count, w);
+            for (size_t i = j + 1; i < m; i++)
+            {
+                const double vi = a[i * lda + j];
+                const double *row = a + i * lda + first;
+                for (size_t c = 0; c < count; c++)
+                {
+                    w[c] += vi * row[c];
+                }
+            }
+            for (size_t c = 0; c < count; c++)
+            {
+                a[j * lda + first + c] -= t * w[c];
+            }
+            for (size_t i = j + 1; i < m; i++)
+            {
+                const double scale = t * a[i * lda + j];
+                double *row = a + i * lda + first;
+                for (size_t c = 0; c < count; c++)
+                {
+                    row[c] -= scale * w[c];
+                }
+            }
+        }
+    }
+
+    // Recursive panel factorization: factor the left half, apply it to the right half as one
+    // block reflector, then factor the right half. Tall panels then sweep memory O(log width) times.
+    void factor_panel(MATRIX &A, size_t j0, size_t width, Vector &tau, PanelWorkspace &work)
+    {
+        if (width <= LEAF)
+        {
+            factor_columns(A, j0, width, tau, work.W.data());
+            return;
+        }
+
+        const size_t m = A.getRowCount(), left = width / 2;
+        factor_panel(A, j0, left, tau, work);
+
+        householder::unpack(A.block(j0, j0, m - j0, left), left, work.V);
+        householder::form_t(work.V, m - j0, left, tau.data() + j0, work.G, work.T.data(), work.T.stride());
+        householder::apply_block(work.V, m - j0, left, work.T.data(), work.T.stride(),
+                                 A.block(j0, j0 + left, m - j0, width - left), work.W, true);
+
+        factor_panel(A, j0 + left, width - left, tau, work);
+    }
+}
+
+reflectors::Householder reflectors::make_householder(ConstVectorView x)
+{
+    if (x.dimension() == 0)
+    {
+        throw std::invalid_argument("Cannot build a reflector for an empty vector");
+    }
+
+    Vector v = x;
+    double tau = householder::generate(v.data(), v.dimension(), 1);
+    double beta = v[0];
+    v[0] = 1.0;
+    if (tau == 0.0)
+    {
+        // H = I, the vector is only kept for its shape
+        for (size_t i = 1; i < v.dimension(); i++)
+        {
+            v[i] = 0.0;
+        }
+    }
+    return Householder{v, tau, beta};
+}
+
+MATRIX reflectors::mk(ConstMatrixView A, size_t i, size_t k)
+{
+    const size_t m = A.getRowCount();
+    Householder h = make_householder(A.column(k).segment(i, m - i));
+
+    MATRIX H(m - i, m - i);
+    for (size_t r = 0; r < m - i; r++)
+    {
+        for (size_t c = 0; c < m - i; c++)
+        {
+            H(r, c) = (r == c ? 1.0 : 0.0) - h.tau * h.v[r] * h.v[c];
+        }
+    }
+    return H;
+}
+
+MATRIX reflectors::householder(ConstMatrixView A, size_t i, size_t k)
+{
+    const size_t m = A.getRowCount();
+    MATRIX H(m, m);
+    for (size_t r = 0; r < i; r++)
+    {
+        H(r, r) = 1.0;
+    }
+    H.block(i, i, m - i, m - i) = mk(A, i, k);
+    return H;
+}
+
+factorization::QR::QR(ConstMatrixView A)
+    : m_factors(A), m_tau(std::min(A.getRowCount(), A.getColumnCount())),
+      m_t(std::min(NB, m_tau.dimension()), m_tau.dimension())
+{
+    const size_t m = getRowCount(), n = getColumnCount(), r = m_tau.dimension();
+    TSMATH_INSTRUMENT(qr, 2 * (2 * m * n * r - (m + n) * r * r + 2 * r * r * r / 3), 2 * m * n * sizeof(double));
+    PanelWorkspace work(m, std::min(NB, r), n);
+
+    for (size_t k = 0; k < r; k += NB)
+    {
+        const size_t jb = std::min(NB, r - k);
+
+        factor_panel(m_factors, k, jb, m_tau, work);
+
+        // T of the whole panel, kept for applying Q later
+        householder::unpack(m_factors.block(k, k, m - k, jb), jb, work.V);
+        householder::form_t(work.V, m - k, jb, m_tau.data() + k, work.G, m_t.data() + k, m_t.stride());
+
+        // Trailing update A[k:, k+jb:] = Q_panel^T A[k:, k+jb:]
+        if (k + jb < n)
+        {
+            householder::apply_block(work.V, m - k, jb, m_t.data() + k, m_t.stride(),
+                                     m_factors.block(k, k + jb, m - k, n - k - jb), work.W, true);
+        }
+    }
+}
+
+size_t factorization::QR::getRowCount() const noexcept
+{
+    return m_factors.getRowCount();
+}
+
+size_t factorization::QR::getColumnCount() const noexcept
+{
+    return m_factors.getColumnCount();
+}
+
+const MATRIX &factorization::QR::packed() const noexcept
+{
+    return m_factors;
+}
+
+const Vector &factorization::QR::tau() const noexcept
+{
+    return m_tau;
+}
+
+MATRIX factorization::QR::r() const
+{
+    const size_t n = getColumnCount(), r = m_tau.dimension();
+    MATRIX R(r, n);
+    for (size_t i = 0; i < r; i++)
+    {
+        for (size_t j = i; j < n; j++)
+        {
+            R(i, j) = m_factors(i, j);
+        }
+    }
+    return R;
+}
+
+MATRIX factorization::QR::q() const
+{
+    const size_t m = getRowCount(), r = m_tau.dimension();
+    MATRIX Q(m, r);
+    for (size_t i = 0; i < r; i++)
+    {
+        Q(i, i) = 1.0;
+    }
+    apply_q(Q);
+    return Q;
+}
+
+void factorization::QR::apply_qt(MatrixView B) const
+{
+    const size_t m = getRowCount(), r = m_tau.dimension();
+    if (B.getRowCount() != m)
+    {
+        throw std::invalid_argument("Matrix dimensions do not match for applying Q^T");
+    }
+
+    MATRIX V(m, std::min(NB, r));
+    MATRIX W(std::min(NB, r), B.getColumnCount());
+    for (size_t k = 0; k < r; k += NB)
+    {
+        const size_t jb = std::min(NB, r - k);
+        householder::unpack(m_factors.block(k, k, m - k, jb), jb, V);
+        householder::apply_block(V, m - k, jb, m_t.data() + k, m_t.stride(), B.block(k, 0, m - k, B.getColumnCount()), W,
+                                 true);
+    }
+}
+
+void factorization::QR::apply_q(MatrixView B) const
+{
+    const size_t m = getRowCount(), r = m_tau.dimension();
+    if (B.getRowCount() != m)
+    {
+        throw std::invalid_argument("Matrix dimensions do not match for applying Q");
+    }
+
+    MATRIX V(m, std::min(NB, r));
+    MATRIX W(std::min(NB, r), B.getColumnCount());
+    // Q = Q_0 Q_1 ... so the panels are applied last to first
+    for (size_t panels = (r + NB - 1) / NB; panels-- > 0;)
+    {
+        const size_t k = panels * NB, jb = std::min(NB, r - k);
+        householder::unpack(m_factors.block(k, k, m - k, jb), jb, V);
+        householder::apply_block(V, m - k, jb, m_t.data() + k, m_t.stride(), B.block(k, 0, m - k, B.getColumnCount()), W,
+                                 false);
+    }
+}
+
+Vector factorization::QR::solve_least_squares(ConstVectorView b) const
+{
+    const size_t m = getRowCount(), n = getColumnCount();
+    if (m < n)
+    {
+        throw std::invalid_argument("Least squares needs at least as many rows as columns");
+    }
+    if (b.dimension() != m)
+    {
+        throw std::invalid_argument("Right-hand side does not match the matrix size");
+    }
+
+    // y = Q^T b, then R x = y[0:n]
+    Vector y = b;
+    apply_qt(MatrixView(y.data(), m, 1, 1));
+
+    Vector x(n);
+    for (size_t i = n; i-- > 0;)
+    {
+        double sum = y[i];
+        for (size_t j = i + 1; j < n; j++)
+        {
+            sum -= m_factors(i, j) * x[j];
+        }
+        if (m_factors(i, i) == 0.0)
+        {
+            throw std::domain_error("Matrix is rank deficient");
+        }
+        x[i] = sum / m_factors(i, i);
+    }
+    return x;
+}
+
+std::pair<MATRIX, MATRIX> factorization::qr(ConstMatrixView A)
+{
+    QR decomposition(A);
+    return std::make_pair(decomposition.q(), decomposition.r());
+}
+
+Vector lst_sqr::lst_sqrs(ConstMatrixView A, ConstVectorView b)
+{
+    [[maybe_unused]] const size_t m = A.getRowCount(), n = A.getColumnCount();
+    TSMATH_INSTRUMENT(least_squares, 2 * m * n * n - 2 * n * n * n / 3 + 4 * m * n, (2 * m * n + 2 * m) * sizeof(double));
+    return factorization::QR(A).solve_least_squares(b);
+}
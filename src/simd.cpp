@@ -0,0 +1,617 @@
+#include "../include/simd.h"
+#include "../include/macros.h"
+#include <atomic>
+#include <cmath>
+
+#if TSMATH_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+    // Number of partial sums in the deterministic reduction, one AVX-512 register worth.
+    constexpr size_t LANES = 8;
+
+    // Folds the 8 deterministic partial sums in a fixed tree: 8 -> 4 -> 2 -> 1.
+    double fold_lanes(const double *acc) noexcept
+    {
+        double t0 = acc[0] + acc[4], t1 = acc[1] + acc[5], t2 = acc[2] + acc[6], t3 = acc[3] + acc[7];
+        double u0 = t0 + t2, u1 = t1 + t3;
+        return u0 + u1;
+    }
+
+    // Finishes a deterministic reduction from element 'start' on, element i always lands in lane i % 8.
+    double finish_lanes(double *acc, const double *x, const double *y, size_t start, size_t n) noexcept
+    {
+        for (size_t i = start; i < n; ++i)
+        {
+            acc[i % LANES] = std::fma(x[i], y[i], acc[i % LANES]);
+        }
+        return fold_lanes(acc);
+    }
+
+    // ---- scalar kernels --------------------------------------------------------------------
+
+    void add_scalar(const double *x, const double *y, double *out, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = x[i] + y[i];
+        }
+    }
+
+    void scale_scalar(const double *x, double alpha, double *out, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            out[i] = x[i] * alpha;
+        }
+    }
+
+    void axpy_scalar(double alpha, const double *x, double *y, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    void axpby_scalar(double alpha, const double *x, double beta, double *y, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            y[i] = alpha * x[i] + beta * y[i];
+        }
+    }
+
+    void rotate_scalar(double *x, double *y, double c, double s, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            const double xi = x[i], yi = y[i];
+            x[i] = c * xi + s * yi;
+            y[i] = c * yi - s * xi;
+        }
+    }
+
+    double dot_scalar(const double *x, const double *y, size_t n) noexcept
+    {
+        // Four independent accumulators to hide the add latency
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            s0 += x[i] * y[i];
+            s1 += x[i + 1] * y[i + 1];
+            s2 += x[i + 2] * y[i + 2];
+            s3 += x[i + 3] * y[i + 3];
+        }
+        for (; i < n; ++i)
+        {
+            s0 += x[i] * y[i];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    double dot_scalar_deterministic(const double *x, const double *y, size_t n) noexcept
+    {
+        double acc[LANES] = {};
+        return finish_lanes(acc, x, y, 0, n);
+    }
+
+    void transpose_scalar(const double *a, size_t lda, double *b, size_t ldb, size_t rows, size_t columns) noexcept
+    {
+        for (size_t i = 0; i < rows; ++i)
+        {
+            for (size_t j = 0; j < columns; ++j)
+            {
+                b[j * ldb + i] = a[i * lda + j];
+            }
+        }
+    }
+
+    // Transposes the parts of a rows x columns block left over by a kernel working on tile x tile squares.
+    void transpose_edges(const double *a, size_t lda, double *b, size_t ldb, size_t rows, size_t columns,
+                         size_t tile) noexcept
+    {
+        const size_t whole_rows = rows / tile * tile, whole_columns = columns / tile * tile;
+        transpose_scalar(a + whole_columns, lda, b + whole_columns * ldb, ldb, whole_rows, columns - whole_columns);
+        transpose_scalar(a + whole_rows * lda, lda, b + whole_rows, ldb, rows - whole_rows, columns);
+    }
+
+#if TSMATH_X86
+    // ---- AVX2 + FMA kernels ----------------------------------------------------------------
+
+    TSMATH_TARGET("avx2,fma")
+    void add_avx2(const double *x, const double *y, double *out, size_t n) noexcept
+    {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        for (; i < n; ++i)
+        {
+            out[i] = x[i] + y[i];
+        }
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    void scale_avx2(const double *x, double alpha, double *out, size_t n) noexcept
+    {
+        const __m256d a = _mm256_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), a));
+        }
+        for (; i < n; ++i)
+        {
+            out[i] = x[i] * alpha;
+        }
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    void axpy_avx2(double alpha, const double *x, double *y, size_t n) noexcept
+    {
+        const __m256d a = _mm256_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+        }
+        axpy_scalar(alpha, x + i, y + i, n - i);
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    void axpby_avx2(double alpha, const double *x, double beta, double *y, size_t n) noexcept
+    {
+        const __m256d a = _mm256_set1_pd(alpha), b = _mm256_set1_pd(beta);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            _mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_mul_pd(b, _mm256_loadu_pd(y + i))));
+        }
+        axpby_scalar(alpha, x + i, beta, y + i, n - i);
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    void rotate_avx2(double *x, double *y, double c, double s, size_t n) noexcept
+    {
+        const __m256d vc = _mm256_set1_pd(c), vs = _mm256_set1_pd(s);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256d xi = _mm256_loadu_pd(x + i), yi = _mm256_loadu_pd(y + i);
+            _mm256_storeu_pd(x + i, _mm256_fmadd_pd(vc, xi, _mm256_mul_pd(vs, yi)));
+            _mm256_storeu_pd(y + i, _mm256_fnmadd_pd(vs, xi, _mm256_mul_pd(vc, yi)));
+        }
+        rotate_scalar(x + i, y + i, c, s, n - i);
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    double dot_avx2(const double *x, const double *y, size_t n) noexcept
+    {
+        // Four 4-wide accumulators cover the FMA latency
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 16 <= n; i += 16)
+        {
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+            s1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), s1);
+            s2 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 8), _mm256_loadu_pd(y + i + 8), s2);
+            s3 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 12), _mm256_loadu_pd(y + i + 12), s3);
+        }
+        for (; i + 4 <= n; i += 4)
+        {
+            s0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), s0);
+        }
+        __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+        __m128d h = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+        double result = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+        for (; i < n; ++i)
+        {
+            result += x[i] * y[i];
+        }
+        return result;
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    double dot_avx2_deterministic(const double *x, const double *y, size_t n) noexcept
+    {
+        // Lanes 0-3 and 4-7 of the 8-lane layout
+        __m256d lo = _mm256_setzero_pd(), hi = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+            lo = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), lo);
+            hi = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), hi);
+        }
+        double acc[LANES];
+        _mm256_storeu_pd(acc, lo);
+        _mm256_storeu_pd(acc + 4, hi);
+        return finish_lanes(acc, x, y, i, n);
+    }
+
+    TSMATH_TARGET("avx2,fma")
+    void transpose_avx2(const double *a, size_t lda, double *b, size_t ldb, size_t rows, size_t columns) noexcept
+    {
+        // 4 x 4 tiles transposed in registers: pair up rows 0/1 and 2/3 within each 128-bit half,
+        // then swap the halves
+        for (size_t i = 0; i + 4 <= rows; i += 4)
+        {
+            const double *r = a + i * lda;
+            for (size_t j = 0; j + 4 <= columns; j += 4)
+            {
+                const __m256d r0 = _mm256_loadu_pd(r + j), r1 = _mm256_loadu_pd(r + lda + j);
+                const __m256d r2 = _mm256_loadu_pd(r + 2 * lda + j), r3 = _mm256_loadu_pd(r + 3 * lda + j);
+                const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+                const __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+                double *c = b + j * ldb + i;
+                _mm256_storeu_pd(c, _mm256_permute2f128_pd(t0, t2, 0x20));
+                _mm256_storeu_pd(c + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+                _mm256_storeu_pd(c + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+                _mm256_storeu_pd(c + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+            }
+        }
+        transpose_edges(a, lda, b, ldb, rows, columns, 4);
+    }
+
+    // ---- AVX-512 kernels -------------------------------------------------------------------
+
+    TSMATH_TARGET("avx512f")
+    void add_avx512(const double *x, const double *y, double *out, size_t n) noexcept
+    {
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+        }
+        if (i < n)
+        {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            _mm512_mask_storeu_pd(out + i, mask,
+                                  _mm512_add_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i)));
+        }
+    }
+
+    TSMATH_TARGET("avx512f")
+    void scale_avx512(const double *x, double alpha, double *out, size_t n) noexcept
+    {
+        const __m512d a = _mm512_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            _mm512_storeu_pd(out + i, _mm512_mul_pd(_mm512_loadu_pd(x + i), a));
+        }
+        if (i < n)
+        {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            _mm512_mask_storeu_pd(out + i, mask, _mm512_mul_pd(_mm512_maskz_loadu_pd(mask, x + i), a));
+        }
+    }
+
+    TSMATH_TARGET("avx512f")
+    void axpy_avx512(double alpha, const double *x, double *y, size_t n) noexcept
+    {
+        const __m512d a = _mm512_set1_pd(alpha);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+        }
+        if (i < n)
+        {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            _mm512_mask_storeu_pd(y + i, mask,
+                                  _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i)));
+        }
+    }
+
+    TSMATH_TARGET("avx512f")
+    void axpby_avx512(double alpha, const double *x, double beta, double *y, size_t n) noexcept
+    {
+        const __m512d a = _mm512_set1_pd(alpha), b = _mm512_set1_pd(beta);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            _mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_mul_pd(b, _mm512_loadu_pd(y + i))));
+        }
+        if (i < n)
+        {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            const __m512d yi = _mm512_mul_pd(b, _mm512_maskz_loadu_pd(mask, y + i));
+            _mm512_mask_storeu_pd(y + i, mask, _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(mask, x + i), yi));
+        }
+    }
+
+    TSMATH_TARGET("avx512f")
+    void rotate_avx512(double *x, double *y, double c, double s, size_t n) noexcept
+    {
+        const __m512d vc = _mm512_set1_pd(c), vs = _mm512_set1_pd(s);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            const __m512d xi = _mm512_loadu_pd(x + i), yi = _mm512_loadu_pd(y + i);
+            _mm512_storeu_pd(x + i, _mm512_fmadd_pd(vc, xi, _mm512_mul_pd(vs, yi)));
+            _mm512_storeu_pd(y + i, _mm512_fnmadd_pd(vs, xi, _mm512_mul_pd(vc, yi)));
+        }
+        if (i < n)
+        {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            const __m512d xi = _mm512_maskz_loadu_pd(mask, x + i), yi = _mm512_maskz_loadu_pd(mask, y + i);
+            _mm512_mask_storeu_pd(x + i, mask, _mm512_fmadd_pd(vc, xi, _mm512_mul_pd(vs, yi)));
+            _mm512_mask_storeu_pd(y + i, mask, _mm512_fnmadd_pd(vs, xi, _mm512_mul_pd(vc, yi)));
+        }
+    }
+
+    TSMATH_TARGET("avx512f")
+    double dot_avx512(const double *x, const double *y, size_t n) noexcept
+    {
+        // Four 8-wide accumulators cover the FMA latency
+        __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+        __m512d s2 = _mm512_setzero_pd(), s3 = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32)
+        {
+            s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s0);
+            s1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), s1);
+            s2 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 16), _mm512_loadu_pd(y + i + 16), s2);
+            s3 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 24), _mm512_loadu_pd(y + i + 24), s3);
+        }
+        for (; i + 8 <= n; i += 8)
+        {
+            s0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s0);
+        }
+        if (i < n)
+        {
+            __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+            s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, x + i), _mm512_maskz_loadu_pd(mask, y + i), s1);
+        }
+        double acc[LANES];
+        _mm512_storeu_pd(acc, _mm512_add_pd(_mm512_add_pd(s0, s1), _mm512_add_pd(s2, s3)));
+        return fold_lanes(acc);
+    }
+
+    TSMATH_TARGET("avx512f")
+    double dot_avx512_deterministic(const double *x, const double *y, size_t n) noexcept
+    {
+        __m512d s = _mm512_setzero_pd();
+        size_t i = 0;
+        for (; i + LANES <= n; i += LANES)
+        {
+            s = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), s);
+        }
+        double acc[LANES];
+        _mm512_storeu_pd(acc, s);
+        return finish_lanes(acc, x, y, i, n);
+    }
+
+    TSMATH_TARGET("avx512f")
+    void transpose_avx512(const double *a, size_t lda, double *b, size_t ldb, size_t rows, size_t columns) noexcept
+    {
+        // 8 x 8 tiles transposed in registers: interleave row pairs, then regroup 128-bit lanes twice
+        for (size_t i = 0; i + 8 <= rows; i += 8)
+        {
+            const double *r = a + i * lda;
+            for (size_t j = 0; j + 8 <= columns; j += 8)
+            {
+                __m512d t[8], u[8];
+                for (size_t k = 0; k < 8; k += 2)
+                {
+                    const __m512d even = _mm512_loadu_pd(r + k * lda + j), odd = _mm512_loadu_pd(r + (k + 1) * lda + j);
+                    t[k] = _mm512_unpacklo_pd(even, odd);
+                    t[k + 1] = _mm512_unpackhi_pd(even, odd);
+                }
+                for (size_t k = 0; k < 8; k += 4)
+                {
+                    u[k] = _mm512_shuffle_f64x2(t[k], t[k + 2], 0x88);
+                    u[k + 1] = _mm512_shuffle_f64x2(t[k + 1], t[k + 3], 0x88);
+                    u[k + 2] = _mm512_shuffle_f64x2(t[k], t[k + 2], 0xDD);
+                    u[k + 3] = _mm512_shuffle_f64x2(t[k + 1], t[k + 3], 0xDD);
+                }
+                double *c = b + j * ldb + i;
+                for (size_t k = 0; k < 4; ++k)
+                {
+                    _mm512_storeu_pd(c + k * ldb, _mm512_shuffle_f64x2(u[k], u[k + 4], 0x88));
+                    _mm512_storeu_pd(c + (k + 4) * ldb, _mm512_shuffle_f64x2(u[k], u[k + 4], 0xDD));
+                }
+            }
+        }
+        transpose_edges(a, lda, b, ldb, rows, columns, 8);
+    }
+
+    simd::isa query_cpu() noexcept
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        int max_leaf = info[0];
+        if (max_leaf < 7)
+        {
+            return simd::isa::scalar;
+        }
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave)
+        {
+            return simd::isa::scalar;
+        }
+        unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0;
+        bool avx512f = (info[1] & (1 << 16)) != 0;
+        // YMM state, then opmask/ZMM state, must be enabled by the OS
+        if (avx512f && fma && (xcr0 & 0xE6) == 0xE6)
+        {
+            return simd::isa::avx512;
+        }
+        if (avx2 && fma && (xcr0 & 0x6) == 0x6)
+        {
+            return simd::isa::avx2;
+        }
+        return simd::isa::scalar;
+#else
+        // libgcc's feature bits already account for OS support of the register state
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma"))
+        {
+            return simd::isa::avx512;
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        {
+            return simd::isa::avx2;
+        }
+        return simd::isa::scalar;
+#endif
+    }
+#else
+    simd::isa query_cpu() noexcept
+    {
+        return simd::isa::scalar;
+    }
+#endif
+
+    // One table of kernels per instruction set.
+    struct kernel_table
+    {
+        void (*add)(const double *, const double *, double *, size_t) noexcept;
+        void (*scale)(const double *, double, double *, size_t) noexcept;
+        void (*axpy)(double, const double *, double *, size_t) noexcept;
+        void (*axpby)(double, const double *, double, double *, size_t) noexcept;
+        void (*rotate)(double *, double *, double, double, size_t) noexcept;
+        double (*dot)(const double *, const double *, size_t) noexcept;
+        double (*dot_deterministic)(const double *, const double *, size_t) noexcept;
+        void (*transpose)(const double *, size_t, double *, size_t, size_t, size_t) noexcept;
+    };
+
+    const kernel_table scalar_kernels = {add_scalar,    scale_scalar,
+                                         axpy_scalar,   axpby_scalar,
+                                         rotate_scalar, dot_scalar,
+                                         dot_scalar_deterministic, transpose_scalar};
+#if TSMATH_X86
+    const kernel_table avx2_kernels = {add_avx2,    scale_avx2,
+                                       axpy_avx2,   axpby_avx2,
+                                       rotate_avx2, dot_avx2,
+                                       dot_avx2_deterministic, transpose_avx2};
+    const kernel_table avx512_kernels = {add_avx512,    scale_avx512,
+                                         axpy_avx512,   axpby_avx512,
+                                         rotate_avx512, dot_avx512,
+                                         dot_avx512_deterministic, transpose_avx512};
+#endif
+
+    const kernel_table *table_for(simd::isa target) noexcept
+    {
+#if TSMATH_X86
+        switch (target)
+        {
+        case simd::isa::avx512:
+            return &avx512_kernels;
+        case simd::isa::avx2:
+            return &avx2_kernels;
+        default:
+            break;
+        }
+#endif
+        return &scalar_kernels;
+    }
+
+    struct dispatch_state
+    {
+        simd::isa detected;
+        std::atomic<simd::isa> active;
+        std::atomic<const kernel_table *> kernels;
+        std::atomic<bool> deterministic;
+
+        dispatch_state() noexcept
+            : detected(query_cpu()), active(detected), kernels(table_for(detected)),
+              deterministic(TSMATH_DETERMINISTIC_REDUCTION != 0)
+        {
+        }
+    };
+
+    // Resolved once, on first use, so static initialisation order does not matter.
+    dispatch_state &state() noexcept
+    {
+        static dispatch_state instance;
+        return instance;
+    }
+
+    const kernel_table &kernels() noexcept
+    {
+        return *state().kernels.load(std::memory_order_relaxed);
+    }
+}
+
+simd::isa simd::detected_isa() noexcept
+{
+    return state().detected;
+}
+
+simd::isa simd::active_isa() noexcept
+{
+    return state().active.load(std::memory_order_relaxed);
+}
+
+void simd::set_isa(isa target) noexcept
+{
+    isa clamped = target < state().detected ? target : state().detected;
+    state().active.store(clamped, std::memory_order_relaxed);
+    state().kernels.store(table_for(clamped), std::memory_order_relaxed);
+}
+
+void simd::set_deterministic_reduction(bool enabled) noexcept
+{
+    state().deterministic.store(enabled, std::memory_order_relaxed);
+}
+
+bool simd::deterministic_reduction() noexcept
+{
+    return state().deterministic.load(std::memory_order_relaxed);
+}
+
+void simd::add(const double *x, const double *y, double *out, size_t n) noexcept
+{
+    kernels().add(x, y, out, n);
+}
+
+void simd::scale(const double *x, double alpha, double *out, size_t n) noexcept
+{
+    kernels().scale(x, alpha, out, n);
+}
+
+void simd::axpy(double alpha, const double *x, double *y, size_t n) noexcept
+{
+    kernels().axpy(alpha, x, y, n);
+}
+
+void simd::axpby(double alpha, const double *x, double beta, double *y, size_t n) noexcept
+{
+    kernels().axpby(alpha, x, beta, y, n);
+}
+
+void simd::rotate(double *x, double *y, double c, double s, size_t n) noexcept
+{
+    kernels().rotate(x, y, c, s, n);
+}
+
+double simd::dot(const double *x, const double *y, size_t n) noexcept
+{
+    const kernel_table &k = kernels();
+    return deterministic_reduction() ? k.dot_deterministic(x, y, n) : k.dot(x, y, n);
+}
+
+double simd::sum_squares(const double *x, size_t n) noexcept
+{
+    return dot(x, x, n);
+}
+
+void simd::transpose(const double *a, size_t lda, double *b, size_t ldb, size_t rows, size_t columns) noexcept
+{
+    kernels().transpose(a, lda, b, ldb, rows, columns);
+}
@@ -0,0 +1,539 @@
+#include "../include/sparse.h"
+#include "../include/instrument.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // Rows handed to one thread by the row-parallel kernels.
+    constexpr size_t ROW_GRAIN = 1024;
+
+    // Products with fewer stored entries (times right-hand sides) than this stay on the calling thread.
+    constexpr size_t PARALLEL_WORK = 1 << 15;
+
+    // Right-hand side columns owned by one thread when a CSC matrix scatters into a dense result.
+    constexpr size_t COLUMN_GRAIN = 64;
+
+    // Entry of a triplet list in storage coordinates.
+    struct Entry
+    {
+        size_t major;
+        size_t minor;
+        double value;
+    };
+
+    // Compresses entries into offsets/indices/values over major_count majors: a counting sort on
+    // the major index, then each segment is sorted by minor index and its duplicates summed.
+    void compress(size_t major_count, const std::vector<Entry> &entries, std::vector<size_t> &offsets,
+                  std::vector<size_t> &indices, std::vector<double> &values)
+    {
+        offsets.assign(major_count + 1, 0);
+        for (const Entry &e : entries)
+        {
+            offsets[e.major + 1]++;
+        }
+        for (size_t k = 0; k < major_count; k++)
+        {
+            offsets[k + 1] += offsets[k];
+        }
+
+        std::vector<std::pair<size_t, double>> slots(entries.size());
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (const Entry &e : entries)
+        {
+            slots[next[e.major]++] = std::make_pair(e.minor, e.value);
+        }
+
+        indices.clear();
+        values.clear();
+        indices.reserve(entries.size());
+        values.reserve(entries.size());
+        size_t begin = 0;
+        for (size_t k = 0; k < major_count; k++)
+        {
+            const size_t end = offsets[k + 1];
+            std::sort(slots.begin() + begin, slots.begin() + end,
+                      [](const std::pair<size_t, double> &a, const std::pair<size_t, double> &b) {
+                          return a.first < b.first;
+                      });
+            offsets[k] = indices.size();
+            for (size_t p = begin; p < end; p++)
+            {
+                if (indices.size() > offsets[k] && indices.back() == slots[p].first)
+                {
+                    values.back() += slots[p].second;
+                }
+                else
+                {
+                    indices.push_back(slots[p].first);
+                    values.push_back(slots[p].second);
+                }
+            }
+            begin = end;
+        }
+        offsets[major_count] = indices.size();
+    }
+
+    // Runs body(begin, end) over [0, count), on the pool when the work is large enough.
+    template <typename Body>
+    void for_rows(size_t count, size_t work, const Body &body)
+    {
+        if (!parallel::worthwhile(work, PARALLEL_WORK))
+        {
+            body(0, count);
+            return;
+        }
+        parallel::parallel_for(count, ROW_GRAIN, body);
+    }
+
+    // Y = beta * Y, overwriting without reading when beta is 0.
+    void scale_rows(double beta, double *y, size_t rows, size_t columns, size_t ldy)
+    {
+        if (beta == 1.0)
+        {
+            return;
+        }
+        for_rows(rows, rows * columns, [=](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                double *row = y + i * ldy;
+                for (size_t c = 0; c < columns; c++)
+                {
+                    row[c] = beta == 0.0 ? 0.0 : beta * row[c];
+                }
+            }
+        });
+    }
+
+    // Y(:, first:first + width) += alpha * A(:, begin:end) X(begin:end, first:first + width) for a
+    // CSC A, scattering column by column.
+    void scatter_columns(const size_t *offsets, const size_t *indices, const double *values, size_t begin,
+                         size_t end, double alpha, const double *x, size_t ldx, size_t width, double *y, size_t ldy)
+    {
+        for (size_t j = begin; j < end; j++)
+        {
+            const double *source = x + j * ldx;
+            for (size_t p = offsets[j]; p < offsets[j + 1]; p++)
+            {
+                const double a = alpha * values[p];
+                double *target = y + indices[p] * ldy;
+                for (size_t c = 0; c < width; c++)
+                {
+                    target[c] += a * source[c];
+                }
+            }
+        }
+    }
+}
+
+SparseMatrix::SparseMatrix(size_t row_count, size_t column_count, Format format)
+    : SparseMatrix(row_count, column_count, std::vector<Triplet>(), format)
+{
+}
+
+SparseMatrix::SparseMatrix(size_t row_count, size_t column_count, const std::vector<Triplet> &triplets,
+                           Format format)
+    : m_row_count(row_count), m_column_count(column_count), m_format(format)
+{
+    const bool csr = format == Format::csr;
+    std::vector<Entry> entries;
+    entries.reserve(triplets.size());
+    for (const Triplet &t : triplets)
+    {
+        if (t.row >= row_count || t.column >= column_count)
+        {
+            throw std::out_of_range("Triplet index out of bounds");
+        }
+        entries.push_back(csr ? Entry{t.row, t.column, t.value} : Entry{t.column, t.row, t.value});
+    }
+    auto storage = std::make_shared<Storage>();
+    compress(csr ? row_count : column_count, entries, storage->offsets, storage->indices, storage->values);
+    m_storage = std::move(storage);
+}
+
+SparseMatrix::SparseMatrix(ConstMatrixView A, Format format, double tolerance)
+    : m_row_count(A.getRowCount()), m_column_count(A.getColumnCount()), m_format(format)
+{
+    const bool csr = format == Format::csr;
+    const size_t majors = csr ? m_row_count : m_column_count, minors = csr ? m_column_count : m_row_count;
+    auto storage = std::make_shared<Storage>();
+    storage->offsets.assign(majors + 1, 0);
+    for (size_t k = 0; k < majors; k++)
+    {
+        for (size_t l = 0; l < minors; l++)
+        {
+            const double value = csr ? A(k, l) : A(l, k);
+            if (std::abs(value) > tolerance)
+            {
+                storage->indices.push_back(l);
+                storage->values.push_back(value);
+            }
+        }
+        storage->offsets[k + 1] = storage->indices.size();
+    }
+    m_storage = std::move(storage);
+}
+
+SparseMatrix::SparseMatrix(size_t row_count, size_t column_count, Format format,
+                           std::shared_ptr<const Storage> storage) noexcept
+    : m_row_count(row_count), m_column_count(column_count), m_format(format), m_storage(std::move(storage))
+{
+}
+
+size_t SparseMatrix::getRowCount() const noexcept
+{
+    return m_row_count;
+}
+
+size_t SparseMatrix::getColumnCount() const noexcept
+{
+    return m_column_count;
+}
+
+SparseMatrix::Format SparseMatrix::format() const noexcept
+{
+    return m_format;
+}
+
+size_t SparseMatrix::nonzeros() const noexcept
+{
+    return m_storage->values.size();
+}
+
+const std::vector<size_t> &SparseMatrix::offsets() const noexcept
+{
+    return m_storage->offsets;
+}
+
+const std::vector<size_t> &SparseMatrix::indices() const noexcept
+{
+    return m_storage->indices;
+}
+
+const std::vector<double> &SparseMatrix::values() const noexcept
+{
+    return m_storage->values;
+}
+
+double SparseMatrix::coeff(size_t row, size_t column) const
+{
+    if (row >= m_row_count || column >= m_column_count)
+    {
+        throw std::out_of_range("Index out of bounds");
+    }
+    const size_t major = m_format == Format::csr ? row : column, minor = m_format == Format::csr ? column : row;
+    const auto first = m_storage->indices.begin() + m_storage->offsets[major];
+    const auto last = m_storage->indices.begin() + m_storage->offsets[major + 1];
+    const auto found = std::lower_bound(first, last, minor);
+    return found != last && *found == minor ? m_storage->values[found - m_storage->indices.begin()] : 0.0;
+}
+
+SparseMatrix SparseMatrix::transpose() const noexcept
+{
+    return SparseMatrix(m_column_count, m_row_count, m_format == Format::csr ? Format::csc : Format::csr, m_storage);
+}
+
+SparseMatrix SparseMatrix::to_format(Format format) const
+{
+    if (format == m_format)
+    {
+        return *this;
+    }
+
+    // Counting sort on the minor index; walking the majors in order leaves every new segment sorted
+    const size_t majors = m_format == Format::csr ? m_row_count : m_column_count;
+    const size_t minors = m_format == Format::csr ? m_column_count : m_row_count;
+    const Storage &source = *m_storage;
+    auto storage = std::make_shared<Storage>();
+    storage->offsets.assign(minors + 1, 0);
+    storage->indices.resize(source.indices.size());
+    storage->values.resize(source.values.size());
+    for (size_t index : source.indices)
+    {
+        storage->offsets[index + 1]++;
+    }
+    for (size_t l = 0; l < minors; l++)
+    {
+        storage->offsets[l + 1] += storage->offsets[l];
+    }
+    std::vector<size_t> next(storage->offsets.begin(), storage->offsets.end() - 1);
+    for (size_t k = 0; k < majors; k++)
+    {
+        for (size_t p = source.offsets[k]; p < source.offsets[k + 1]; p++)
+        {
+            const size_t slot = next[source.indices[p]]++;
+            storage->indices[slot] = k;
+            storage->values[slot] = source.values[p];
+        }
+    }
+    return SparseMatrix(m_row_count, m_column_count, format, std::move(storage));
+}
+
+MATRIX SparseMatrix::to_dense() const
+{
+    MATRIX D(m_row_count, m_column_count);
+    const Storage &s = *m_storage;
+    const size_t majors = m_format == Format::csr ? m_row_count : m_column_count;
+    for (size_t k = 0; k < majors; k++)
+    {
+        for (size_t p = s.offsets[k]; p < s.offsets[k + 1]; p++)
+        {
+            if (m_format == Format::csr)
+            {
+                D(k, s.indices[p]) = s.values[p];
+            }
+            else
+            {
+                D(s.indices[p], k) = s.values[p];
+            }
+        }
+    }
+    return D;
+}
+
+void SparseMatrix::multiply(double alpha, ConstVectorView x, double beta, VectorView y) const
+{
+    if (x.dimension() != m_column_count || y.dimension() != m_row_count)
+    {
+        throw std::invalid_argument("Vector dimensions do not match the sparse matrix");
+    }
+    if (m_format == Format::csc)
+    {
+        // A strided vector is a one-column matrix whose row stride is the vector stride
+        multiply(alpha, ConstMatrixView(x.data(), x.dimension(), 1, x.stride()), beta,
+                 MatrixView(y.data(), y.dimension(), 1, y.stride()));
+        return;
+    }
+
+    const size_t *offsets = m_storage->offsets.data(), *indices = m_storage->indices.data();
+    const double *values = m_storage->values.data(), *xs = x.data();
+    TSMATH_INSTRUMENT(sparse_multiply, 2 * nonzeros(), (nonzeros() * 2 + m_column_count + 2 * m_row_count) * sizeof(double));
+    double *ys = y.data();
+    const size_t incx = x.stride(), incy = y.stride();
+    for_rows(m_row_count, nonzeros(), [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            double sum = 0.0;
+            for (size_t p = offsets[i]; p < offsets[i + 1]; p++)
+            {
+                sum += values[p] * xs[indices[p] * incx];
+            }
+            double &target = ys[i * incy];
+            target = beta == 0.0 ? alpha * sum : alpha * sum + beta * target;
+        }
+    });
+}
+
+void SparseMatrix::multiply(double alpha, ConstMatrixView X, double beta, MatrixView Y) const
+{
+    if (X.getRowCount() != m_column_count || Y.getRowCount() != m_row_count ||
+        X.getColumnCount() != Y.getColumnCount())
+    {
+        throw std::invalid_argument("Matrix dimensions do not match the sparse matrix");
+    }
+    const size_t k = X.getColumnCount(), ldx = X.stride(), ldy = Y.stride();
+    TSMATH_INSTRUMENT(sparse_multiply, 2 * nonzeros() * k,
+                      (nonzeros() * (1 + k) + nonzeros() + (m_column_count + 2 * m_row_count) * k) * sizeof(double));
+    const size_t *offsets = m_storage->offsets.data(), *indices = m_storage->indices.data();
+    const double *values = m_storage->values.data(), *x = X.data();
+    double *y = Y.data();
+    scale_rows(beta, y, m_row_count, k, ldy);
+    if (k == 0)
+    {
+        return;
+    }
+
+    if (m_format == Format::csr)
+    {
+        // Row i of Y gathers the rows of X selected by row i of A
+        for_rows(m_row_count, nonzeros() * k, [=](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                double *target = y + i * ldy;
+                for (size_t p = offsets[i]; p < offsets[i + 1]; p++)
+                {
+                    const double a = alpha * values[p];
+                    const double *source = x + indices[p] * ldx;
+                    for (size_t c = 0; c < k; c++)
+                    {
+                        target[c] += a * source[c];
+                    }
+                }
+            }
+        });
+        return;
+    }
+
+    // CSC scatters into arbitrary rows of Y: threads own column strips of Y when there are enough
+    // of them, otherwise they own ranges of columns of A and scatter into private copies
+    const size_t threads = parallel::thread_count(), strips = (k + COLUMN_GRAIN - 1) / COLUMN_GRAIN;
+    if (!parallel::worthwhile(nonzeros() * k, PARALLEL_WORK))
+    {
+        scatter_columns(offsets, indices, values, 0, m_column_count, alpha, x, ldx, k, y, ldy);
+    }
+    else if (strips >= threads)
+    {
+        parallel::parallel_for(strips, 1, [=](size_t begin, size_t end) {
+            for (size_t strip = begin; strip < end; strip++)
+            {
+                const size_t first = strip * COLUMN_GRAIN;
+                scatter_columns(offsets, indices, values, 0, m_column_count, alpha, x + first, ldx,
+                                std::min(COLUMN_GRAIN, k - first), y + first, ldy);
+            }
+        });
+    }
+    else
+    {
+        const size_t m = m_row_count, columns = m_column_count;
+        std::vector<std::vector<double>> partial(threads, std::vector<double>());
+        parallel::parallel_for(threads, 1, [&, m, columns, k](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++)
+            {
+                partial[t].assign(m * k, 0.0);
+                scatter_columns(offsets, indices, values, columns * t / threads, columns * (t + 1) / threads, alpha,
+                                x, ldx, k, partial[t].data(), k);
+            }
+        });
+        for_rows(m, m * k * threads, [&, k](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                double *target = y + i * ldy;
+                for (const std::vector<double> &buffer : partial)
+                {
+                    for (size_t c = 0; c < k; c++)
+                    {
+                        target[c] += buffer[i * k + c];
+                    }
+                }
+            }
+        });
+    }
+}
+
+Vector operator*(const SparseMatrix &A, ConstVectorView x)
+{
+    Vector y(A.getRowCount());
+    A.multiply(1.0, x, 0.0, y);
+    return y;
+}
+
+MATRIX operator*(const SparseMatrix &A, ConstMatrixView X)
+{
+    MATRIX Y(A.getRowCount(), X.getColumnCount());
+    A.multiply(1.0, X, 0.0, Y);
+    return Y;
+}
+
+MATRIX operator*(ConstMatrixView X, const SparseMatrix &A)
+{
+    if (X.getColumnCount() != A.getRowCount())
+    {
+        throw std::invalid_argument("Matrix dimensions do not match the sparse matrix");
+    }
+    const size_t m = X.getRowCount(), ldx = X.stride();
+    MATRIX Y(m, A.getColumnCount());
+    const size_t ldy = Y.stride();
+    const size_t *offsets = A.offsets().data(), *indices = A.indices().data();
+    const double *values = A.values().data(), *x = X.data();
+    double *y = Y.data();
+    const bool csr = A.format() == SparseMatrix::Format::csr;
+    const size_t majors = A.offsets().size() - 1;
+
+    // Every row of Y only depends on the same row of X, whatever the format of A
+    for_rows(m, A.nonzeros() * m, [=](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            const double *source = x + i * ldx;
+            double *target = y + i * ldy;
+            for (size_t k = 0; k < majors; k++)
+            {
+                if (csr)
+                {
+                    // Y(i, :) += X(i, k) A(k, :)
+                    const double s = source[k];
+                    for (size_t p = offsets[k]; p < offsets[k + 1]; p++)
+                    {
+                        target[indices[p]] += s * values[p];
+                    }
+                }
+                else
+                {
+                    // Y(i, k) = X(i, :) A(:, k)
+                    double sum = 0.0;
+                    for (size_t p = offsets[k]; p < offsets[k + 1]; p++)
+                    {
+                        sum += source[indices[p]] * values[p];
+                    }
+                    target[k] = sum;
+                }
+            }
+        }
+    });
+    return Y;
+}
+
+SparseMatrix operator*(const SparseMatrix &A, double scalar)
+{
+    auto storage = std::make_shared<SparseMatrix::Storage>(*A.m_storage);
+    for (double &value : storage->values)
+    {
+        value *= scalar;
+    }
+    return SparseMatrix(A.m_row_count, A.m_column_count, A.m_format, std::move(storage));
+}
+
+SparseMatrix operator*(double scalar, const SparseMatrix &A)
+{
+    return A * scalar;
+}
+
+namespace
+{
+    // sign_a * A + sign_b * B with A sparse.
+    MATRIX dense_sum(const SparseMatrix &A, double sign_a, ConstMatrixView B, double sign_b)
+    {
+        if (A.getRowCount() != B.getRowCount() || A.getColumnCount() != B.getColumnCount())
+        {
+            throw std::invalid_argument("Matrices must have the same dimensions");
+        }
+        MATRIX S(B.getRowCount(), B.getColumnCount());
+        for (size_t i = 0; i < B.getRowCount(); i++)
+        {
+            for (size_t j = 0; j < B.getColumnCount(); j++)
+            {
+                S(i, j) = sign_b * B(i, j);
+            }
+        }
+        const bool csr = A.format() == SparseMatrix::Format::csr;
+        for (size_t k = 0; k + 1 < A.offsets().size(); k++)
+        {
+            for (size_t p = A.offsets()[k]; p < A.offsets()[k + 1]; p++)
+            {
+                (csr ? S(k, A.indices()[p]) : S(A.indices()[p], k)) += sign_a * A.values()[p];
+            }
+        }
+        return S;
+    }
+}
+
+MATRIX operator+(const SparseMatrix &A, ConstMatrixView B)
+{
+    return dense_sum(A, 1.0, B, 1.0);
+}
+
+MATRIX operator+(ConstMatrixView A, const SparseMatrix &B)
+{
+    return dense_sum(B, 1.0, A, 1.0);
+}
+
+MATRIX operator-(const SparseMatrix &A, ConstMatrixView B)
+{
+    return dense_sum(A, 1.0, B, -1.0);
+}
+
+MATRIX operator-(ConstMatrixView A, const SparseMatrix &B)
+{
+    return dense_sum(B, -1.0, A, 1.0);
+}
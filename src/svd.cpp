@@ -0,0 +1,779 @@
+#include "../include/lin_alg.h"
+#include "../include/blas.h"
+#include "../include/householder.h"
+#include "../include/instrument.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace
+{
+    // Panel width of the blocked bidiagonalization.
+    constexpr size_t NB = 32;
+
+    // Rows handed to one thread in the matrix-vector products of the reduction.
+    constexpr size_t ROW_GRAIN = 128;
+
+    // Rotations are recorded for about this many sweeps over the whole bidiagonal, then applied
+    // together to column strips of U^T and V^T narrow enough to stay in L2 across the batch.
+    constexpr size_t ROTATION_BATCH = 32;
+    constexpr size_t ROTATION_STRIP_BYTES = 2048 * 1024;
+
+    // With at least this many rows per column, A is QR-factorized first and only R is bidiagonalized.
+    constexpr double TALL = 1.6;
+
+    // Implicit QR sweeps allowed per singular value before giving up.
+    constexpr size_t MAX_SWEEPS = 30;
+
+    const double EPS = std::numeric_limits<double>::epsilon();
+
+    // y = A x for the rows x columns block at a (rows lda apart), rows split over the pool.
+    void matvec(const double *a, size_t lda, size_t rows, size_t columns, const double *x, double *y)
+    {
+        parallel::parallel_for(rows, ROW_GRAIN, [=](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++)
+            {
+                y[r] = simd::dot(a + r * lda, x, columns);
+            }
+        });
+    }
+
+    // y = A^T x for the same block, streaming A by rows. Threads take row bands and accumulate
+    // into private copies of y.
+    void transposed_matvec(const double *a, size_t lda, size_t rows, size_t columns, const double *x, double *y)
+    {
+        const size_t bands = std::max<size_t>(1, std::min(parallel::thread_count(), rows / ROW_GRAIN));
+        std::vector<double> partial(bands * columns, 0.0);
+        parallel::parallel_for(bands, 1, [&](size_t begin, size_t end) {
+            for (size_t band = begin; band < end; band++)
+            {
+                double *acc = partial.data() + band * columns;
+                for (size_t r = rows * band / bands; r < rows * (band + 1) / bands; r++)
+                {
+                    const double *row = a + r * lda;
+                    const double xr = x[r];
+                    for (size_t j = 0; j < columns; j++)
+                    {
+                        acc[j] += xr * row[j];
+                    }
+                }
+            }
+        });
+        std::copy_n(partial.data(), columns, y);
+        for (size_t band = 1; band < bands; band++)
+        {
+            const double *acc = partial.data() + band * columns;
+            for (size_t j = 0; j < columns; j++)
+            {
+                y[j] += acc[j];
+            }
+        }
+    }
+
+    // Householder reduction Q^T A P = B of an m x n matrix (m >= n) to upper bidiagonal form.
+    struct Bidiagonal
+    {
+        // Left reflector c is stored below the diagonal of column c, right reflector c to the right
+        // of the superdiagonal of row c; their scalars are tauq[c] and taup[c].
+        MATRIX reflectors;
+
+        // Diagonal and superdiagonal of B, e[n - 1] being 0.
+        std::vector<double> d, e, tauq, taup;
+    };
+
+    // Blocked Golub-Kahan bidiagonalization. Within a panel every column and row is brought up to
+    // date with the panel's earlier reflectors through X and Y, which collect the tau-scaled
+    // products of A with the left and right vectors, and the trailing matrix then takes one
+    // rank-2jb update A -= U Y^T + X W as a single product.
+    Bidiagonal bidiagonalize(ConstMatrixView A)
+    {
+        const size_t m = A.getRowCount(), n = A.getColumnCount();
+        Bidiagonal b{MATRIX(A), std::vector<double>(n), std::vector<double>(n), std::vector<double>(n),
+                     std::vector<double>(n)};
+        double *a = b.reflectors.data();
+        const size_t lda = b.reflectors.stride();
+
+        MATRIX X(m, NB), Y(n, NB), left(m, 2 * NB), right(n, 2 * NB);
+        std::vector<double> u(m), y(m), t(NB);
+        for (size_t k = 0; k < n; k += NB)
+        {
+            const size_t jb = std::min(NB, n - k);
+            for (size_t i = 0; i < jb; i++)
+            {
+                const size_t c = k + i;
+
+                // Column c with the panel's earlier reflectors applied
+                for (size_t r = c; r < m && i > 0; r++)
+                {
+                    double sum = 0.0;
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        sum += a[r * lda + k + p] * Y(c, p) + X(r, p) * a[(k + p) * lda + c];
+                    }
+                    a[r * lda + c] -= sum;
+                }
+
+                b.tauq[c] = householder::generate(a + c * lda + c, m - c, lda);
+                b.d[c] = a[c * lda + c];
+                a[c * lda + c] = 1.0;
+                for (size_t r = 0; r < n; r++)
+                {
+                    Y(r, i) = 0.0;
+                }
+                for (size_t r = 0; r < m; r++)
+                {
+                    X(r, i) = 0.0;
+                }
+                if (c + 1 == n)
+                {
+                    break;
+                }
+
+                // Y(c+1:, i) = tauq (A^T u - Y (U^T u) - W^T (X^T u)) over columns c+1..n, where U and W
+                // hold the panel's left and right vectors
+                const size_t rows = m - c, columns = n - c - 1;
+                for (size_t r = 0; r < rows; r++)
+                {
+                    u[r] = a[(c + r) * lda + c];
+                }
+                transposed_matvec(a + c * lda + c + 1, lda, rows, columns, u.data(), y.data());
+                for (size_t p = 0; p < i; p++)
+                {
+                    double sum = 0.0;
+                    for (size_t r = 0; r < rows; r++)
+                    {
+                        sum += a[(c + r) * lda + k + p] * u[r];
+                    }
+                    t[p] = sum;
+                }
+                for (size_t j = 0; j < columns; j++)
+                {
+                    double sum = 0.0;
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        sum += Y(c + 1 + j, p) * t[p];
+                    }
+                    y[j] -= sum;
+                }
+                for (size_t p = 0; p < i; p++)
+                {
+                    double sum = 0.0;
+                    for (size_t r = 0; r < rows; r++)
+                    {
+                        sum += X(c + r, p) * u[r];
+                    }
+                    t[p] = sum;
+                }
+                for (size_t p = 0; p < i; p++)
+                {
+                    const double *w = a + (k + p) * lda + c + 1;
+                    for (size_t j = 0; j < columns; j++)
+                    {
+                        y[j] -= w[j] * t[p];
+                    }
+                }
+                for (size_t j = 0; j < columns; j++)
+                {
+                    Y(c + 1 + j, i) = b.tauq[c] * y[j];
+                }
+
+                // Row c with the panel's reflectors applied, the current left one included
+                double *row = a + c * lda + c + 1;
+                for (size_t j = 0; j < columns; j++)
+                {
+                    double sum = 0.0;
+                    for (size_t p = 0; p <= i; p++)
+                    {
+                        sum += Y(c + 1 + j, p) * a[c * lda + k + p];
+                    }
+                    row[j] -= sum;
+                }
+                for (size_t p = 0; p < i; p++)
+                {
+                    const double xp = X(c, p);
+                    const double *w = a + (k + p) * lda + c + 1;
+                    for (size_t j = 0; j < columns; j++)
+                    {
+                        row[j] -= w[j] * xp;
+                    }
+                }
+
+                b.taup[c] = householder::generate(row, columns, 1);
+                b.e[c] = row[0];
+                row[0] = 1.0;
+
+                // X(c+1:, i) = taup (A v - U (Y^T v) - X (W v)) over rows c+1..m
+                const size_t below = m - c - 1;
+                matvec(a + (c + 1) * lda + c + 1, lda, below, columns, row, y.data());
+                for (size_t p = 0; p <= i; p++)
+                {
+                    double sum = 0.0;
+                    for (size_t j = 0; j < columns; j++)
+                    {
+                        sum += Y(c + 1 + j, p) * row[j];
+                    }
+                    t[p] = sum;
+                }
+                for (size_t r = 0; r < below; r++)
+                {
+                    const double *ur = a + (c + 1 + r) * lda + k;
+                    double sum = 0.0;
+                    for (size_t p = 0; p <= i; p++)
+                    {
+                        sum += ur[p] * t[p];
+                    }
+                    y[r] -= sum;
+                }
+                for (size_t p = 0; p < i; p++)
+                {
+                    t[p] = simd::dot(a + (k + p) * lda + c + 1, row, columns);
+                }
+                for (size_t r = 0; r < below; r++)
+                {
+                    double sum = 0.0;
+                    for (size_t p = 0; p < i; p++)
+                    {
+                        sum += X(c + 1 + r, p) * t[p];
+                    }
+                    X(c + 1 + r, i) = b.taup[c] * (y[r] - sum);
+                }
+            }
+
+            // A22 -= U Y^T + X W as one product [U X] [Y W^T]^T of depth 2jb
+            const size_t s = k + jb;
+            if (s < n)
+            {
+                const size_t rows = m - s, columns = n - s;
+                for (size_t r = 0; r < rows; r++)
+                {
+                    for (size_t p = 0; p < jb; p++)
+                    {
+                        left(r, p) = a[(s + r) * lda + k + p];
+                        left(r, jb + p) = X(s + r, p);
+                    }
+                }
+                for (size_t j = 0; j < columns; j++)
+                {
+                    for (size_t p = 0; p < jb; p++)
+                    {
+                        right(j, p) = Y(s + j, p);
+                        right(j, jb + p) = a[(k + p) * lda + s + j];
+                    }
+                }
+                blas::parallel_gemm(blas::Op::none, blas::Op::transpose, rows, columns, 2 * jb, -1.0, left.data(),
+                                    left.stride(), right.data(), right.stride(), 1.0, a + s * lda + s, lda);
+            }
+
+            // The panel kept unit entries where B lives; put d and e back
+            for (size_t c = k; c < s; c++)
+            {
+                a[c * lda + c] = b.d[c];
+                if (c + 1 < n)
+                {
+                    a[c * lda + c + 1] = b.e[c];
+                }
+            }
+        }
+        return b;
+    }
+
+    // U = Q U, Q = H_0 H_1 ... being the left reflectors of b. Panels are applied last to first.
+    void apply_left_reflectors(const Bidiagonal &b, MatrixView U)
+    {
+        const size_t m = b.reflectors.getRowCount(), n = b.reflectors.getColumnCount();
+        MATRIX V(m, NB), G(NB, NB), T(NB, NB), W(NB, U.getColumnCount());
+        for (size_t panels = (n + NB - 1) / NB; panels-- > 0;)
+        {
+            const size_t k = panels * NB, jb = std::min(NB, n - k);
+            householder::unpack(b.reflectors.block(k, k, m - k, jb), jb, V);
+            householder::form_t(V, m - k, jb, b.tauq.data() + k, G, T.data(), T.stride());
+            householder::apply_block(V, m - k, jb, T.data(), T.stride(), U.block(k, 0, m - k, U.getColumnCount()), W,
+                                     false);
+        }
+    }
+
+    // V = P V, P = G_0 G_1 ... being the right reflectors of b, reflector c acting on rows c + 1..
+    void apply_right_reflectors(const Bidiagonal &b, MatrixView Z)
+    {
+        const size_t n = b.reflectors.getColumnCount(), count = n > 1 ? n - 1 : 0;
+        MATRIX V(n, NB), G(NB, NB), T(NB, NB), W(NB, Z.getColumnCount());
+        for (size_t panels = (count + NB - 1) / NB; panels-- > 0;)
+        {
+            const size_t k = panels * NB, jb = std::min(NB, count - k), rows = n - k - 1;
+
+            // The reflectors are stored along rows; lay them out as columns
+            for (size_t r = 0; r < rows; r++)
+            {
+                for (size_t p = 0; p < jb; p++)
+                {
+                    V(r, p) = r < p ? 0.0 : r == p ? 1.0 : b.reflectors(k + p, k + 1 + r);
+                }
+            }
+            householder::form_t(V, rows, jb, b.taup.data() + k, G, T.data(), T.stride());
+            householder::apply_block(V, rows, jb, T.data(), T.stride(), Z.block(k + 1, 0, rows, Z.getColumnCount()), W,
+                                     false);
+        }
+    }
+
+    // Plane rotation of rows x and y: x <- c x + s y, y <- c y - s x.
+    struct Rotation
+    {
+        size_t x, y;
+        double c, s;
+    };
+
+    // Applies the rotations in order to the columns [begin, end) of M.
+    void apply_rotations(const std::vector<Rotation> &rotations, MATRIX &M, size_t begin, size_t end)
+    {
+        for (const Rotation &g : rotations)
+        {
+            simd::rotate(M.data() + g.x * M.stride() + begin, M.data() + g.y * M.stride() + begin, g.c, g.s,
+                         end - begin);
+        }
+    }
+
+    // c, s and r with [c s; -s c] [f; g] = [r; 0].
+    void givens(double f, double g, double &c, double &s, double &r)
+    {
+        if (g == 0.0)
+        {
+            c = 1.0;
+            s = 0.0;
+            r = f;
+        }
+        else if (f == 0.0)
+        {
+            c = 0.0;
+            s = 1.0;
+            r = g;
+        }
+        else
+        {
+            r = std::hypot(f, g);
+            c = f / r;
+            s = g / r;
+        }
+    }
+
+    // Smaller singular value of the upper triangular [f g; 0 h], without over- or underflow.
+    double smaller_singular_value(double f, double g, double h)
+    {
+        const double fa = std::abs(f), ga = std::abs(g), ha = std::abs(h);
+        const double low = std::min(fa, ha), high = std::max(fa, ha);
+        if (low == 0.0)
+        {
+            return 0.0;
+        }
+        if (ga < high)
+        {
+            const double as = 1.0 + low / high, at = (high - low) / high, au = (ga / high) * (ga / high);
+            return low * 2.0 / (std::sqrt(as * as + au) + std::sqrt(at * at + au));
+        }
+        const double au = high / ga;
+        if (au == 0.0)
+        {
+            return low * high / ga;
+        }
+        const double as = 1.0 + low / high, at = (high - low) / high;
+        return 2.0 * low * au / (std::sqrt(1.0 + (as * au) * (as * au)) + std::sqrt(1.0 + (at * au) * (at * au)));
+    }
+
+    // Implicit-shift QR on the upper bidiagonal (d, e), e[i] coupling i and i + 1, so that
+    // B = U diag(d) V^T. The rotations are recorded and applied in batches to the rows of Ut = U^T
+    // and Vt = V^T (n x n, when given), one column strip per task, so each strip is read from memory
+    // once per batch instead of once per sweep. On return d holds the singular values in
+    // descending order. O(n^2) without vectors.
+    void bidiagonal_qr(double *d, double *e, size_t n, MATRIX *Ut, MATRIX *Vt)
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        double norm = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            norm = std::max({norm, std::abs(d[i]), i + 1 < n ? std::abs(e[i]) : 0.0});
+        }
+        const double small = EPS * norm;
+
+        std::vector<Rotation> left, right;
+        const size_t strip = std::max<size_t>(8, ROTATION_STRIP_BYTES / (n * sizeof(double))) / 8 * 8;
+        const auto flush = [&](bool all) {
+            if (!Ut || left.size() + right.size() < (all ? 1 : ROTATION_BATCH * n))
+            {
+                return;
+            }
+            parallel::parallel_for((n + strip - 1) / strip, 1, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; k++)
+                {
+                    const size_t first = k * strip, last = std::min(n, first + strip);
+                    apply_rotations(left, *Ut, first, last);
+                    apply_rotations(right, *Vt, first, last);
+                }
+            });
+            left.clear();
+            right.clear();
+        };
+
+        size_t sweeps = 0;
+        for (size_t hi = n - 1; hi > 0;)
+        {
+            // [p, hi] is the unreduced block ending at hi
+            size_t p = hi;
+            for (; p > 0; p--)
+            {
+                if (std::abs(e[p - 1]) <= EPS * (std::abs(d[p - 1]) + std::abs(d[p])))
+                {
+                    e[p - 1] = 0.0;
+                    break;
+                }
+            }
+            if (p == hi)
+            {
+                hi--;
+                continue;
+            }
+
+            // A negligible diagonal entry: rotate its row, or its column at the bottom, out of the block
+            size_t zero = p;
+            while (zero <= hi && std::abs(d[zero]) > small)
+            {
+                zero++;
+            }
+            if (zero <= hi)
+            {
+                d[zero] = 0.0;
+                double c, s, r;
+                if (zero < hi)
+                {
+                    double f = e[zero];
+                    e[zero] = 0.0;
+                    for (size_t j = zero + 1; j <= hi && f != 0.0; j++)
+                    {
+                        givens(d[j], f, c, s, r);
+                        d[j] = r;
+                        if (j < hi)
+                        {
+                            f = -s * e[j];
+                            e[j] *= c;
+                        }
+                        if (Ut)
+                        {
+                            left.push_back({zero, j, c, -s});
+                        }
+                    }
+                }
+                else
+                {
+                    double f = e[hi - 1];
+                    e[hi - 1] = 0.0;
+                    for (size_t j = hi; j-- > p && f != 0.0;)
+                    {
+                        givens(d[j], f, c, s, r);
+                        d[j] = r;
+                        if (j > p)
+                        {
+                            f = -s * e[j - 1];
+                            e[j - 1] *= c;
+                        }
+                        if (Vt)
+                        {
+                            right.push_back({j, hi, c, s});
+                        }
+                    }
+                }
+                flush(false);
+                continue;
+            }
+
+            if (++sweeps > MAX_SWEEPS * n)
+            {
+                throw std::runtime_error("Bidiagonal QR iteration did not converge");
+            }
+
+            // Shift by the smaller singular value of the trailing 2 x 2 block, dropped when negligible
+            double shift = smaller_singular_value(d[hi - 1], e[hi - 1], d[hi]);
+            if ((shift / d[p]) * (shift / d[p]) < EPS)
+            {
+                shift = 0.0;
+            }
+
+            // Chase the bulge down the block, alternating rotations from the right and the left
+            double f = (std::abs(d[p]) - shift) * (std::copysign(1.0, d[p]) + shift / d[p]);
+            double g = e[p];
+            for (size_t i = p; i < hi; i++)
+            {
+                double cr, sr, cl, sl, r;
+                givens(f, g, cr, sr, r);
+                if (i > p)
+                {
+                    e[i - 1] = r;
+                }
+                f = cr * d[i] + sr * e[i];
+                e[i] = cr * e[i] - sr * d[i];
+                g = sr * d[i + 1];
+                d[i + 1] *= cr;
+
+                givens(f, g, cl, sl, r);
+                d[i] = r;
+                f = cl * e[i] + sl * d[i + 1];
+                d[i + 1] = cl * d[i + 1] - sl * e[i];
+                if (i + 1 < hi)
+                {
+                    g = sl * e[i + 1];
+                    e[i + 1] *= cl;
+                }
+                if (Ut)
+                {
+                    right.push_back({i, i + 1, cr, sr});
+                    left.push_back({i, i + 1, cl, sl});
+                }
+            }
+            e[hi - 1] = f;
+            flush(false);
+        }
+        flush(true);
+
+        // Positive values in descending order
+        for (size_t i = 0; i < n; i++)
+        {
+            if (d[i] < 0.0)
+            {
+                d[i] = -d[i];
+                for (size_t j = 0; Vt && j < n; j++)
+                {
+                    (*Vt)(i, j) = -(*Vt)(i, j);
+                }
+            }
+        }
+        std::vector<size_t> order(n);
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) { return d[x] > d[y]; });
+        std::vector<double> sorted(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            sorted[i] = d[order[i]];
+        }
+        std::copy(sorted.begin(), sorted.end(), d);
+        if (Ut)
+        {
+            MATRIX U(n, n), V(n, n);
+            for (size_t i = 0; i < n; i++)
+            {
+                std::copy_n(Ut->data() + order[i] * Ut->stride(), n, U.data() + i * U.stride());
+                std::copy_n(Vt->data() + order[i] * Vt->stride(), n, V.data() + i * V.stride());
+            }
+            *Ut = U;
+            *Vt = V;
+        }
+    }
+
+    MATRIX identity(size_t n)
+    {
+        MATRIX I(n, n);
+        for (size_t i = 0; i < n; i++)
+        {
+            I(i, i) = 1.0;
+        }
+        return I;
+    }
+
+    // Thin SVD of A with rows >= columns. U (rows x columns) and V (columns x columns) are only
+    // formed when given.
+    void tall_svd(ConstMatrixView A, std::vector<double> &s, MATRIX *U, MATRIX *V)
+    {
+        const size_t m = A.getRowCount(), n = A.getColumnCount();
+        if (n > 0 && double(m) >= TALL * double(n))
+        {
+            // A = Q R: decompose the n x n R and map its left vectors through Q
+            factorization::QR qr(A);
+            const MATRIX R = qr.r();
+            if (!U)
+            {
+                tall_svd(R, s, nullptr, nullptr);
+                return;
+            }
+            MATRIX UR(0, 0), full(m, n);
+            tall_svd(R, s, &UR, V);
+            full.block(0, 0, n, n) = UR;
+            qr.apply_q(full);
+            *U = full;
+            return;
+        }
+
+        Bidiagonal b = bidiagonalize(A);
+        s = b.d;
+        if (!U)
+        {
+            bidiagonal_qr(s.data(), b.e.data(), n, nullptr, nullptr);
+            return;
+        }
+
+        MATRIX Ut = identity(n), Vt = identity(n);
+        bidiagonal_qr(s.data(), b.e.data(), n, &Ut, &Vt);
+
+        // A = Q B P^T with B = Ub S Vb^T, so U = Q [Ub; 0] and V = P Vb
+        MATRIX left(m, n), right = Vt.transpose();
+        left.block(0, 0, n, n) = Ut.transpose();
+        apply_left_reflectors(b, left);
+        apply_right_reflectors(b, right);
+        *U = left;
+        *V = right;
+    }
+
+    MATRIX transposed(ConstMatrixView A)
+    {
+        MATRIX T(A.getColumnCount(), A.getRowCount());
+        blas::transpose(A.getRowCount(), A.getColumnCount(), A.data(), A.stride(), T.data(), T.stride());
+        return T;
+    }
+
+    // A^+ = V diag(1 / s) U^T over the singular values above tolerance * s[0], as one product.
+    MATRIX truncated_inverse(const svd::Factors &f, double tolerance)
+    {
+        const size_t m = f.u.getRowCount(), n = f.v.getRowCount(), p = f.s.dimension();
+        if (tolerance < 0.0)
+        {
+            tolerance = double(std::max(m, n)) * EPS;
+        }
+        size_t rank = 0;
+        while (rank < p && f.s[rank] > tolerance * f.s[0])
+        {
+            rank++;
+        }
+
+        MATRIX scaled(n, rank), inverse(n, m);
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t k = 0; k < rank; k++)
+            {
+                scaled(i, k) = f.v(i, k) / f.s[k];
+            }
+        }
+        blas::parallel_gemm(blas::Op::none, blas::Op::transpose, n, m, rank, 1.0, scaled.data(), scaled.stride(),
+                            f.u.data(), f.u.stride(), 0.0, inverse.data(), inverse.stride());
+        return inverse;
+    }
+}
+
+svd::Factors svd::thin(ConstMatrixView A)
+{
+    const size_t m = A.getRowCount(), n = A.getColumnCount();
+    [[maybe_unused]] const size_t p = std::min(m, n), q = std::max(m, n);
+    // Nominal Golub-Kahan-Reinsch counts, the QR sweeps vary with the spectrum
+    TSMATH_INSTRUMENT(svd, 6 * q * p * p + 20 * p * p * p, (2 * m * n + m * p + p * n) * sizeof(double));
+    std::vector<double> s;
+    MATRIX U(0, 0), V(0, 0);
+    if (m >= n)
+    {
+        tall_svd(A, s, &U, &V);
+    }
+    else
+    {
+        // A^T = V S U^T
+        tall_svd(transposed(A), s, &V, &U);
+    }
+    return Factors{U, Vector(s), V};
+}
+
+std::vector<MATRIX> svd::svd(ConstMatrixView A)
+{
+    Factors f = thin(A);
+    const size_t p = f.s.dimension();
+    MATRIX S(p, p);
+    for (size_t i = 0; i < p; i++)
+    {
+        S(i, i) = f.s[i];
+    }
+    return {f.u, S, f.v};
+}
+
+Vector svd::singular_values(ConstMatrixView A)
+{
+    [[maybe_unused]] const size_t p = std::min(A.getRowCount(), A.getColumnCount()), q = std::max(A.getRowCount(), A.getColumnCount());
+    TSMATH_INSTRUMENT(svd, 4 * q * p * p - 4 * p * p * p / 3, 2 * p * q * sizeof(double));
+    std::vector<double> s;
+    if (A.getRowCount() >= A.getColumnCount())
+    {
+        tall_svd(A, s, nullptr, nullptr);
+    }
+    else
+    {
+        tall_svd(transposed(A), s, nullptr, nullptr);
+    }
+    return Vector(s);
+}
+
+svd::Factors svd::randomized(ConstMatrixView A, size_t rank, size_t oversampling, size_t power_iterations,
+                             unsigned long seed)
+{
+    const size_t m = A.getRowCount(), n = A.getColumnCount();
+    if (rank == 0 || rank > std::min(m, n))
+    {
+        throw std::invalid_argument("Requested rank must be between 1 and the smaller matrix dimension");
+    }
+    const size_t l = std::min(rank + oversampling, std::min(m, n));
+    TSMATH_INSTRUMENT(randomized_svd, (4 + 4 * power_iterations) * m * n * l, (2 + 2 * power_iterations) * m * n * sizeof(double));
+
+    // Y = A Omega for a Gaussian n x l Omega
+    std::mt19937_64 generator(seed);
+    std::normal_distribution<double> normal;
+    MATRIX omega(n, l), Y(m, l), Z(n, l);
+    for (size_t i = 0; i < n; i++)
+    {
+        for (size_t j = 0; j < l; j++)
+        {
+            omega(i, j) = normal(generator);
+        }
+    }
+    blas::parallel_gemm(blas::Op::none, blas::Op::none, m, l, n, 1.0, A.data(), A.stride(), omega.data(),
+                        omega.stride(), 0.0, Y.data(), Y.stride());
+
+    // Power iterations, re-orthonormalized each half step so the small singular values are not lost
+    for (size_t q = 0; q < power_iterations; q++)
+    {
+        const MATRIX Qy = factorization::QR(Y).q();
+        blas::parallel_gemm(blas::Op::transpose, blas::Op::none, n, l, m, 1.0, A.data(), A.stride(), Qy.data(),
+                            Qy.stride(), 0.0, Z.data(), Z.stride());
+        const MATRIX Qz = factorization::QR(Z).q();
+        blas::parallel_gemm(blas::Op::none, blas::Op::none, m, l, n, 1.0, A.data(), A.stride(), Qz.data(),
+                            Qz.stride(), 0.0, Y.data(), Y.stride());
+    }
+
+    // B = Q^T A is l x n; decompose its tall transpose B^T = A^T Q = Ub S Vb^T, so A ~ (Q Vb) S Ub^T
+    const MATRIX Q = factorization::QR(Y).q();
+    blas::parallel_gemm(blas::Op::transpose, blas::Op::none, n, l, m, 1.0, A.data(), A.stride(), Q.data(), Q.stride(),
+                        0.0, Z.data(), Z.stride());
+    std::vector<double> s;
+    MATRIX Ub(0, 0), Vb(0, 0);
+    tall_svd(Z, s, &Ub, &Vb);
+
+    MATRIX U(m, rank), V(n, rank);
+    blas::parallel_gemm(blas::Op::none, blas::Op::none, m, rank, l, 1.0, Q.data(), Q.stride(), Vb.data(), Vb.stride(),
+                        0.0, U.data(), U.stride());
+    for (size_t i = 0; i < n; i++)
+    {
+        std::copy_n(Ub.data() + i * Ub.stride(), rank, V.data() + i * V.stride());
+    }
+    s.resize(rank);
+    return Factors{U, Vector(s), V};
+}
+
+MATRIX svd::pseudo_inverse(ConstMatrixView A, double tolerance)
+{
+    if (A.getRowCount() == 0 || A.getColumnCount() == 0)
+    {
+        return MATRIX(A.getColumnCount(), A.getRowCount());
+    }
+    return truncated_inverse(thin(A), tolerance);
+}
+
+MATRIX svd::low_rank_pseudo_inverse(ConstMatrixView A, size_t rank, double tolerance)
+{
+    return truncated_inverse(randomized(A, rank), tolerance);
+}
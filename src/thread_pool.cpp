@@ -0,0 +1,355 @@
+#include "../include/thread_pool.h"
+#include "../include/arena.h"
+#include "../include/instrument.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    // Chunks per thread handed out by parallel_for, so that threads finishing early take on the rest.
+    constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    // Set on pool workers so nested parallel_for calls do not wait on the pool they run in.
+    thread_local bool inside_worker = false;
+
+    thread_local parallel::Policy current_policy = parallel::Policy::automatic;
+
+    class ThreadPool
+    {
+    public:
+        ThreadPool(size_t workers, bool pinned) : m_queues(workers)
+        {
+            for (auto &queue : m_queues)
+            {
+                queue.reset(new Queue());
+            }
+            for (size_t i = 0; i < workers; i++)
+            {
+                m_workers.emplace_back([this, i] { run(i); });
+                if (pinned)
+                {
+                    pin(m_workers.back(), i + 1);
+                }
+            }
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_sleep_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            for (auto &worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+        size_t worker_count() const noexcept
+        {
+            return m_workers.size();
+        }
+
+        // Queues a task on the workers in turn.
+        void submit(std::function<void()> task)
+        {
+            Queue &queue = *m_queues[m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size()];
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                queue.tasks.push_back(std::move(task));
+            }
+            m_queued.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            }
+            m_wake.notify_one();
+        }
+
+        // Runs one queued task, the newest of queue 'home' first, else the oldest of another
+        // queue. Returns false when every queue is empty.
+        bool run_one(size_t home)
+        {
+            std::function<void()> task;
+            const size_t count = m_queues.size();
+            for (size_t k = 0; k < count && !task; k++)
+            {
+                Queue &queue = *m_queues[(home + k) % count];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty())
+                {
+                    continue;
+                }
+                if (k == 0)
+                {
+                    task = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    task = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+            }
+            if (!task)
+            {
+                return false;
+            }
+            m_queued.fetch_sub(1);
+            task();
+            return true;
+        }
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        void run(size_t index)
+        {
+            inside_worker = true;
+            for (;;)
+            {
+                if (run_one(index))
+                {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(m_sleep_mutex);
+                m_wake.wait(lock, [this] { return m_stopping || m_queued.load() > 0; });
+                if (m_stopping && m_queued.load() == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+        static void pin(std::thread &thread, size_t cpu)
+        {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+            (void)thread;
+            (void)cpu;
+#endif
+        }
+
+        std::vector<std::unique_ptr<Queue>> m_queues;
+        std::vector<std::thread> m_workers;
+        std::atomic<size_t> m_next{0};
+        std::atomic<size_t> m_queued{0};
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+    };
+
+    // Pool configuration; the pool itself is created on first use and replaced by the setters. Every
+    // parallel_for holds a reference to the pool it submits to, so a replaced pool stays alive, and is
+    // only joined, once the calls still running on it have returned.
+    std::mutex pool_mutex;
+    std::shared_ptr<ThreadPool> pool_instance;
+    std::atomic<size_t> pool_threads{0};
+    size_t requested_threads = 0;
+    bool pinning = false;
+
+    size_t default_thread_count()
+    {
+        if (const char *variable = std::getenv("TSMATH_NUM_THREADS"))
+        {
+            const long threads = std::atol(variable);
+            if (threads > 0)
+            {
+                return static_cast<size_t>(threads);
+            }
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Replaces the pool under pool_mutex. The old one goes when its last parallel_for returns (here
+    // when none is running); its workers only finish queued tasks, none of which takes pool_mutex.
+    void rebuild()
+    {
+        const size_t threads = requested_threads == 0 ? default_thread_count() : requested_threads;
+        pool_instance = std::make_shared<ThreadPool>(threads - 1, pinning);
+        pool_threads.store(threads);
+    }
+
+    std::shared_ptr<ThreadPool> pool()
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (!pool_instance)
+        {
+            rebuild();
+        }
+        return pool_instance;
+    }
+
+    // State of one parallel_for call, shared with the pool tasks it submits. Chunks are claimed in
+    // order from 'next' by the caller and by those tasks, so a waiting caller only ever runs chunks of
+    // its own call. Tasks that start after the last chunk was claimed return without touching 'body',
+    // which belongs to the caller; the shared_ptr keeps the rest alive for them.
+    struct Call
+    {
+        const std::function<void(size_t, size_t)> *body;
+        size_t count, chunk, chunks;
+        std::atomic<size_t> next{0};
+
+        // Thread-local state of the caller, reinstalled around the chunks run on pool threads.
+        parallel::Policy policy;
+        std::pmr::memory_resource *resource;
+        instrument::Kernel kernel;
+
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t finished = 0;
+        std::exception_ptr error;
+
+        // Claims and runs chunks until none is left.
+        void run_chunks()
+        {
+            for (size_t c = next.fetch_add(1); c < chunks; c = next.fetch_add(1))
+            {
+                const size_t begin = c * chunk, end = std::min(count, begin + chunk);
+                std::exception_ptr failure;
+                try
+                {
+                    (*body)(begin, end);
+                }
+                catch (...)
+                {
+                    failure = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (failure && !error)
+                {
+                    error = failure;
+                }
+                if (++finished == chunks)
+                {
+                    done.notify_one();
+                }
+            }
+        }
+
+        // run_chunks on a pool thread, under the caller's policy, memory resource and kernel.
+        void help()
+        {
+            parallel::ScopedPolicy scope(policy);
+            memory::ScopedResource allocations(resource);
+            const instrument::Kernel previous = instrument::enter(kernel);
+            run_chunks();
+            instrument::leave(previous);
+        }
+    };
+}
+
+parallel::Policy parallel::policy() noexcept
+{
+    return current_policy;
+}
+
+parallel::ScopedPolicy::ScopedPolicy(Policy policy) noexcept : m_previous(current_policy)
+{
+    current_policy = policy;
+}
+
+parallel::ScopedPolicy::~ScopedPolicy()
+{
+    current_policy = m_previous;
+}
+
+void parallel::set_thread_count(size_t threads)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    requested_threads = threads;
+    rebuild();
+}
+
+void parallel::set_pinning(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    pinning = enabled;
+    rebuild();
+}
+
+size_t parallel::thread_count() noexcept
+{
+    if (current_policy == Policy::serial)
+    {
+        return 1;
+    }
+    const size_t threads = pool_threads.load();
+    return threads != 0 ? threads : pool()->worker_count() + 1;
+}
+
+bool parallel::worthwhile(size_t work, size_t threshold) noexcept
+{
+    switch (current_policy)
+    {
+    case Policy::serial:
+        return false;
+    case Policy::parallel:
+        return thread_count() > 1;
+    default:
+        return work >= threshold && thread_count() > 1;
+    }
+}
+
+void parallel::parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &body)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grain = std::max<size_t>(grain, 1);
+    const size_t threads = thread_count();
+    size_t chunks = std::min(threads * CHUNKS_PER_THREAD, (count + grain - 1) / grain);
+    if (threads <= 1 || chunks <= 1 || inside_worker)
+    {
+        body(0, count);
+        return;
+    }
+
+    auto call = std::make_shared<Call>();
+    call->body = &body;
+    call->count = count;
+    call->chunk = (count + chunks - 1) / chunks;
+    call->chunks = (count + call->chunk - 1) / call->chunk;
+    call->policy = current_policy;
+    call->resource = memory::current_resource();
+    call->kernel = instrument::current();
+
+    // One helper task per worker at most, each running chunks until they run out; the caller takes
+    // part, then sleeps until the chunks claimed by workers are done
+    const std::shared_ptr<ThreadPool> workers = pool();
+    const size_t helpers = std::min(call->chunks - 1, workers->worker_count());
+    for (size_t h = 0; h < helpers; h++)
+    {
+        workers->submit([call] { call->help(); });
+    }
+    call->run_chunks();
+
+    std::unique_lock<std::mutex> lock(call->mutex);
+    call->done.wait(lock, [&call] { return call->finished == call->chunks; });
+    if (call->error)
+    {
+        std::rethrow_exception(call->error);
+    }
+}
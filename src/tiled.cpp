@@ -0,0 +1,993 @@
+#include "../include/tiled.h"
+#include "../include/arena.h"
+#include "../include/binary_io.h"
+#include "../include/blas.h"
+#include "../include/householder.h"
+#include "../include/lin_alg.h"
+#include "../include/triangular.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#define TSMATH_HAS_PREAD 1
+#else
+#define TSMATH_HAS_PREAD 0
+#endif
+
+namespace
+{
+    // Spare tile buffers kept after evictions, so that a steady stream of tiles does not reallocate.
+    constexpr size_t SPARES = 2;
+
+    [[noreturn]] void fail(const std::string &path, const char *what)
+    {
+        throw std::runtime_error("tiled: " + path + ": " + what);
+    }
+
+    // Whole-range pread/pwrite, retried over short transfers and interrupts.
+    void transfer(int fd, char *data, size_t bytes, std::uint64_t offset, bool writing, const std::string &path)
+    {
+#if TSMATH_HAS_PREAD
+        while (bytes != 0)
+        {
+            const ssize_t done = writing ? pwrite(fd, data, bytes, static_cast<off_t>(offset))
+                                         : pread(fd, data, bytes, static_cast<off_t>(offset));
+            if (done < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (done <= 0)
+            {
+                fail(path, writing ? "write failed" : "read failed");
+            }
+            data += done;
+            bytes -= static_cast<size_t>(done);
+            offset += static_cast<std::uint64_t>(done);
+        }
+#else
+        fail(path, "tiled matrices need a POSIX system");
+#endif
+    }
+}
+
+struct TiledMatrix::Entry
+{
+    enum class State
+    {
+        loading,
+        ready,
+        writing
+    };
+
+    AlignedBuffer data;
+    size_t index = 0;
+    State state = State::loading;
+    bool dirty = false;
+    size_t pins = 0;
+    std::list<size_t>::iterator age;
+};
+
+// Tile cache of one file. The mutex guards the entries, the LRU list, the spares and the prefetch
+// queue; tiles are read and written with it released, their entries marked loading or writing so
+// that other requests for them wait on 'changed'.
+struct TiledMatrix::Cache
+{
+    int fd = -1;
+    std::string path;
+    binary::Header header{};
+    size_t tile = 0, tile_rows = 0, tile_columns = 0, capacity = 0;
+
+    // cache_bytes, and the part of it reserved for working memory outside the cache
+    size_t budget = 0, reserved = 0;
+
+    std::mutex mutex;
+    std::condition_variable changed, work;
+    std::unordered_map<size_t, Entry> entries;
+    std::list<size_t> lru;  // least recently pinned first
+    std::vector<AlignedBuffer> spares;
+
+    std::deque<size_t> queue;
+    std::thread prefetcher;
+    bool stopping = false;
+
+    Cache(int descriptor, std::string file, const binary::Header &layout, size_t cache_bytes)
+        : fd(descriptor), path(std::move(file)), header(layout), tile(layout.stride), budget(cache_bytes)
+    {
+        tile_rows = (header.rows + tile - 1) / tile;
+        tile_columns = (header.columns + tile - 1) / tile;
+        resize();
+    }
+
+    // Recomputes the capacity from the unreserved budget. Called with the mutex held (or unshared).
+    void resize() noexcept
+    {
+        capacity = std::max<size_t>(4, (budget - std::min(reserved, budget)) / (tile * tile * sizeof(double)));
+    }
+
+    void reserve(size_t bytes)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        reserved += bytes;
+        resize();
+        make_room(lock);
+    }
+
+    void unreserve(size_t bytes) noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reserved -= std::min(bytes, reserved);
+        resize();
+    }
+
+    ~Cache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work.notify_all();
+        if (prefetcher.joinable())
+        {
+            prefetcher.join();
+        }
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+#if TSMATH_HAS_PREAD
+        ::close(fd);
+#endif
+    }
+
+    std::uint64_t offset(size_t index) const noexcept
+    {
+        return header.data_offset + std::uint64_t(index) * tile * tile * sizeof(double);
+    }
+
+    void io(size_t index, double *data, bool writing)
+    {
+        transfer(fd, reinterpret_cast<char *>(data), tile * tile * sizeof(double), offset(index), writing, path);
+    }
+
+    // Finds or loads a tile, pinning it (pin = 0 for a prefetch) and marking it dirty if asked.
+    Entry &acquire(size_t index, size_t pin, bool dirty)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            const auto found = entries.find(index);
+            if (found == entries.end())
+            {
+                break;
+            }
+            Entry &entry = found->second;
+            if (entry.state == Entry::State::ready)
+            {
+                lru.splice(lru.end(), lru, entry.age);
+                entry.pins += pin;
+                entry.dirty = entry.dirty || dirty;
+                return entry;
+            }
+            changed.wait(lock);
+        }
+
+        Entry &entry = entries[index];
+        entry.index = index;
+        entry.pins = pin;
+        entry.age = lru.insert(lru.end(), index);
+        try
+        {
+            make_room(lock);
+        }
+        catch (...)
+        {
+            discard(entry);
+            throw;
+        }
+        AlignedBuffer buffer;
+        if (!spares.empty())
+        {
+            buffer = std::move(spares.back());
+            spares.pop_back();
+        }
+        lock.unlock();
+
+        try
+        {
+            if (buffer.size() == 0)
+            {
+                buffer = AlignedBuffer(tile * tile, memory::heap());
+            }
+            io(index, buffer.data(), false);
+        }
+        catch (...)
+        {
+            lock.lock();
+            discard(entry);
+            throw;
+        }
+
+        lock.lock();
+        entry.data = std::move(buffer);
+        entry.state = Entry::State::ready;
+        entry.dirty = dirty;
+        changed.notify_all();
+        return entry;
+    }
+
+    void release(Entry &entry) noexcept
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entry.pins--;
+    }
+
+    // Drops an entry, keeping its buffer as a spare. Called with the mutex held.
+    void discard(Entry &entry)
+    {
+        if (entry.data.size() != 0 && spares.size() < SPARES)
+        {
+            spares.push_back(std::move(entry.data));
+        }
+        lru.erase(entry.age);
+        entries.erase(entry.index);
+        changed.notify_all();
+    }
+
+    // Evicts the least recently pinned idle tiles, writing dirty ones back, until the cache is within
+    // its capacity or everything left is pinned or in flight.
+    void make_room(std::unique_lock<std::mutex> &lock)
+    {
+        while (entries.size() > capacity)
+        {
+            const auto victim = std::find_if(lru.begin(), lru.end(), [this](size_t index) {
+                const Entry &entry = entries.at(index);
+                return entry.pins == 0 && entry.state == Entry::State::ready;
+            });
+            if (victim == lru.end())
+            {
+                return;
+            }
+            Entry &entry = entries.at(*victim);
+            if (entry.dirty)
+            {
+                write_back(entry, lock);
+            }
+            discard(entry);
+        }
+    }
+
+    // Writes a dirty idle tile with the mutex released. Called with the mutex held.
+    void write_back(Entry &entry, std::unique_lock<std::mutex> &lock)
+    {
+        entry.state = Entry::State::writing;
+        lock.unlock();
+        try
+        {
+            io(entry.index, entry.data.data(), true);
+        }
+        catch (...)
+        {
+            lock.lock();
+            entry.state = Entry::State::ready;
+            changed.notify_all();
+            throw;
+        }
+        lock.lock();
+        entry.state = Entry::State::ready;
+        entry.dirty = false;
+        changed.notify_all();
+    }
+
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<size_t> dirty;
+        for (const auto &entry : entries)
+        {
+            if (entry.second.dirty)
+            {
+                dirty.push_back(entry.first);
+            }
+        }
+        for (size_t index : dirty)
+        {
+            // Entries are only erased by the driving thread or when idle and clean
+            const auto found = entries.find(index);
+            if (found != entries.end() && found->second.dirty && found->second.state == Entry::State::ready)
+            {
+                write_back(found->second, lock);
+            }
+        }
+    }
+
+    void prefetch(size_t index)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (entries.count(index) != 0 || std::find(queue.begin(), queue.end(), index) != queue.end())
+            {
+                return;
+            }
+            // Reading further ahead than half the cache would evict tiles before their use
+            if (queue.size() >= capacity / 2)
+            {
+                queue.pop_front();
+            }
+            queue.push_back(index);
+            if (!prefetcher.joinable())
+            {
+                prefetcher = std::thread([this] { prefetch_loop(); });
+            }
+        }
+        work.notify_one();
+    }
+
+    void prefetch_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            work.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            const size_t index = queue.front();
+            queue.pop_front();
+            if (entries.count(index) != 0)
+            {
+                continue;
+            }
+            lock.unlock();
+            try
+            {
+                acquire(index, 0, false);
+            }
+            catch (...)
+            {
+                // The error comes back when the tile is pinned
+            }
+            lock.lock();
+        }
+    }
+};
+
+TiledMatrix::Tile::Tile(Cache *cache, Entry *entry, MatrixView view) noexcept
+    : m_cache(cache), m_entry(entry), m_view(view)
+{
+}
+
+TiledMatrix::Tile::Tile(Tile &&other) noexcept
+    : m_cache(std::exchange(other.m_cache, nullptr)), m_entry(other.m_entry), m_view(other.m_view)
+{
+}
+
+TiledMatrix::Tile::~Tile()
+{
+    if (m_cache != nullptr)
+    {
+        m_cache->release(*m_entry);
+    }
+}
+
+MatrixView TiledMatrix::Tile::view() const noexcept
+{
+    return m_view;
+}
+
+TiledMatrix::TiledMatrix(std::unique_ptr<Cache> cache) noexcept : m_cache(std::move(cache)) {}
+
+TiledMatrix::TiledMatrix(TiledMatrix &&other) noexcept = default;
+
+TiledMatrix &TiledMatrix::operator=(TiledMatrix &&other) noexcept = default;
+
+TiledMatrix::~TiledMatrix() = default;
+
+TiledMatrix TiledMatrix::create(const std::string &path, size_t rows, size_t columns, size_t tile, size_t cache_bytes)
+{
+    binary::Header header = binary::make_header(rows, columns);
+    header.layout = binary::Layout::tiled;
+    header.stride = (std::max<size_t>(tile, 1) + 7) / 8 * 8;
+    const std::uint64_t tiles = std::uint64_t((rows + header.stride - 1) / header.stride) *
+                                ((columns + header.stride - 1) / header.stride);
+#if TSMATH_HAS_PREAD
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        fail(path, "cannot create");
+    }
+    try
+    {
+        transfer(fd, reinterpret_cast<char *>(&header), sizeof(header), 0, true, path);
+        // Unwritten tiles read back as zeros
+        if (ftruncate(fd, static_cast<off_t>(header.data_offset + tiles * header.stride * header.stride * sizeof(double))) != 0)
+        {
+            fail(path, "cannot allocate");
+        }
+    }
+    catch (...)
+    {
+        ::close(fd);
+        throw;
+    }
+    return TiledMatrix(std::unique_ptr<Cache>(new Cache(fd, path, header, cache_bytes)));
+#else
+    static_cast<void>(tiles);
+    fail(path, "tiled matrices need a POSIX system");
+#endif
+}
+
+TiledMatrix TiledMatrix::open(const std::string &path, size_t cache_bytes)
+{
+    const binary::Header header = binary::read_header(path);
+    if (header.layout != binary::Layout::tiled)
+    {
+        fail(path, "holds a row-major matrix, load it as a MATRIX");
+    }
+#if TSMATH_HAS_PREAD
+    const int fd = ::open(path.c_str(), O_RDWR);
+    if (fd < 0)
+    {
+        fail(path, "cannot open");
+    }
+    return TiledMatrix(std::unique_ptr<Cache>(new Cache(fd, path, header, cache_bytes)));
+#else
+    static_cast<void>(cache_bytes);
+    fail(path, "tiled matrices need a POSIX system");
+#endif
+}
+
+size_t TiledMatrix::getRowCount() const noexcept
+{
+    return m_cache->header.rows;
+}
+
+size_t TiledMatrix::getColumnCount() const noexcept
+{
+    return m_cache->header.columns;
+}
+
+size_t TiledMatrix::tile_size() const noexcept
+{
+    return m_cache->tile;
+}
+
+size_t TiledMatrix::tile_rows() const noexcept
+{
+    return m_cache->tile_rows;
+}
+
+size_t TiledMatrix::tile_columns() const noexcept
+{
+    return m_cache->tile_columns;
+}
+
+size_t TiledMatrix::tile_height(size_t I) const noexcept
+{
+    return std::min(m_cache->tile, getRowCount() - I * m_cache->tile);
+}
+
+size_t TiledMatrix::tile_width(size_t J) const noexcept
+{
+    return std::min(m_cache->tile, getColumnCount() - J * m_cache->tile);
+}
+
+size_t TiledMatrix::cache_capacity() const noexcept
+{
+    std::lock_guard<std::mutex> lock(m_cache->mutex);
+    return m_cache->capacity;
+}
+
+void TiledMatrix::reserve_budget(size_t bytes)
+{
+    m_cache->reserve(bytes);
+}
+
+void TiledMatrix::release_budget(size_t bytes) noexcept
+{
+    m_cache->unreserve(bytes);
+}
+
+TiledMatrix::Tile TiledMatrix::read_tile(size_t I, size_t J) const
+{
+    if (I >= tile_rows() || J >= tile_columns())
+    {
+        throw std::out_of_range("Tile index out of range");
+    }
+    Entry &entry = m_cache->acquire(I * tile_columns() + J, 1, false);
+    return Tile(m_cache.get(), &entry, MatrixView(entry.data.data(), tile_height(I), tile_width(J), tile_size()));
+}
+
+TiledMatrix::Tile TiledMatrix::write_tile(size_t I, size_t J)
+{
+    if (I >= tile_rows() || J >= tile_columns())
+    {
+        throw std::out_of_range("Tile index out of range");
+    }
+    Entry &entry = m_cache->acquire(I * tile_columns() + J, 1, true);
+    return Tile(m_cache.get(), &entry, MatrixView(entry.data.data(), tile_height(I), tile_width(J), tile_size()));
+}
+
+void TiledMatrix::prefetch(size_t I, size_t J) const
+{
+    if (I < tile_rows() && J < tile_columns())
+    {
+        m_cache->prefetch(I * tile_columns() + J);
+    }
+}
+
+namespace
+{
+    // Calls visit(tile, tile block, block rows/columns) for every tile a block overlaps, in row-major
+    // tile order, prefetching the next tile first.
+    template <typename Pin, typename Visit>
+    void for_each_tile(const TiledMatrix &A, size_t row, size_t column, size_t rows, size_t columns, const Pin &pin,
+                       const Visit &visit)
+    {
+        if (row + rows > A.getRowCount() || column + columns > A.getColumnCount())
+        {
+            throw std::out_of_range("Block exceeds the matrix");
+        }
+        if (rows == 0 || columns == 0)
+        {
+            return;
+        }
+        const size_t b = A.tile_size();
+        const size_t I0 = row / b, I1 = (row + rows - 1) / b, J0 = column / b, J1 = (column + columns - 1) / b;
+        for (size_t I = I0; I <= I1; I++)
+        {
+            for (size_t J = J0; J <= J1; J++)
+            {
+                J < J1 ? A.prefetch(I, J + 1) : A.prefetch(I + 1, J0);
+                // Overlap of the block with tile (I, J), in matrix coordinates
+                const size_t r0 = std::max(row, I * b), r1 = std::min(row + rows, I * b + b);
+                const size_t c0 = std::max(column, J * b), c1 = std::min(column + columns, J * b + b);
+                TiledMatrix::Tile tile = pin(I, J);
+                visit(tile.view().block(r0 - I * b, c0 - J * b, r1 - r0, c1 - c0), r0 - row, c0 - column);
+            }
+        }
+    }
+
+    void copy(ConstMatrixView source, MatrixView target)
+    {
+        for (size_t i = 0; i < source.getRowCount(); i++)
+        {
+            std::copy_n(source.data() + i * source.stride(), source.getColumnCount(), target.data() + i * target.stride());
+        }
+    }
+}
+
+void TiledMatrix::read_block(size_t row, size_t column, MatrixView block) const
+{
+    for_each_tile(*this, row, column, block.getRowCount(), block.getColumnCount(),
+                  [this](size_t I, size_t J) { return read_tile(I, J); },
+                  [&block](MatrixView part, size_t i, size_t j) {
+                      copy(part, block.block(i, j, part.getRowCount(), part.getColumnCount()));
+                  });
+}
+
+void TiledMatrix::write_block(size_t row, size_t column, ConstMatrixView block)
+{
+    for_each_tile(*this, row, column, block.getRowCount(), block.getColumnCount(),
+                  [this](size_t I, size_t J) { return write_tile(I, J); },
+                  [&block](MatrixView part, size_t i, size_t j) {
+                      copy(block.block(i, j, part.getRowCount(), part.getColumnCount()), part);
+                  });
+}
+
+void TiledMatrix::flush()
+{
+    m_cache->flush();
+}
+
+namespace
+{
+    // Working memory of a factorization charged to its matrix's cache budget while the object lives.
+    class Budget
+    {
+    public:
+        Budget(TiledMatrix &A, size_t bytes) : m_matrix(A), m_bytes(bytes) { A.reserve_budget(bytes); }
+        ~Budget() { m_matrix.release_budget(m_bytes); }
+        Budget(const Budget &) = delete;
+        Budget &operator=(const Budget &) = delete;
+
+    private:
+        TiledMatrix &m_matrix;
+        size_t m_bytes;
+    };
+
+    void require_same_tiles(const TiledMatrix &A, const TiledMatrix &B)
+    {
+        if (A.tile_size() != B.tile_size())
+        {
+            throw std::invalid_argument("Tiled matrices must share their tile size");
+        }
+    }
+
+    // Tile after (I, J) in column-major order over the tiles of column J from row 'first' on, then
+    // the tiles of the next column from its diagonal: the order the factorizations read L and V in.
+    void prefetch_below(const TiledMatrix &A, size_t I, size_t J, size_t first)
+    {
+        if (I + 1 < A.tile_rows())
+        {
+            A.prefetch(I + 1, J);
+        }
+        else
+        {
+            A.prefetch(first, J + 1);
+        }
+    }
+
+    // b = L^-1 b for the unit lower L of packed factors, b[0, n) in memory.
+    void solve_lower(const TiledMatrix &A, double *b)
+    {
+        const size_t t = A.tile_size();
+        for (size_t I = 0; I < A.tile_rows(); I++)
+        {
+            const size_t h = A.tile_height(I);
+            for (size_t J = 0; J < I; J++)
+            {
+                J + 1 < I ? A.prefetch(I, J + 1) : A.prefetch(I, I);
+                const TiledMatrix::Tile tile = A.read_tile(I, J);
+                const MatrixView l = tile.view();
+                blas::gemm(blas::Op::none, blas::Op::none, h, 1, l.getColumnCount(), -1.0, l.data(), l.stride(),
+                           b + J * t, 1, 1.0, b + I * t, 1);
+            }
+            A.prefetch(I + 1, 0);
+            const TiledMatrix::Tile tile = A.read_tile(I, I);
+            triangular::solve(triangular::Uplo::lower, blas::Op::none, triangular::Diag::unit, h, 1, tile.view().data(),
+                              t, b + I * t, 1);
+        }
+    }
+
+    // b = U^-1 b for the n x n upper U at the top of a matrix's tiles, b[0, n) in memory. Throws on
+    // a zero on the diagonal.
+    void solve_upper(const TiledMatrix &A, size_t n, double *b, const char *singular)
+    {
+        const size_t t = A.tile_size(), tiles = (n + t - 1) / t;
+        for (size_t I = tiles; I-- > 0;)
+        {
+            const size_t h = std::min(t, n - I * t);
+            for (size_t J = tiles; J-- > I + 1;)
+            {
+                A.prefetch(I, J - 1);
+                const TiledMatrix::Tile tile = A.read_tile(I, J);
+                const MatrixView u = tile.view();
+                blas::gemm(blas::Op::none, blas::Op::none, h, 1, std::min(t, n - J * t), -1.0, u.data(), u.stride(),
+                           b + J * t, 1, 1.0, b + I * t, 1);
+            }
+            if (I > 0)
+            {
+                A.prefetch(I - 1, tiles - 1);
+            }
+            const TiledMatrix::Tile tile = A.read_tile(I, I);
+            const MatrixView u = tile.view();
+            for (size_t i = 0; i < h; i++)
+            {
+                if (u(i, i) == 0.0)
+                {
+                    throw std::domain_error(singular);
+                }
+            }
+            triangular::solve(triangular::Uplo::upper, blas::Op::none, triangular::Diag::non_unit, h, 1, u.data(), t,
+                              b + I * t, 1);
+        }
+    }
+
+    // Applies the row interchanges pivots[first, last) to the rows of a block column held in memory.
+    void swap_rows(MatrixView panel, const std::vector<size_t> &pivots, size_t first, size_t last)
+    {
+        const size_t w = panel.getColumnCount();
+        for (size_t i = first; i < last; i++)
+        {
+            if (pivots[i] != i)
+            {
+                std::swap_ranges(panel.data() + i * panel.stride(), panel.data() + i * panel.stride() + w,
+                                 panel.data() + pivots[i] * panel.stride());
+            }
+        }
+    }
+
+    // Reflector block of tile (I, J) of packed QR factors: the tile itself below the diagonal tile, a
+    // unit lower copy in 'diagonal' on it.
+    ConstMatrixView reflectors(const TiledMatrix::Tile &tile, size_t I, size_t J, MATRIX &diagonal)
+    {
+        const MatrixView v = tile.view();
+        if (I != J)
+        {
+            return v;
+        }
+        for (size_t i = 0; i < v.getRowCount(); i++)
+        {
+            for (size_t p = 0; p < v.getColumnCount(); p++)
+            {
+                diagonal(i, p) = i < p ? 0.0 : i == p ? 1.0 : v(i, p);
+            }
+        }
+        return ConstMatrixView(diagonal.data(), v.getRowCount(), v.getColumnCount(), diagonal.stride());
+    }
+
+    // C = (I - V T^T V^T) C (transposed) or (I - V T V^T) C for the reflectors of block column J of
+    // packed QR factors, C holding the rows of the whole matrix. Two passes over the tiles of V.
+    void apply_reflectors(const TiledMatrix &A, size_t J, const MATRIX &T, MatrixView C, bool transposed)
+    {
+        const size_t t = A.tile_size(), w = A.tile_width(J), columns = C.getColumnCount();
+        MATRIX diagonal(t, t), W(w, columns), TW(w, columns);
+
+        // W = V^T C
+        for (size_t I = J; I < A.tile_rows(); I++)
+        {
+            prefetch_below(A, I, J, J);
+            const TiledMatrix::Tile tile = A.read_tile(I, J);
+            const ConstMatrixView v = reflectors(tile, I, J, diagonal);
+            blas::gemm(blas::Op::transpose, blas::Op::none, 1.0, v, C.block(I * t, 0, v.getRowCount(), columns), 1.0, W);
+        }
+
+        // C -= V op(T) W, re-reading V from its first tile
+        A.prefetch(J, J);
+        blas::gemm(transposed ? blas::Op::transpose : blas::Op::none, blas::Op::none, 1.0, T, W, 0.0, TW);
+        for (size_t I = J; I < A.tile_rows(); I++)
+        {
+            if (I + 1 < A.tile_rows())
+            {
+                A.prefetch(I + 1, J);
+            }
+            const TiledMatrix::Tile tile = A.read_tile(I, J);
+            const ConstMatrixView v = reflectors(tile, I, J, diagonal);
+            blas::gemm(-1.0, v, TW, 1.0, C.block(I * t, 0, v.getRowCount(), columns));
+        }
+    }
+}
+
+void out_of_core::gemm(double alpha, const TiledMatrix &A, const TiledMatrix &B, double beta, TiledMatrix &C)
+{
+    require_same_tiles(A, B);
+    require_same_tiles(A, C);
+    if (A.getColumnCount() != B.getRowCount() || C.getRowCount() != A.getRowCount() ||
+        C.getColumnCount() != B.getColumnCount())
+    {
+        throw std::invalid_argument("Matrix dimensions do not match for gemm");
+    }
+
+    const size_t depth = A.tile_columns();
+    for (size_t I = 0; I < C.tile_rows(); I++)
+    {
+        for (size_t J = 0; J < C.tile_columns(); J++)
+        {
+            TiledMatrix::Tile c = C.write_tile(I, J);
+            const MatrixView cv = c.view();
+            if (depth == 0)
+            {
+                blas::scal(beta, cv);
+                continue;
+            }
+            for (size_t K = 0; K < depth; K++)
+            {
+                // Next pair of operand tiles, the first of the next tile of C after the last one
+                const bool last = K + 1 == depth;
+                const size_t nI = last && J + 1 == C.tile_columns() ? I + 1 : I;
+                const size_t nJ = last ? (J + 1) % C.tile_columns() : J, nK = last ? 0 : K + 1;
+                A.prefetch(nI, nK);
+                B.prefetch(nK, nJ);
+
+                const TiledMatrix::Tile a = A.read_tile(I, K), b = B.read_tile(K, J);
+                const MatrixView av = a.view(), bv = b.view();
+                blas::parallel_gemm(blas::Op::none, blas::Op::none, cv.getRowCount(), cv.getColumnCount(),
+                                    av.getColumnCount(), alpha, av.data(), av.stride(), bv.data(), bv.stride(),
+                                    K == 0 ? beta : 1.0, cv.data(), cv.stride());
+            }
+        }
+    }
+}
+
+void out_of_core::transpose(const TiledMatrix &A, TiledMatrix &B)
+{
+    require_same_tiles(A, B);
+    if (B.getRowCount() != A.getColumnCount() || B.getColumnCount() != A.getRowCount())
+    {
+        throw std::invalid_argument("Transpose target must be columns x rows");
+    }
+    for (size_t I = 0; I < A.tile_rows(); I++)
+    {
+        for (size_t J = 0; J < A.tile_columns(); J++)
+        {
+            J + 1 < A.tile_columns() ? A.prefetch(I, J + 1) : A.prefetch(I + 1, 0);
+            const TiledMatrix::Tile a = A.read_tile(I, J);
+            const TiledMatrix::Tile b = B.write_tile(J, I);
+            const MatrixView av = a.view(), bv = b.view();
+            blas::transpose(av.getRowCount(), av.getColumnCount(), av.data(), av.stride(), bv.data(), bv.stride());
+        }
+    }
+}
+
+out_of_core::LU::LU(TiledMatrix &A) : m_factors(A), m_pivots(A.getRowCount()), m_singular(false)
+{
+    const size_t n = A.getRowCount(), t = A.tile_size(), panels = A.tile_columns();
+    if (n != A.getColumnCount())
+    {
+        throw std::invalid_argument("Out-of-core LU needs a square matrix");
+    }
+
+    // The block column P and the copy factorization::LU makes of its lower part
+    const Budget budget(A, 2 * n * t * sizeof(double));
+    MATRIX P(n, t);
+    for (size_t K = 0; K < panels; K++)
+    {
+        const size_t c0 = K * t, w = A.tile_width(K);
+        const MatrixView panel = P.block(0, 0, n, w);
+        A.read_block(0, c0, panel);
+
+        // Updates from every block column to the left: its interchanges, U(J, K) = L(J, J)^-1 P(J),
+        // then P(I) -= L(I, J) U(J, K) below it
+        for (size_t J = 0; J < K; J++)
+        {
+            const size_t j0 = J * t;
+            swap_rows(panel, m_pivots, j0, j0 + t);
+            const MatrixView u = panel.block(j0, 0, t, w);
+            A.prefetch(J + 1, J);
+            {
+                const TiledMatrix::Tile l = A.read_tile(J, J);
+                triangular::solve(triangular::Uplo::lower, blas::Op::none, triangular::Diag::unit, l.view(), u);
+            }
+            for (size_t I = J + 1; I < A.tile_rows(); I++)
+            {
+                prefetch_below(A, I, J, J + 2);
+                const TiledMatrix::Tile l = A.read_tile(I, J);
+                const MatrixView lv = l.view();
+                blas::parallel_gemm(blas::Op::none, blas::Op::none, lv.getRowCount(), w, t, -1.0, lv.data(),
+                                    lv.stride(), u.data(), u.stride(), 1.0, panel.data() + I * t * panel.stride(),
+                                    panel.stride());
+            }
+        }
+
+        // The block column from the diagonal down is now an ordinary tall panel
+        {
+            factorization::LU lu(panel.block(c0, 0, n - c0, w));
+            m_singular = m_singular || lu.is_singular();
+            copy(lu.packed(), panel.block(c0, 0, n - c0, w));
+            for (size_t p = 0; p < w; p++)
+            {
+                m_pivots[c0 + p] = c0 + lu.pivots()[p];
+            }
+        }
+        A.write_block(0, c0, panel);
+    }
+
+    // Interchanges of later block columns, applied to the L parts to their left
+    for (size_t J = 0; J + 1 < panels; J++)
+    {
+        const MatrixView panel = P.block(0, 0, n, t);
+        A.read_block(0, J * t, panel);
+        swap_rows(panel, m_pivots, (J + 1) * t, n);
+        A.write_block(0, J * t, panel);
+    }
+}
+
+bool out_of_core::LU::is_singular() const noexcept
+{
+    return m_singular;
+}
+
+const std::vector<size_t> &out_of_core::LU::pivots() const noexcept
+{
+    return m_pivots;
+}
+
+Vector out_of_core::LU::solve(ConstVectorView b) const
+{
+    const size_t n = m_factors.getRowCount();
+    if (b.dimension() != n)
+    {
+        throw std::invalid_argument("Right-hand side does not match the matrix size");
+    }
+    if (m_singular)
+    {
+        throw std::domain_error("Matrix is singular");
+    }
+    Vector x(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        x[i] = b.coeff(i);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        std::swap(x[i], x[m_pivots[i]]);
+    }
+    solve_lower(m_factors, x.data());
+    solve_upper(m_factors, n, x.data(), "Matrix is singular");
+    return x;
+}
+
+out_of_core::QR::QR(TiledMatrix &A) : m_factors(A), m_tau(A.getColumnCount())
+{
+    const size_t m = A.getRowCount(), t = A.tile_size(), panels = A.tile_columns();
+    if (m < A.getColumnCount())
+    {
+        throw std::invalid_argument("Out-of-core QR needs at least as many rows as columns");
+    }
+
+    // The block column P, then either factorization::QR's copy and panel workspace or V, plus the T
+    // factors and apply_reflectors' t x t blocks
+    const size_t n = A.getColumnCount();
+    const Budget budget(A, (3 * m * t + n * t + 4 * t * t) * sizeof(double));
+    MATRIX P(m, t);
+    m_t.reserve(panels);
+    for (size_t K = 0; K < panels; K++)
+    {
+        const size_t c0 = K * t, w = A.tile_width(K);
+        const MatrixView panel = P.block(0, 0, m, w);
+        A.read_block(0, c0, panel);
+        for (size_t J = 0; J < K; J++)
+        {
+            apply_reflectors(A, J, m_t[J], panel, true);
+        }
+
+        const MatrixView below = panel.block(c0, 0, m - c0, w);
+        {
+            factorization::QR qr(below);
+            copy(qr.packed(), below);
+            std::copy_n(qr.tau().data(), w, m_tau.data() + c0);
+        }
+        A.write_block(0, c0, panel);
+
+        // T of the block column for the updates to its right and for applying Q
+        MATRIX V(m - c0, w), G(w, w), T(w, w);
+        householder::unpack(below, w, V);
+        householder::form_t(V, m - c0, w, m_tau.data() + c0, G, T.data(), T.stride());
+        m_t.push_back(std::move(T));
+    }
+}
+
+const Vector &out_of_core::QR::tau() const noexcept
+{
+    return m_tau;
+}
+
+void out_of_core::QR::apply_qt(VectorView b) const
+{
+    const size_t m = m_factors.getRowCount();
+    if (b.dimension() != m || b.stride() != 1)
+    {
+        throw std::invalid_argument("Right-hand side does not match the matrix size");
+    }
+    for (size_t J = 0; J < m_t.size(); J++)
+    {
+        apply_reflectors(m_factors, J, m_t[J], MatrixView(b.data(), m, 1, 1), true);
+    }
+}
+
+Vector out_of_core::QR::solve_least_squares(ConstVectorView b) const
+{
+    const size_t m = m_factors.getRowCount(), n = m_factors.getColumnCount();
+    if (b.dimension() != m)
+    {
+        throw std::invalid_argument("Right-hand side does not match the matrix size");
+    }
+
+    // y = Q^T b, then R x = y[0:n]
+    Vector y(m);
+    for (size_t i = 0; i < m; i++)
+    {
+        y[i] = b.coeff(i);
+    }
+    apply_qt(y);
+    solve_upper(m_factors, n, y.data(), "Matrix is rank deficient");
+
+    Vector x(n);
+    std::copy_n(y.data(), n, x.data());
+    return x;
+}
@@ -0,0 +1,194 @@
+#include "../include/blas.h"
+#include "../include/simd.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Leaf size of the recursion: a TILE x TILE block of the source and of the destination
+    // (8 KiB each) stay in L1 while simd::transpose works through them.
+    constexpr size_t TILE = 32;
+
+    // Transposes a leaf block: in SIMD registers for double, element by element for float (simd.h is
+    // double only; a float leaf is half the bytes and stays in L1 all the same).
+    void transpose_leaf(const double *A, size_t lda, double *B, size_t ldb, size_t rows, size_t columns)
+    {
+        simd::transpose(A, lda, B, ldb, rows, columns);
+    }
+
+    void transpose_leaf(const float *A, size_t lda, float *B, size_t ldb, size_t rows, size_t columns)
+    {
+        for (size_t i = 0; i < rows; i++)
+        {
+            for (size_t j = 0; j < columns; j++)
+            {
+                B[j * ldb + i] = A[i * lda + j];
+            }
+        }
+    }
+
+    // Splits the larger dimension on a TILE boundary until the block is a leaf, so that the
+    // working set fits every cache level on the way down without knowing their sizes.
+    template <typename T>
+    void transpose_recursive(size_t m, size_t n, const T *A, size_t lda, T *B, size_t ldb)
+    {
+        if (m <= TILE && n <= TILE)
+        {
+            transpose_leaf(A, lda, B, ldb, m, n);
+            return;
+        }
+        if (m >= n)
+        {
+            const size_t half = (m + TILE - 1) / TILE / 2 * TILE;
+            transpose_recursive(half, n, A, lda, B, ldb);
+            transpose_recursive(m - half, n, A + half * lda, lda, B + half, ldb);
+        }
+        else
+        {
+            const size_t half = (n + TILE - 1) / TILE / 2 * TILE;
+            transpose_recursive(m, half, A, lda, B, ldb);
+            transpose_recursive(m, n - half, A + half, lda, B + half * ldb, ldb);
+        }
+    }
+
+    // Copies a rows x columns block between two strided locations.
+    template <typename T>
+    void copy_block(const T *source, size_t lds, T *target, size_t ldt, size_t rows, size_t columns)
+    {
+        for (size_t i = 0; i < rows; i++)
+        {
+            std::memcpy(target + i * ldt, source + i * lds, columns * sizeof(T));
+        }
+    }
+
+    // Transposes the tile pairs (I, J), (J, I) for J >= I of block row I of a square matrix,
+    // through two tiles of scratch.
+    template <typename T>
+    void swap_block_row(size_t n, T *A, size_t lda, size_t I)
+    {
+        alignas(64) T upper[TILE * TILE];
+        alignas(64) T lower[TILE * TILE];
+        const size_t r = I * TILE, rows = std::min(TILE, n - r);
+        for (size_t c = r; c < n; c += TILE)
+        {
+            const size_t columns = std::min(TILE, n - c);
+            T *above = A + r * lda + c, *below = A + c * lda + r;
+            transpose_leaf(above, lda, upper, TILE, rows, columns);
+            if (c == r)
+            {
+                copy_block(upper, TILE, above, lda, rows, columns);
+                continue;
+            }
+            transpose_leaf(below, lda, lower, TILE, columns, rows);
+            copy_block(lower, TILE, above, lda, rows, columns);
+            copy_block(upper, TILE, below, lda, columns, rows);
+        }
+    }
+
+    template <typename T>
+    void transpose_kernel(size_t m, size_t n, const T *A, size_t lda, T *B, size_t ldb)
+    {
+        if (!parallel::worthwhile(m * n, expr::PARALLEL_ELEMENTS))
+        {
+            transpose_recursive(m, n, A, lda, B, ldb);
+            return;
+        }
+
+        // Bands of rows of A fill disjoint column ranges of B
+        parallel::parallel_for(m, std::max(TILE, expr::row_grain(n)), [=](size_t begin, size_t end) {
+            transpose_recursive(end - begin, n, A + begin * lda, lda, B + begin, ldb);
+        });
+    }
+
+    template <typename T>
+    void transpose_square(size_t n, T *A, size_t lda)
+    {
+        const size_t blocks = (n + TILE - 1) / TILE;
+        const auto rows = [=](size_t begin, size_t end) {
+            for (size_t I = begin; I < end; I++)
+            {
+                swap_block_row(n, A, lda, I);
+            }
+        };
+
+        // Block rows touch disjoint tile pairs; the first ones carry the most pairs, which the
+        // pool evens out by stealing
+        if (parallel::worthwhile(n * n, expr::PARALLEL_ELEMENTS))
+        {
+            parallel::parallel_for(blocks, 1, rows);
+        }
+        else
+        {
+            rows(0, blocks);
+        }
+    }
+
+    template <typename T>
+    void transpose_contiguous(size_t m, size_t n, T *A)
+    {
+        if (m == n)
+        {
+            transpose_square(n, A, n);
+            return;
+        }
+        if (m <= 1 || n <= 1)
+        {
+            // A single row or column reads the same in both layouts
+            return;
+        }
+
+        // Element k = i * n + j moves to j * m + i. The first and last elements stay put; every other
+        // cycle of the permutation is walked once from its smallest position.
+        const size_t count = m * n;
+        std::vector<bool> moved(count, false);
+        for (size_t start = 1; start + 1 < count; start++)
+        {
+            if (moved[start])
+            {
+                continue;
+            }
+            T carried = A[start];
+            size_t k = start;
+            do
+            {
+                const size_t next = (k % n) * m + k / n;
+                std::swap(carried, A[next]);
+                moved[next] = true;
+                k = next;
+            } while (k != start);
+        }
+    }
+}
+
+void blas::transpose(size_t m, size_t n, const double *A, size_t lda, double *B, size_t ldb)
+{
+    transpose_kernel(m, n, A, lda, B, ldb);
+}
+
+void blas::transpose(size_t m, size_t n, const float *A, size_t lda, float *B, size_t ldb)
+{
+    transpose_kernel(m, n, A, lda, B, ldb);
+}
+
+void blas::transpose_in_place(size_t n, double *A, size_t lda)
+{
+    transpose_square(n, A, lda);
+}
+
+void blas::transpose_in_place(size_t n, float *A, size_t lda)
+{
+    transpose_square(n, A, lda);
+}
+
+void blas::transpose_in_place(size_t m, size_t n, double *A)
+{
+    transpose_contiguous(m, n, A);
+}
+
+void blas::transpose_in_place(size_t m, size_t n, float *A)
+{
+    transpose_contiguous(m, n, A);
+}
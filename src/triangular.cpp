@@ -0,0 +1,221 @@
+#include "../include/triangular.h"
+#include "../include/blas.h"
+#include "../include/instrument.h"
+#include "../include/matrix.h"
+#include "../include/thread_pool.h"
+#include <algorithm>
+
+namespace
+{
+    // Diagonal block width of the blocked inversion.
+    constexpr size_t NB = 64;
+
+    // Rows handed to one thread when a block column is solved row by row.
+    constexpr size_t ROW_GRAIN = 64;
+
+    // Diagonal block height of solve(); wider than NB since the updates run at the depth of a block.
+    constexpr size_t SOLVE_NB = 128;
+
+    // Right-hand side columns handed to one thread by solve(); each strip of B is solved on its own.
+    constexpr size_t COLUMN_GRAIN = 256;
+
+    // op(T) seen through its row and column indices, so that one substitution loop and one
+    // update serve both T and T^T.
+    struct Triangle
+    {
+        const double *t;
+        size_t ldt;
+        bool transposed;
+
+        double operator()(size_t i, size_t j) const
+        {
+            return transposed ? t[j * ldt + i] : t[i * ldt + j];
+        }
+
+        // Address of op(T)(i, j) as the start of a gemm operand.
+        const double *at(size_t i, size_t j) const
+        {
+            return transposed ? t + j * ldt + i : t + i * ldt + j;
+        }
+    };
+
+    // Substitution on the jb x jb diagonal block of op(T) starting at (k, k) against the rows
+    // k:k+jb of the nrhs columns at b. Rows are combined whole so the inner loop streams along B.
+    void solve_diagonal_block(const Triangle &op_t, bool forward, bool unit, size_t k, size_t jb, size_t nrhs,
+                              double *b, size_t ldb)
+    {
+        for (size_t s = 0; s < jb; s++)
+        {
+            const size_t i = forward ? k + s : k + jb - 1 - s;
+            double *row = b + i * ldb;
+            const size_t first = forward ? k : i + 1, last = forward ? i : k + jb;
+            for (size_t p = first; p < last; p++)
+            {
+                const double l = op_t(i, p);
+                const double *x = b + p * ldb;
+                for (size_t c = 0; c < nrhs; c++)
+                {
+                    row[c] -= l * x[c];
+                }
+            }
+            if (!unit)
+            {
+                const double inverse_pivot = 1.0 / op_t(i, i);
+                for (size_t c = 0; c < nrhs; c++)
+                {
+                    row[c] *= inverse_pivot;
+                }
+            }
+        }
+    }
+
+    // Right-looking blocked solve of all n rows of the nrhs columns at b: each solved block of rows
+    // is subtracted from the rows still to go with one gemm.
+    void solve_columns(const Triangle &op_t, bool forward, bool unit, size_t n, size_t nrhs, double *b, size_t ldb,
+                       bool parallel_update)
+    {
+        const blas::Op op = op_t.transposed ? blas::Op::transpose : blas::Op::none;
+        using Gemm = void (*)(blas::Op, blas::Op, size_t, size_t, size_t, double, const double *, size_t,
+                              const double *, size_t, double, double *, size_t);
+        const Gemm update = parallel_update ? Gemm(&blas::parallel_gemm) : Gemm(&blas::gemm);
+        const size_t blocks = (n + SOLVE_NB - 1) / SOLVE_NB;
+        for (size_t s = 0; s < blocks; s++)
+        {
+            const size_t k = forward ? s * SOLVE_NB : (blocks - 1 - s) * SOLVE_NB;
+            const size_t jb = std::min(SOLVE_NB, n - k);
+            solve_diagonal_block(op_t, forward, unit, k, jb, nrhs, b, ldb);
+            if (forward && k + jb < n)
+            {
+                update(op, blas::Op::none, n - k - jb, nrhs, jb, -1.0,
+                       op_t.at(k + jb, k), op_t.ldt, b + k * ldb, ldb, 1.0, b + (k + jb) * ldb, ldb);
+            }
+            else if (!forward && k > 0)
+            {
+                update(op, blas::Op::none, k, nrhs, jb, -1.0, op_t.at(0, k), op_t.ldt, b + k * ldb, ldb, 1.0, b, ldb);
+            }
+        }
+    }
+
+    // In-place inverse of the jb x jb upper triangular block at a. Column c is replaced by
+    // -U^-1(0:c, 0:c) U(0:c, c) / U(c, c) top-down, each entry only reading the ones below it.
+    void invert_diagonal_block(double *a, size_t lda, size_t jb)
+    {
+        for (size_t c = 0; c < jb; c++)
+        {
+            a[c * lda + c] = 1.0 / a[c * lda + c];
+            const double scale = -a[c * lda + c];
+            for (size_t i = 0; i < c; i++)
+            {
+                double sum = 0.0;
+                for (size_t p = i; p < c; p++)
+                {
+                    sum += a[i * lda + p] * a[p * lda + c];
+                }
+                a[i * lda + c] = scale * sum;
+            }
+        }
+    }
+}
+
+void triangular::solve(Uplo uplo, blas::Op op, Diag diag, size_t n, size_t nrhs, const double *t, size_t ldt,
+                       double *b, size_t ldb)
+{
+    if (n == 0 || nrhs == 0)
+    {
+        return;
+    }
+    TSMATH_INSTRUMENT(triangular_solve, n * n * nrhs, (n * n / 2 + 2 * n * nrhs) * sizeof(double));
+    const Triangle op_t{t, ldt, op == blas::Op::transpose};
+
+    // op(T) is lower triangular, and solved top-down, exactly when T is lower and not transposed
+    // or upper and transposed
+    const bool forward = (uplo == Uplo::lower) != op_t.transposed;
+    const bool unit = diag == Diag::unit;
+
+    const size_t strips = (nrhs + COLUMN_GRAIN - 1) / COLUMN_GRAIN;
+    if (strips == 1)
+    {
+        solve_columns(op_t, forward, unit, n, nrhs, b, ldb, true);
+        return;
+    }
+    parallel::parallel_for(strips, 1, [=, &op_t](size_t begin, size_t end) {
+        for (size_t strip = begin; strip < end; strip++)
+        {
+            const size_t first = strip * COLUMN_GRAIN;
+            solve_columns(op_t, forward, unit, n, std::min(COLUMN_GRAIN, nrhs - first), b + first, ldb, false);
+        }
+    });
+}
+
+void triangular::solve(Uplo uplo, blas::Op op, Diag diag, ConstMatrixView T, MatrixView B)
+{
+    solve(uplo, op, diag, T.getRowCount(), B.getColumnCount(), T.data(), T.stride(), B.data(), B.stride());
+}
+
+void triangular::invert_upper(MatrixView A)
+{
+    const size_t n = A.getRowCount(), lda = A.stride();
+    double *a = A.data();
+    MATRIX T(n, NB);
+    double *t = T.data();
+    const size_t ldt = T.stride();
+
+    // Left to right, with U(0:j, 0:j) already inverted:
+    // A(0:j, j:j+jb) = -U^-1(0:j, 0:j) A(0:j, j:j+jb) U(j:j+jb, j:j+jb)^-1
+    for (size_t j = 0; j < n; j += NB)
+    {
+        const size_t jb = std::min(NB, n - j);
+
+        if (j > 0)
+        {
+            // T = A(0:j, j:j+jb), then each band of rows is rebuilt from the triangle on its
+            // diagonal plus one product with the rectangle to its right
+            for (size_t i = 0; i < j; i++)
+            {
+                std::copy_n(a + i * lda + j, jb, t + i * ldt);
+            }
+            parallel::parallel_for((j + NB - 1) / NB, 1, [=](size_t begin, size_t end) {
+                for (size_t band = begin; band < end; band++)
+                {
+                    const size_t first = band * NB, last = std::min(j, first + NB);
+                    for (size_t i = first; i < last; i++)
+                    {
+                        double *row = a + i * lda + j;
+                        std::fill_n(row, jb, 0.0);
+                        for (size_t p = i; p < last; p++)
+                        {
+                            const double u = a[i * lda + p];
+                            const double *tp = t + p * ldt;
+                            for (size_t c = 0; c < jb; c++)
+                            {
+                                row[c] += u * tp[c];
+                            }
+                        }
+                    }
+                    blas::gemm(blas::Op::none, blas::Op::none, last - first, jb, j - last, 1.0, a + first * lda + last,
+                               lda, t + last * ldt, ldt, 1.0, a + first * lda + j, lda);
+                }
+            });
+
+            // Rows times -U(j:j+jb, j:j+jb)^-1 by forward substitution along each row
+            const double *u = a + j * lda + j;
+            parallel::parallel_for(j, ROW_GRAIN, [=](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++)
+                {
+                    double *x = a + i * lda + j;
+                    for (size_t c = 0; c < jb; c++)
+                    {
+                        double sum = -x[c];
+                        for (size_t p = 0; p < c; p++)
+                        {
+                            sum -= x[p] * u[p * lda + c];
+                        }
+                        x[c] = sum / u[c * lda + c];
+                    }
+                }
+            });
+        }
+
+        invert_diagonal_block(a + j * lda + j, lda, jb);
+    }
+}
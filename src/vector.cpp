@@ -1,12 +1,81 @@
-#include "../include/Vector.h"
+#include "../include/vector.h"
+#include "../include/binary_io.h"
+#include "../include/instrument.h"
+#include "../include/simd.h"
+#include <algorithm>
 
-Vector::Vector(const std::vector<double>& other) : components(other) {}
+namespace {
+  template <typename T>
+  void require_same_dimension(const BasicVector<T>& x, const BasicVector<T>& y) {
+    if (x.dimension() != y.dimension()) {
+      throw std::invalid_argument("Vectors must have the same dimension for element-wise operations");
+    }
+  }
+
+  // The kernels of simd.h are double only, float vectors run the same loops for the compiler to vectorise
+  void axpy(double alpha, const double* x, double* y, size_t n) noexcept {
+    simd::axpy(alpha, x, y, n);
+  }
+
+  void axpy(double alpha, const float* x, float* y, size_t n) noexcept {
+    const float a = static_cast<float>(alpha);
+    for (size_t i = 0; i < n; ++i) {
+      y[i] += a * x[i];
+    }
+  }
+
+  void scale(const double* x, double alpha, double* out, size_t n) noexcept {
+    simd::scale(x, alpha, out, n);
+  }
+
+  void scale(const float* x, double alpha, float* out, size_t n) noexcept {
+    const float a = static_cast<float>(alpha);
+    for (size_t i = 0; i < n; ++i) {
+      out[i] = a * x[i];
+    }
+  }
 
-Vector::Vector(std::vector<double>&& other) : components(std::move(other)) {}
+  double sum_squares(const double* x, size_t n) noexcept {
+    return simd::sum_squares(x, n);
+  }
 
-Vector::Vector(const Vector& other) : components(other.components) {}
+  double sum_squares(const float* x, size_t n) noexcept {
+    // Accumulated in double, a float sum loses digits long before the vector is large
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+      sum += double(x[i]) * x[i];
+    }
+    return sum;
+  }
+}
 
-Vector& Vector::operator=(const Vector& other) {
+template <typename T>
+BasicVector<T>::BasicVector(const std::vector<T>& other)
+    : components(other.begin(), other.end(), memory::current_resource()) {}
+
+template <typename T>
+BasicVector<T>::BasicVector(std::vector<T>&& other) : BasicVector(static_cast<const std::vector<T>&>(other)) {
+  std::vector<T>().swap(other);
+}
+
+template <typename T>
+BasicVector<T>::BasicVector(const std::string& path) : components(memory::current_resource()) {
+  binary::MappedFile file(path);
+  const ConstVectorView source = file.vector();
+  components.resize(source.dimension());
+  for (size_t i = 0; i < source.dimension(); ++i) {
+    components[i] = static_cast<T>(source.coeff(i));
+  }
+}
+
+template <typename T>
+BasicVector<T>::BasicVector(const BasicVector& other) : components(other.components, memory::current_resource()) {}
+
+template <typename T>
+BasicVector<T>::BasicVector(BasicVector&& other) noexcept : components(std::move(other.components)) {}
+
+template <typename T>
+BasicVector<T>& BasicVector<T>::operator=(const BasicVector& other) {
   if (this == &other) {
     return *this;
   }
@@ -18,104 +87,179 @@ Vector& Vector::operator=(const Vector& other) {
   return *this;
 }
 
-Vector::Vector(size_t dimension, double default_value) : components(dimension, default_value) {}
+template <typename T>
+BasicVector<T>::BasicVector(size_t dimension, T default_value)
+    : BasicVector(dimension, default_value, memory::current_resource()) {}
+
+template <typename T>
+BasicVector<T>::BasicVector(size_t dimension, T default_value, std::pmr::memory_resource* resource)
+    : components(dimension, default_value, resource) {}
+
+template <typename T>
+BasicVector<T>& BasicVector<T>::operator=(BasicVector&& other) {
+  components = std::move(other.components);
+  other.components.clear();
+  return *this;
+}
+
+template <typename T>
+BasicVector<T>::~BasicVector() = default;  // Use the default destructor
+
+template <typename T>
+BasicVector<T>& BasicVector<T>::operator+=(const BasicVector& other) {
+  require_same_dimension(*this, other);
+  TSMATH_INSTRUMENT(vector_axpy, 2 * dimension(), 3 * dimension() * sizeof(T));
+  axpy(1.0, other.data(), data(), dimension());
+  return *this;
+}
+
+template <typename T>
+BasicVector<T>& BasicVector<T>::operator-=(const BasicVector& other) {
+  require_same_dimension(*this, other);
+  TSMATH_INSTRUMENT(vector_axpy, 2 * dimension(), 3 * dimension() * sizeof(T));
+  axpy(-1.0, other.data(), data(), dimension());
+  return *this;
+}
+
+template <typename T>
+BasicVector<T>& BasicVector<T>::operator+=(const expr::VectorScaled<BasicVector>& other) {
+  require_same_dimension(*this, other.operand_expression());
+  TSMATH_INSTRUMENT(vector_axpy, 2 * dimension(), 3 * dimension() * sizeof(T));
+  axpy(other.scalar(), other.operand_expression().data(), data(), dimension());
+  return *this;
+}
+
+template <typename T>
+BasicVector<T>& BasicVector<T>::operator-=(const expr::VectorScaled<BasicVector>& other) {
+  require_same_dimension(*this, other.operand_expression());
+  TSMATH_INSTRUMENT(vector_axpy, 2 * dimension(), 3 * dimension() * sizeof(T));
+  axpy(-other.scalar(), other.operand_expression().data(), data(), dimension());
+  return *this;
+}
 
-Vector::~Vector() = default;  // Use the default destructor
+template <typename T>
+BasicVector<T>& BasicVector<T>::operator*=(double scalar) noexcept {
+  TSMATH_INSTRUMENT(vector_scale, dimension(), 2 * dimension() * sizeof(T));
+  scale(data(), scalar, data(), dimension());
+  return *this;
+}
 
-Vector Vector::unitVector() const noexcept {
+template <typename T>
+BasicVector<T> BasicVector<T>::unitVector() const noexcept {
   auto n = dimension();
   auto magnitude = this->magnitude();
   if (std::abs(magnitude) < 1e-7) {
     // Handle near-zero magnitude case (return zero vector)
-    return Vector(n, 0.0);
+    return BasicVector(n, T(0));
   }
 
-  Vector result(n, 0.0);
+  BasicVector result(n, T(0));
   for (size_t i = 0; i < n; ++i) {
-    result.components[i] = components[i] / magnitude;
+    result.components[i] = static_cast<T>(components[i] / magnitude);
   }
   return result;
 }
 
-Vector Vector::operator+(const Vector& other) const {
-  if (dimension() != other.dimension()) {
-    throw std::invalid_argument("Vectors must have the same dimension for addition");
-  }
+template <typename T>
+expr::VectorScaled<BasicVector<T>> BasicVector<T>::operator*(const double scalar) const noexcept {
+  return expr::VectorScaled<BasicVector>(*this, scalar);
+}
 
-  size_t n = dimension();
-  std::vector<double> result(n);
-  for (size_t i = 0; i < n; ++i) {
-    result[i] = components[i] + other.components[i];
-  }
-  return Vector(result);
+void expr::evaluate(double* out, const VectorBinary<Vector, Vector, plus>& e) noexcept {
+  TSMATH_INSTRUMENT(vector_add, e.dimension(), 3 * e.dimension() * sizeof(double));
+  simd::add(e.lhs().data(), e.rhs().data(), out, e.dimension());
 }
 
-Vector Vector::operator-(const Vector& other) const {
-  // Reuse logic from addition with appropriate error handling
-  return *this + ( other * -1);
+void expr::evaluate(double* out, const VectorScaled<Vector>& e) noexcept {
+  TSMATH_INSTRUMENT(vector_scale, e.dimension(), 2 * e.dimension() * sizeof(double));
+  simd::scale(e.operand_expression().data(), e.scalar(), out, e.dimension());
 }
 
-Vector Vector::operator*(const double scalar) const {
-  size_t n = dimension();
-  std::vector<double> result(n);
-  for (size_t i = 0; i < n; ++i) {
-    result[i] = components[i] * scalar;
+void expr::evaluate(double* out, const VectorBinary<Vector, VectorScaled<Vector>, plus>& e) noexcept {
+  const double* a = e.lhs().data();
+  const double* b = e.rhs().operand_expression().data();
+  const size_t n = e.dimension();
+  TSMATH_INSTRUMENT(vector_axpy, 2 * n, 3 * n * sizeof(double));
+  if (out == b) {
+    simd::axpby(1.0, a, e.rhs().scalar(), out, n);
+    return;
+  }
+  if (out != a) {
+    std::copy_n(a, n, out);
   }
-  return Vector(result);
+  simd::axpy(e.rhs().scalar(), b, out, n);
 }
 
-double Vector::operator*(const Vector& other) const {
-  if (dimension() != other.dimension()) {
+template <>
+double expr::operator*(const VectorExpression<Vector>& lhs, const VectorExpression<Vector>& rhs) {
+  const Vector& l = lhs.self();
+  const Vector& r = rhs.self();
+  if (l.dimension() != r.dimension()) {
     throw std::invalid_argument("Vectors must have the same dimension for dot product");
   }
 
-  size_t n = dimension();
-  double result = 0.0;
-  for (size_t i = 0; i < n; ++i) {
-    result += components[i] * other.components[i];
-  }
-  return result;
+  TSMATH_INSTRUMENT(vector_dot, 2 * l.dimension(), 2 * l.dimension() * sizeof(double));
+  return simd::dot(l.data(), r.data(), l.dimension());
 }
 
-double Vector::magnitude() const noexcept {
-  size_t n = dimension();
-  double squared_sum = 0.0;
-  for (size_t i = 0; i < n; ++i) {
-    squared_sum += components[i] * components[i];
-  }
-  return std::sqrt(squared_sum);
+template <typename T>
+double BasicVector<T>::magnitude() const noexcept {
+  TSMATH_INSTRUMENT(vector_dot, 2 * dimension(), dimension() * sizeof(T));
+  return std::sqrt(sum_squares(components.data(), dimension()));
 }
 
-double& Vector::operator[](size_t index) {
-  if (index < 0 || index >= dimension()) {
+template <typename T>
+T& BasicVector<T>::operator[](size_t index) {
+  if (index >= dimension()) {
     throw std::out_of_range("Index out of bounds");
   }
   return components[index];
 }
 
-const double& Vector::operator[](size_t index) const {
-  if (index < 0 || index >= dimension()) {
+template <typename T>
+const T& BasicVector<T>::operator[](size_t index) const {
+  if (index >= dimension()) {
     throw std::out_of_range("Index out of bounds");
   }
   return components.at(index);
 }
 
-size_t Vector::dimension() const noexcept {
+template <typename T>
+size_t BasicVector<T>::dimension() const noexcept {
   return components.size();
 }
 
-void Vector::pushFront(double value) {
+template <typename T>
+T* BasicVector<T>::data() noexcept {
+  return components.data();
+}
+
+template <typename T>
+const T* BasicVector<T>::data() const noexcept {
+  return components.data();
+}
+
+template <typename T>
+std::pmr::memory_resource* BasicVector<T>::resource() const noexcept {
+  return components.get_allocator().resource();
+}
+
+template <typename T>
+void BasicVector<T>::pushFront(T value) {
   components.insert(components.begin(), value);
 }
 
-void Vector::pushBack(double value) {
+template <typename T>
+void BasicVector<T>::pushBack(T value) {
   components.push_back(value);
 }
 
-void Vector::popBack() {
+template <typename T>
+void BasicVector<T>::popBack() {
   components.pop_back();
 }
-void Vector::print(std::ostream &out) const noexcept
+template <typename T>
+void BasicVector<T>::print(std::ostream &out) const noexcept
 {
     out << "[";
     for (size_t i = 0; i < components.size(); i++)
@@ -128,7 +272,11 @@ void Vector::print(std::ostream &out) const noexcept
     }
     out << "]\n";
 }
-void Vector::popFront()
+template <typename T>
+void BasicVector<T>::popFront()
 {
     components.erase(components.begin());
-}
\ No newline at end of file
+}
+
+template class BasicVector<float>;
+template class BasicVector<double>;
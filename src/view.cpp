@@ -0,0 +1,189 @@
+#include "../include/view.h"
+#include "../include/matrix.h"
+#include <cmath>
+
+template <typename T>
+BasicConstVectorView<T>::BasicConstVectorView(const T* data, size_t dimension, size_t stride) noexcept
+    : m_data(data), m_dimension(dimension), m_stride(stride) {}
+
+template <typename T>
+BasicConstVectorView<T>::BasicConstVectorView(const BasicVector<T>& vector) noexcept
+    : m_data(vector.data()), m_dimension(vector.dimension()), m_stride(1) {}
+
+template <typename T>
+const T& BasicConstVectorView<T>::operator[](size_t index) const {
+  if (index >= m_dimension) {
+    throw std::out_of_range("Index out of bounds");
+  }
+  return m_data[index * m_stride];
+}
+
+template <typename T>
+BasicConstVectorView<T> BasicConstVectorView<T>::segment(size_t first, size_t count) const {
+  if (first > m_dimension || count > m_dimension - first) {
+    throw std::out_of_range("Segment out of bounds");
+  }
+  return BasicConstVectorView(m_data + first * m_stride, count, m_stride);
+}
+
+template <typename T>
+double BasicConstVectorView<T>::magnitude() const noexcept {
+  double squared_sum = 0.0;
+  for (size_t i = 0; i < m_dimension; ++i) {
+    const double value = coeff(i);
+    squared_sum += value * value;
+  }
+  return std::sqrt(squared_sum);
+}
+
+template <typename T>
+void BasicConstVectorView<T>::print(std::ostream& out) const noexcept {
+  out << "[";
+  for (size_t i = 0; i < m_dimension; i++) {
+    out << coeff(i);
+    if (i + 1 < m_dimension) {
+      out << " ";
+    }
+  }
+  out << "]\n";
+}
+
+template <typename T>
+BasicVectorView<T>::BasicVectorView(T* data, size_t dimension, size_t stride) noexcept
+    : m_data(data), m_dimension(dimension), m_stride(stride) {}
+
+template <typename T>
+BasicVectorView<T>::BasicVectorView(BasicVector<T>& vector) noexcept
+    : m_data(vector.data()), m_dimension(vector.dimension()), m_stride(1) {}
+
+template <typename T>
+BasicVectorView<T>& BasicVectorView<T>::operator=(const BasicVectorView& other) {
+  return *this = static_cast<const expr::VectorExpression<BasicVectorView>&>(other);
+}
+
+template <typename T>
+T& BasicVectorView<T>::operator[](size_t index) const {
+  if (index >= m_dimension) {
+    throw std::out_of_range("Index out of bounds");
+  }
+  return m_data[index * m_stride];
+}
+
+template <typename T>
+BasicVectorView<T> BasicVectorView<T>::segment(size_t first, size_t count) const {
+  if (first > m_dimension || count > m_dimension - first) {
+    throw std::out_of_range("Segment out of bounds");
+  }
+  return BasicVectorView(m_data + first * m_stride, count, m_stride);
+}
+
+template <typename T>
+double BasicVectorView<T>::magnitude() const noexcept {
+  return BasicConstVectorView<T>(*this).magnitude();
+}
+
+template <typename T>
+BasicConstMatrixView<T>::BasicConstMatrixView(const T* data, size_t row_count, size_t column_count,
+                                              size_t stride) noexcept
+    : m_data(data), m_row_count(row_count), m_column_count(column_count), m_stride(stride) {}
+
+template <typename T>
+BasicConstMatrixView<T>::BasicConstMatrixView(const BasicMatrix<T>& matrix) noexcept
+    : m_data(matrix.data()), m_row_count(matrix.getRowCount()), m_column_count(matrix.getColumnCount()),
+      m_stride(matrix.stride()) {}
+
+template <typename T>
+BasicConstVectorView<T> BasicConstMatrixView<T>::row(size_t index) const {
+  if (index >= m_row_count) {
+    throw std::out_of_range("Row index out of bounds");
+  }
+  return BasicConstVectorView<T>(m_data + index * m_stride, m_column_count, 1);
+}
+
+template <typename T>
+BasicConstVectorView<T> BasicConstMatrixView<T>::column(size_t index) const {
+  if (index >= m_column_count) {
+    throw std::out_of_range("Column index out of bounds");
+  }
+  return BasicConstVectorView<T>(m_data + index, m_row_count, m_stride);
+}
+
+template <typename T>
+BasicConstVectorView<T> BasicConstMatrixView<T>::diagonal() const noexcept {
+  return BasicConstVectorView<T>(m_data, m_row_count < m_column_count ? m_row_count : m_column_count, m_stride + 1);
+}
+
+template <typename T>
+BasicConstMatrixView<T> BasicConstMatrixView<T>::block(size_t first_row, size_t first_column, size_t row_count,
+                                                       size_t column_count) const {
+  if (first_row > m_row_count || row_count > m_row_count - first_row ||
+      first_column > m_column_count || column_count > m_column_count - first_column) {
+    throw std::out_of_range("Block out of bounds");
+  }
+  return BasicConstMatrixView(m_data + first_row * m_stride + first_column, row_count, column_count, m_stride);
+}
+
+template <typename T>
+void BasicConstMatrixView<T>::print_matrix(std::ostream& buff) const noexcept {
+  for (size_t i = 0; i < m_row_count; i++) {
+    buff << "[";
+    for (size_t j = 0; j < m_column_count; j++) {
+      buff << coeff(i, j) << " ";
+    }
+    buff << "]\n";
+  }
+}
+
+template <typename T>
+BasicMatrixView<T>::BasicMatrixView(T* data, size_t row_count, size_t column_count, size_t stride) noexcept
+    : m_data(data), m_row_count(row_count), m_column_count(column_count), m_stride(stride) {}
+
+template <typename T>
+BasicMatrixView<T>::BasicMatrixView(BasicMatrix<T>& matrix) noexcept
+    : m_data(matrix.data()), m_row_count(matrix.getRowCount()), m_column_count(matrix.getColumnCount()),
+      m_stride(matrix.stride()) {}
+
+template <typename T>
+BasicMatrixView<T>& BasicMatrixView<T>::operator=(const BasicMatrixView& other) {
+  return *this = static_cast<const expr::MatrixExpression<BasicMatrixView>&>(other);
+}
+
+template <typename T>
+BasicVectorView<T> BasicMatrixView<T>::row(size_t index) const {
+  if (index >= m_row_count) {
+    throw std::out_of_range("Row index out of bounds");
+  }
+  return BasicVectorView<T>(m_data + index * m_stride, m_column_count, 1);
+}
+
+template <typename T>
+BasicVectorView<T> BasicMatrixView<T>::column(size_t index) const {
+  if (index >= m_column_count) {
+    throw std::out_of_range("Column index out of bounds");
+  }
+  return BasicVectorView<T>(m_data + index, m_row_count, m_stride);
+}
+
+template <typename T>
+BasicVectorView<T> BasicMatrixView<T>::diagonal() const noexcept {
+  return BasicVectorView<T>(m_data, m_row_count < m_column_count ? m_row_count : m_column_count, m_stride + 1);
+}
+
+template <typename T>
+BasicMatrixView<T> BasicMatrixView<T>::block(size_t first_row, size_t first_column, size_t row_count,
+                                             size_t column_count) const {
+  if (first_row > m_row_count || row_count > m_row_count - first_row ||
+      first_column > m_column_count || column_count > m_column_count - first_column) {
+    throw std::out_of_range("Block out of bounds");
+  }
+  return BasicMatrixView(m_data + first_row * m_stride + first_column, row_count, column_count, m_stride);
+}
+
+template class BasicConstVectorView<float>;
+template class BasicConstVectorView<double>;
+template class BasicVectorView<float>;
+template class BasicVectorView<double>;
+template class BasicConstMatrixView<float>;
+template class BasicConstMatrixView<double>;
+template class BasicMatrixView<float>;
+template class BasicMatrixView<double>;
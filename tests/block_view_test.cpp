@@ -0,0 +1,87 @@
+// Assigning element-wise expressions into a block of a wider matrix must leave every cell outside
+// the block alone, also when the block shares the padded stride of its operands.
+#include "../include/matrix.h"
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // Fills A with a sentinel, assigns into A.block(first_row, first_column, B's shape) and checks
+    // that the block holds 'expected' and that the rest still holds the sentinel.
+    template <typename Assign, typename Expected>
+    void check_block(const char *what, size_t first_row, size_t first_column, size_t rows, size_t columns,
+                     Assign &&assign, Expected &&expected)
+    {
+        const double sentinel = -7.0;
+        MATRIX A(first_row + rows + 2, first_column + columns + 2, sentinel);
+        assign(A.block(first_row, first_column, rows, columns));
+
+        bool inside = true, outside = true;
+        for (size_t i = 0; i < A.getRowCount(); i++)
+        {
+            for (size_t j = 0; j < A.getColumnCount(); j++)
+            {
+                const bool in_block = i >= first_row && i < first_row + rows && j >= first_column &&
+                                      j < first_column + columns;
+                if (in_block)
+                {
+                    inside = inside && A(i, j) == expected(i - first_row, j - first_column);
+                }
+                else
+                {
+                    outside = outside && A(i, j) == sentinel;
+                }
+            }
+        }
+        std::string message(what);
+        check(inside, (message + ": block holds the result").c_str());
+        check(outside, (message + ": cells outside the block unchanged").c_str());
+    }
+}
+
+int main()
+{
+    // Blocks of 10 columns in a 12-column matrix share its padded stride, the case where the
+    // whole-buffer kernels used to run past the block; 3 columns give a narrower stride.
+    for (size_t columns : {3, 10})
+    {
+        const size_t rows = 4;
+        MATRIX B(rows, columns), C(rows, columns);
+        for (size_t i = 0; i < rows; i++)
+        {
+            for (size_t j = 0; j < columns; j++)
+            {
+                B(i, j) = double(i * columns + j);
+                C(i, j) = 0.5 * double(j) - double(i);
+            }
+        }
+        const double s = 3.0;
+
+        check_block("A.block(...) = B + C", 1, 0, rows, columns,
+                    [&](MatrixView block) { block = B + C; },
+                    [&](size_t i, size_t j) { return B(i, j) + C(i, j); });
+        check_block("A.block(...) = B * s", 1, 0, rows, columns,
+                    [&](MatrixView block) { block = B * s; },
+                    [&](size_t i, size_t j) { return B(i, j) * s; });
+        check_block("A.block(...) = B + C * s", 2, 1, rows, columns,
+                    [&](MatrixView block) { block = B + C * s; },
+                    [&](size_t i, size_t j) { return B(i, j) + C(i, j) * s; });
+    }
+
+    if (failures == 0)
+    {
+        std::printf("block_view_test: all checks passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Every dispatched GEMM micro-kernel must match a plain triple loop, on full tiles and on the
+// partial tiles at the edges of C, for both operand orientations and with the pool split.
+#include "../include/blas.h"
+#include "../include/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // Largest error of one gemm or parallel_gemm call against the reference, relative to k. The
+    // padding columns of C past n must come back untouched.
+    template <typename T>
+    double gemm_error(blas::Op op_a, blas::Op op_b, size_t m, size_t n, size_t k, bool split)
+    {
+        std::mt19937 engine(static_cast<unsigned>(m * 131 + n * 7 + k));
+        std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+        const size_t lda = (op_a == blas::Op::none ? k : m) + 3;
+        const size_t ldb = (op_b == blas::Op::none ? n : k) + 1;
+        const size_t ldc = n + 5;
+        std::vector<T> A((op_a == blas::Op::none ? m : k) * lda), B((op_b == blas::Op::none ? k : n) * ldb), C(m * ldc);
+        for (auto *values : {&A, &B, &C})
+        {
+            for (T &x : *values)
+            {
+                x = static_cast<T>(uniform(engine));
+            }
+        }
+        std::vector<T> expected(C);
+        const T alpha = T(0.75), beta = T(-0.5);
+        for (size_t i = 0; i < m; i++)
+        {
+            for (size_t j = 0; j < n; j++)
+            {
+                double sum = 0.0;
+                for (size_t p = 0; p < k; p++)
+                {
+                    const double a = op_a == blas::Op::none ? A[i * lda + p] : A[p * lda + i];
+                    const double b = op_b == blas::Op::none ? B[p * ldb + j] : B[j * ldb + p];
+                    sum += a * b;
+                }
+                expected[i * ldc + j] = static_cast<T>(alpha * sum + beta * double(expected[i * ldc + j]));
+            }
+        }
+
+        if (split)
+        {
+            blas::parallel_gemm(op_a, op_b, m, n, k, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc);
+        }
+        else
+        {
+            blas::gemm(op_a, op_b, m, n, k, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc);
+        }
+
+        double error = 0.0;
+        for (size_t i = 0; i < m; i++)
+        {
+            for (size_t j = 0; j < ldc; j++)
+            {
+                const double difference = std::fabs(double(C[i * ldc + j]) - double(expected[i * ldc + j]));
+                error = std::max(error, j < n ? difference / double(std::max<size_t>(k, 1)) : difference * 1e30);
+            }
+        }
+        return error;
+    }
+
+    template <typename T>
+    double worst_error(bool split)
+    {
+        double error = 0.0;
+        for (auto op_a : {blas::Op::none, blas::Op::transpose})
+        {
+            for (auto op_b : {blas::Op::none, blas::Op::transpose})
+            {
+                for (size_t m : {1, 7, 45, 200})
+                {
+                    for (size_t n : {1, 9, 33, 130})
+                    {
+                        for (size_t k : {1, 50, 300})
+                        {
+                            error = std::max(error, gemm_error<T>(op_a, op_b, m, n, k, split));
+                        }
+                    }
+                }
+            }
+        }
+        return error;
+    }
+}
+
+int main()
+{
+    for (auto target : {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512})
+    {
+        if (target > simd::detected_isa())
+        {
+            continue;
+        }
+        simd::set_isa(target);
+        for (bool split : {false, true})
+        {
+            check(worst_error<double>(split) < 1e-14, split ? "parallel_gemm<double> matches the reference"
+                                                            : "gemm<double> matches the reference");
+            check(worst_error<float>(split) < 1e-6, split ? "parallel_gemm<float> matches the reference"
+                                                          : "gemm<float> matches the reference");
+        }
+    }
+    simd::set_isa(simd::detected_isa());
+
+    if (failures == 0)
+    {
+        std::printf("gemm_dispatch_test: all checks passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
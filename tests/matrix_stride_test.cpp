@@ -0,0 +1,76 @@
+// MATRIX pads rows to whole cache lines only once a row spans one; narrower matrices are stored
+// tight, so an n x 1 column takes n elements rather than n lines.
+#include "../include/matrix.h"
+#include "../include/binary_io.h"
+#include <cstdio>
+#include <memory_resource>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+
+    // Forwards to the default resource and records the bytes requested.
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocated = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            allocated += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+int main()
+{
+    const size_t n = 1000;
+    {
+        CountingResource counting;
+        MATRIX column(n, 1, 1.0, &counting);
+        check(column.stride() == 1, "an n x 1 matrix has stride 1");
+        check(counting.allocated == n * sizeof(double), "an n x 1 matrix allocates n doubles");
+    }
+    {
+        CountingResource counting;
+        BasicMatrix<float> column(n, 3, 1.0f, &counting);
+        check(column.stride() == 3, "an n x 3 float matrix has stride 3");
+        check(counting.allocated == n * 3 * sizeof(float), "an n x 3 float matrix allocates 3n floats");
+    }
+
+    // From one cache line of row on, rows are padded to whole lines
+    check(MATRIX(2, 8).stride() == 8, "8 doubles fill one line");
+    check(MATRIX(2, 9).stride() == 16, "9 doubles take two lines");
+    check(BasicMatrix<float>(2, 17).stride() == 32, "17 floats take two lines");
+
+    // The binary format follows the same rule, so MATRIX(path) can adopt the mapped rows
+    check(binary::make_header(n, 1).stride == 1, "a saved n x 1 matrix has stride 1");
+    check(binary::make_header(n, 9).stride == 16, "a saved n x 9 matrix has stride 16");
+
+    if (failures == 0)
+    {
+        std::printf("matrix_stride_test: all checks passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// parallel_for chunks run under the caller's policy, memory resource and instrumented kernel on
+// every thread, a caller waiting for its chunks never runs those of another call, and the pool can be
+// rebuilt while calls are running on it.
+#include "../include/arena.h"
+#include "../include/instrument.h"
+#include "../include/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "FAILED: %s\n", what);
+            failures++;
+        }
+    }
+}
+
+int main()
+{
+    parallel::set_thread_count(4);
+
+    {
+        memory::Arena arena;
+        memory::ScopedArena scope(arena);
+        parallel::ScopedPolicy policy(parallel::Policy::parallel);
+        const instrument::Kernel previous = instrument::enter(instrument::Kernel::gemm);
+
+        std::atomic<bool> same_policy{true}, same_resource{true}, same_kernel{true};
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        std::vector<std::pmr::vector<double>> blocks(64);
+        parallel::parallel_for(blocks.size(), 1, [&](size_t begin, size_t end) {
+            same_policy = same_policy && parallel::policy() == parallel::Policy::parallel;
+            same_resource = same_resource && memory::current_resource() == &arena;
+            same_kernel = same_kernel && instrument::current() == instrument::Kernel::gemm;
+            for (size_t b = begin; b < end; b++)
+            {
+                // Allocations from several threads into the caller's arena at once
+                blocks[b] = std::pmr::vector<double>(1000, double(b), memory::current_resource());
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        });
+        instrument::leave(previous);
+
+        check(same_policy, "chunks run under the caller's policy");
+        check(same_resource, "chunks allocate from the caller's memory resource");
+        check(same_kernel, "chunks run under the caller's instrumented kernel");
+        bool intact = true;
+        for (size_t b = 0; b < blocks.size(); b++)
+        {
+            for (double x : blocks[b])
+            {
+                intact = intact && x == double(b);
+            }
+        }
+        check(intact, "blocks allocated concurrently from one arena do not overlap");
+        check(threads.size() > 1, "the chunks are spread over the pool");
+    }
+
+    // Two callers at once under different kernels: every chunk, wherever it runs, sees its own call's
+    std::atomic<bool> own_chunks{true};
+    std::vector<std::thread> callers;
+    for (instrument::Kernel kernel : {instrument::Kernel::gemm, instrument::Kernel::lu})
+    {
+        callers.emplace_back([&own_chunks, kernel] {
+            for (int round = 0; round < 200; round++)
+            {
+                const instrument::Kernel previous = instrument::enter(kernel);
+                parallel::parallel_for(32, 1, [&](size_t, size_t) {
+                    own_chunks = own_chunks && instrument::current() == kernel;
+                    std::this_thread::yield();
+                });
+                instrument::leave(previous);
+            }
+        });
+    }
+    for (auto &thread : callers)
+    {
+        thread.join();
+    }
+    check(own_chunks, "concurrent callers only run their own chunks");
+
+    // Resizing and re-pinning the pool while calls run on it: those calls finish on the old workers
+    std::atomic<bool> running{true};
+    std::atomic<size_t> iterations{0};
+    std::thread caller([&] {
+        while (running)
+        {
+            parallel::parallel_for(64, 1, [&](size_t begin, size_t end) { iterations += end - begin; });
+        }
+    });
+    for (int round = 0; round < 50; round++)
+    {
+        parallel::set_thread_count(2 + round % 3);
+        parallel::set_pinning(round % 2 == 0);
+    }
+    running = false;
+    caller.join();
+    parallel::set_pinning(false);
+    parallel::set_thread_count(0);
+    check(iterations % 64 == 0, "every call in flight during a rebuild ran all of its chunks");
+
+    if (failures == 0)
+    {
+        std::printf("parallel_context_test: all checks passed\n");
+    }
+    return failures == 0 ? 0 : 1;
+}